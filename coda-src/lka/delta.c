@@ -0,0 +1,528 @@
+/* BLURB gpl
+
+                           Coda File System
+                              Release 8
+
+          Copyright (c) 2026 Carnegie Mellon University
+                  Additional copyrights listed below
+
+This  code  is  distributed "AS IS" without warranty of any kind under
+the terms of the GNU General Public Licence Version 2, as shown in the
+file  LICENSE.  The  technical and financial  contributors to Coda are
+listed in the file CREDITS.
+
+                        Additional copyrights
+                           none currently
+
+#*/
+
+/*
+ * Rolling checksum deltas
+ *
+ * Before a client modifies a large file it remembers a signature of the
+ * copy the servers have, a weak rolling checksum and the leading bytes of
+ * the SHA1 of every block. When the file is stored the new contents are
+ * described against that signature in the style of rsync, blocks that are
+ * found anywhere in the new file are copied from the old one and everything
+ * else is sent literally.
+ *
+ * A delta starts with a header
+ *
+ *   magic         DELTA_MAGIC
+ *   blocksize     size of the blocks of the old file
+ *   length        length of the new file, high word first
+ *   sha           SHA1 of the new file
+ *
+ * followed by a series of operations
+ *
+ *   DELTA_COPY block count    copy count blocks of the old file
+ *   DELTA_DATA len bytes      len literal bytes
+ *   DELTA_END
+ *
+ * All words are 32 bits in network byte order. The SHA1 covers the whole
+ * result, so a delta applied to anything but the file it was made against
+ * is rejected.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <netinet/in.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "coda_string.h"
+#include <lwp/lwp.h>
+
+#include "lka.h"
+
+#define DELTA_MAGIC 0x43444c31 /* "CDL1" */
+#define DELTA_END 0
+#define DELTA_COPY 1
+#define DELTA_DATA 2
+#define DELTA_HDRLEN (4 * sizeof(uint32_t) + SHA_DIGEST_LENGTH)
+
+#define DELTA_MINBLOCK (4 * 1024)
+#define DELTA_MAXBLOCK (128 * 1024)
+#define DELTA_STRONG 8 /* bytes of the SHA1 kept per block */
+#define DELTA_YIELD_INTERVAL (1024 * 1024) /* bytes between yields */
+
+struct delta_block {
+    uint32_t weak;
+    unsigned char strong[DELTA_STRONG];
+    int32_t next; /* next block in the same bucket, -1 ends the chain */
+};
+
+struct delta_sig {
+    uint64_t length; /* of the file the signature describes */
+    uint32_t blocksize;
+    uint32_t nblocks;
+    int hashbits;
+    int32_t *buckets;
+    struct delta_block *blocks;
+};
+
+/* delta under construction */
+struct delta_out {
+    char *buf;
+    size_t len, size, max;
+    uint32_t copy_first, copy_count; /* pending run of copied blocks */
+};
+
+/* rsync style checksum, a is the sum of the bytes and b the sum of the
+   running sums, both modulo 2^16 */
+static void weak_init(const unsigned char *p, uint32_t len, uint32_t *a,
+                      uint32_t *b)
+{
+    uint32_t i, s1 = 0, s2 = 0;
+
+    for (i = 0; i < len; i++) {
+        s1 += p[i];
+        s2 += (len - i) * p[i];
+    }
+    *a = s1;
+    *b = s2;
+}
+
+static inline uint32_t weak_sum(uint32_t a, uint32_t b)
+{
+    return (a & 0xffff) | (b << 16);
+}
+
+static void strong_sum(const unsigned char *p, uint32_t len,
+                       unsigned char strong[DELTA_STRONG])
+{
+    unsigned char sha[SHA_DIGEST_LENGTH];
+    SHA_CTX cx;
+
+    SHA1_Init(&cx);
+    SHA1_Update(&cx, p, len);
+    SHA1_Final(sha, &cx);
+    memcpy(strong, sha, DELTA_STRONG);
+}
+
+static inline uint32_t bucket(struct delta_sig *sig, uint32_t weak)
+{
+    return ((weak ^ (weak >> 16)) * 2654435761U) >> (32 - sig->hashbits);
+}
+
+static inline uint32_t block_len(struct delta_sig *sig, uint32_t blk)
+{
+    uint64_t off = (uint64_t)blk * sig->blocksize;
+
+    if (sig->length - off < sig->blocksize)
+        return (uint32_t)(sig->length - off);
+    return sig->blocksize;
+}
+
+void delta_free(struct delta_sig *sig)
+{
+    if (!sig)
+        return;
+    free(sig->buckets);
+    free(sig->blocks);
+    free(sig);
+}
+
+/* Compute the signature of the file open on fd, returns NULL if it is too
+   small to bother or when the file cannot be read */
+struct delta_sig *delta_signature(int fd)
+{
+    struct delta_sig *sig;
+    struct stat st;
+    unsigned char *buf = NULL;
+    uint32_t i, len, a, b, h;
+    size_t done = 0;
+
+    if (fstat(fd, &st) < 0 || st.st_size < DELTA_MINSIZE)
+        return NULL;
+
+    sig = calloc(1, sizeof(*sig));
+    if (!sig)
+        return NULL;
+
+    /* blocks of about the square root of the file size keep both the
+       signature and the literal parts of the delta small */
+    sig->length    = st.st_size;
+    sig->blocksize = DELTA_MINBLOCK;
+    while (sig->blocksize < DELTA_MAXBLOCK &&
+           (uint64_t)sig->blocksize * sig->blocksize < sig->length)
+        sig->blocksize <<= 1;
+
+    if ((sig->length + sig->blocksize - 1) / sig->blocksize >= INT32_MAX)
+        goto err;
+    sig->nblocks = (sig->length + sig->blocksize - 1) / sig->blocksize;
+
+    for (sig->hashbits = 8; (1U << sig->hashbits) < sig->nblocks;)
+        sig->hashbits++;
+
+    sig->buckets = malloc(sizeof(int32_t) << sig->hashbits);
+    sig->blocks  = malloc(sig->nblocks * sizeof(struct delta_block));
+    buf          = malloc(sig->blocksize);
+    if (!sig->buckets || !sig->blocks || !buf)
+        goto err;
+    memset(sig->buckets, 0xff, sizeof(int32_t) << sig->hashbits);
+
+    /* Checksumming only touches local state, keep the other LWPs going */
+    PRE_Concurrent(1);
+    for (i = 0; i < sig->nblocks; i++) {
+        len = block_len(sig, i);
+        if (pread(fd, buf, len, (off_t)i * sig->blocksize) != (ssize_t)len)
+            break;
+
+        weak_init(buf, len, &a, &b);
+        sig->blocks[i].weak = weak_sum(a, b);
+        strong_sum(buf, len, sig->blocks[i].strong);
+
+        h                   = bucket(sig, sig->blocks[i].weak);
+        sig->blocks[i].next = sig->buckets[h];
+        sig->buckets[h]     = i;
+
+        done += len;
+        if (done >= DELTA_YIELD_INTERVAL) {
+            LWP_DispatchProcess();
+            done = 0;
+        }
+    }
+    PRE_Concurrent(0);
+
+    if (i == sig->nblocks) {
+        free(buf);
+        return sig;
+    }
+err:
+    free(buf);
+    delta_free(sig);
+    return NULL;
+}
+
+static int out_put(struct delta_out *o, const void *p, size_t len)
+{
+    char *nbuf;
+    size_t nsize;
+
+    if (len > o->max - o->len)
+        return -1;
+
+    if (o->len + len > o->size) {
+        nsize = o->size ? o->size : 64 * 1024;
+        while (nsize < o->len + len)
+            nsize *= 2;
+        if (nsize > o->max)
+            nsize = o->max;
+
+        nbuf = realloc(o->buf, nsize);
+        if (!nbuf)
+            return -1;
+        o->buf  = nbuf;
+        o->size = nsize;
+    }
+    memcpy(o->buf + o->len, p, len);
+    o->len += len;
+    return 0;
+}
+
+static int out_word(struct delta_out *o, uint32_t w)
+{
+    w = htonl(w);
+    return out_put(o, &w, sizeof(w));
+}
+
+static int out_flush_copy(struct delta_out *o)
+{
+    if (!o->copy_count)
+        return 0;
+    if (out_word(o, DELTA_COPY) || out_word(o, o->copy_first) ||
+        out_word(o, o->copy_count))
+        return -1;
+    o->copy_count = 0;
+    return 0;
+}
+
+static int out_copy(struct delta_out *o, uint32_t blk)
+{
+    if (o->copy_count && o->copy_first + o->copy_count == blk) {
+        o->copy_count++;
+        return 0;
+    }
+    if (out_flush_copy(o))
+        return -1;
+    o->copy_first = blk;
+    o->copy_count = 1;
+    return 0;
+}
+
+static int out_data(struct delta_out *o, const unsigned char *p, size_t len)
+{
+    if (!len)
+        return 0;
+    if (out_flush_copy(o) || out_word(o, DELTA_DATA) ||
+        out_word(o, (uint32_t)len) || out_put(o, p, len))
+        return -1;
+    return 0;
+}
+
+/* Describe the file open on fd relative to the file of the signature. The
+   delta is returned in a malloced buffer, returns -1 when it would grow
+   beyond maxlen bytes or the file cannot be read */
+int delta_encode(struct delta_sig *sig, int fd, char **delta, size_t *len,
+                 size_t maxlen)
+{
+    struct delta_out out;
+    unsigned char *buf, strong[DELTA_STRONG], sha[SHA_DIGEST_LENGTH];
+    uint32_t bs = sig->blocksize, n = 0, a = 0, b = 0, weak, x;
+    size_t size = 8 * (size_t)bs, start = 0, pos = 0, end = 0;
+    uint64_t length = 0;
+    int32_t blk;
+    int eof = 0, rc = -1, have_strong;
+    uint32_t hdr[4];
+    ssize_t r;
+    SHA_CTX cx;
+
+    memset(&out, 0, sizeof(out));
+    out.max = maxlen;
+
+    buf = malloc(size);
+    if (!buf)
+        return -1;
+
+    SHA1_Init(&cx);
+    PRE_Concurrent(1);
+
+    /* the header is filled in once the whole file has been seen */
+    memset(sha, 0, sizeof(sha));
+    if (out_put(&out, sha, DELTA_HDRLEN))
+        goto err;
+
+    for (;;) {
+        /* keep more than a block after the window so that it can roll,
+           pending literals are flushed before they are moved out */
+        if (!eof && end - pos <= bs) {
+            if (out_data(&out, buf + start, pos - start))
+                goto err;
+
+            memmove(buf, buf + pos, end - pos);
+            end -= pos;
+            start = pos = 0;
+            while (end < size) {
+                r = read(fd, buf + end, size - end);
+                if (r < 0)
+                    goto err;
+                if (r == 0) {
+                    eof = 1;
+                    break;
+                }
+                SHA1_Update(&cx, buf + end, r);
+                end += r;
+                length += r;
+            }
+            n = 0;
+            LWP_DispatchProcess();
+        }
+        if (pos >= end)
+            break;
+
+        if (n == 0) {
+            n = (end - pos < bs) ? end - pos : bs;
+            weak_init(buf + pos, n, &a, &b);
+        }
+        weak = weak_sum(a, b);
+
+        have_strong = 0;
+        for (blk = sig->buckets[bucket(sig, weak)]; blk != -1;
+             blk = sig->blocks[blk].next) {
+            if (sig->blocks[blk].weak != weak || block_len(sig, blk) != n)
+                continue;
+            if (!have_strong) {
+                strong_sum(buf + pos, n, strong);
+                have_strong = 1;
+            }
+            if (memcmp(strong, sig->blocks[blk].strong, DELTA_STRONG) == 0)
+                break;
+        }
+
+        if (blk != -1) {
+            if (out_data(&out, buf + start, pos - start) || out_copy(&out, blk))
+                goto err;
+            pos += n;
+            start = pos;
+            n     = 0;
+            continue;
+        }
+
+        /* slide the window a byte, it only shrinks at the end of the file */
+        x = buf[pos];
+        if (pos + n < end) {
+            a = a - x + buf[pos + n];
+            b = b - n * x + a;
+        } else {
+            a -= x;
+            b -= n * x;
+            n--;
+        }
+        pos++;
+    }
+
+    if (out_data(&out, buf + start, pos - start) || out_flush_copy(&out) ||
+        out_word(&out, DELTA_END))
+        goto err;
+
+    SHA1_Final(sha, &cx);
+    hdr[0] = htonl(DELTA_MAGIC);
+    hdr[1] = htonl(bs);
+    hdr[2] = htonl((uint32_t)(length >> 32));
+    hdr[3] = htonl((uint32_t)length);
+    memcpy(out.buf, hdr, sizeof(hdr));
+    memcpy(out.buf + sizeof(hdr), sha, SHA_DIGEST_LENGTH);
+
+    *delta = out.buf;
+    *len   = out.len;
+    rc     = 0;
+err:
+    PRE_Concurrent(0);
+    free(buf);
+    if (rc)
+        free(out.buf);
+    return rc;
+}
+
+static int read_full(int fd, void *p, size_t len)
+{
+    ssize_t r;
+
+    for (; len; len -= r, p = (char *)p + r) {
+        r = read(fd, p, len);
+        if (r <= 0)
+            return -1;
+    }
+    return 0;
+}
+
+static int write_full(int fd, const void *p, size_t len)
+{
+    ssize_t r;
+
+    for (; len; len -= r, p = (const char *)p + r) {
+        r = write(fd, p, len);
+        if (r <= 0)
+            return -1;
+    }
+    return 0;
+}
+
+static int read_word(int fd, uint32_t *w)
+{
+    if (read_full(fd, w, sizeof(*w)))
+        return -1;
+    *w = ntohl(*w);
+    return 0;
+}
+
+/* Rebuild a file from the old contents open on basefd and the delta read
+   from deltafd, writing it to outfd. Returns 0 and the length of the result
+   if the result matches the SHA1 the delta was made with */
+int delta_apply(int basefd, int deltafd, int outfd, uint64_t *length)
+{
+    unsigned char *buf = NULL, sha[SHA_DIGEST_LENGTH], want[SHA_DIGEST_LENGTH];
+    uint32_t hdr[4], op, arg, count, len;
+    uint64_t total = 0, off;
+    size_t done = 0;
+    struct stat st;
+    int rc = -1;
+    SHA_CTX cx;
+
+    if (read_full(deltafd, hdr, sizeof(hdr)) ||
+        read_full(deltafd, want, SHA_DIGEST_LENGTH) ||
+        ntohl(hdr[0]) != DELTA_MAGIC || ntohl(hdr[1]) < DELTA_MINBLOCK ||
+        ntohl(hdr[1]) > DELTA_MAXBLOCK || fstat(basefd, &st) < 0)
+        return -1;
+
+    buf = malloc(DELTA_MAXBLOCK);
+    if (!buf)
+        return -1;
+
+    SHA1_Init(&cx);
+    PRE_Concurrent(1);
+    for (;;) {
+        if (read_word(deltafd, &op))
+            goto err;
+        if (op == DELTA_END)
+            break;
+        if (read_word(deltafd, &arg))
+            goto err;
+
+        switch (op) {
+        case DELTA_COPY:
+            if (read_word(deltafd, &count))
+                goto err;
+            for (off = (uint64_t)arg * ntohl(hdr[1]); count; count--) {
+                if (off >= (uint64_t)st.st_size)
+                    goto err;
+                len = ntohl(hdr[1]);
+                if ((uint64_t)st.st_size - off < len)
+                    len = (uint32_t)(st.st_size - off);
+                if (pread(basefd, buf, len, off) != (ssize_t)len ||
+                    write_full(outfd, buf, len))
+                    goto err;
+                SHA1_Update(&cx, buf, len);
+                off += len;
+                total += len;
+                done += len;
+            }
+            break;
+
+        case DELTA_DATA:
+            for (; arg; arg -= len) {
+                len = (arg < DELTA_MAXBLOCK) ? arg : DELTA_MAXBLOCK;
+                if (read_full(deltafd, buf, len) || write_full(outfd, buf, len))
+                    goto err;
+                SHA1_Update(&cx, buf, len);
+                total += len;
+                done += len;
+            }
+            break;
+
+        default:
+            goto err;
+        }
+
+        if (done >= DELTA_YIELD_INTERVAL) {
+            LWP_DispatchProcess();
+            done = 0;
+        }
+    }
+
+    SHA1_Final(sha, &cx);
+    if (total == (((uint64_t)ntohl(hdr[2]) << 32) | ntohl(hdr[3])) &&
+        memcmp(sha, want, SHA_DIGEST_LENGTH) == 0) {
+        *length = total;
+        rc      = 0;
+    }
+err:
+    PRE_Concurrent(0);
+    free(buf);
+    return rc;
+}
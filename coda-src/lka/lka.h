@@ -21,6 +21,10 @@ listed in the file CREDITS.
 
 #include <coda_hash.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /* "helper" routines in shaprocs.cc */
 void ViceSHAtoHex(unsigned char sha[SHA_DIGEST_LENGTH], char *buf, int buflen);
 int CopyAndComputeViceSHA(int infd, int outfd,
@@ -35,4 +39,18 @@ int LookAsideAndFillContainer(unsigned char sha[SHA_DIGEST_LENGTH], int cfd,
                               int emsglen);
 int LKParseAndExecute(char *in, char *out, int len);
 
+/* rolling checksum deltas in delta.c */
+#define DELTA_MINSIZE (1024 * 1024) /* smaller files are always sent whole */
+
+struct delta_sig;
+struct delta_sig *delta_signature(int fd);
+void delta_free(struct delta_sig *sig);
+int delta_encode(struct delta_sig *sig, int fd, char **delta, size_t *len,
+                 size_t maxlen);
+int delta_apply(int basefd, int deltafd, int outfd, uint64_t *length);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif /*_LKA_H_INCLUDED_ */
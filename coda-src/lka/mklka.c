@@ -45,12 +45,14 @@ char *TreeRoot = NULL; /* pathname of root of tree to be walked and hashed */
 static int SetDescriptor(struct rwcdb *dbh);
 static int WalkTree(char *troot, char *prefix, struct rwcdb *dbh);
 
-/* dummy function for ComputeViceSHA */
+/* dummy functions for ComputeViceSHA */
 int LWP_DispatchProcess(void)
 {
     return 0;
 }
 
+void PRE_Concurrent(int on) {}
+
 int main(int argc, char **argv)
 {
     struct rwcdb dbh; /* database handle */
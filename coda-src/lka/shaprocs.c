@@ -21,6 +21,8 @@ listed in the file CREDITS.
 #include <config.h>
 #endif
 
+#include <sys/types.h>
+#include <sys/stat.h>
 #include <stdio.h>
 #include <ctype.h>
 #include <errno.h>
@@ -33,6 +35,7 @@ listed in the file CREDITS.
 #include "lka.h"
 
 #define SHA_YIELD_INTERVAL 200
+#define SHA_CONCURRENT_MIN (256 * 1024) /* hash larger files concurrently */
 
 /* "Helper" functions for SHA */
 
@@ -62,12 +65,18 @@ int CopyAndComputeViceSHA(int infd, int outfd,
        Returns 0 on success, and -1 on any kind of failure  */
 
     int bytes_out, bytes_in = 0;
-    int i = 0;
+    int i = 0, rc = 0;
+    struct stat st;
     SHA_CTX cx;
 
 #define SHACHUNKSIZE 4096 /* might be better to set to fs block size? */
     unsigned char shachunk[SHACHUNKSIZE];
 
+    /* Hashing and copying only touch local state, so larger files are
+       handled on a worker thread while the other LWPs keep running. */
+    if (fstat(infd, &st) == 0 && st.st_size >= SHA_CONCURRENT_MIN)
+        PRE_Concurrent(1);
+
     SHA1_Init(&cx);
     while (1) {
         /* make sure we yield to other threads once in a while */
@@ -82,12 +91,19 @@ int CopyAndComputeViceSHA(int infd, int outfd,
 
         if (outfd != -1) {
             bytes_out = write(outfd, shachunk, bytes_in);
-            if (bytes_out < bytes_in)
-                return -1;
+            if (bytes_out < bytes_in) {
+                rc = -1;
+                break;
+            }
         }
     }
-    SHA1_Final(sha, &cx);
-    return (bytes_in < 0 ? -1 : 0);
+    PRE_Concurrent(0);
+
+    if (rc == 0) {
+        SHA1_Final(sha, &cx);
+        rc = (bytes_in < 0 ? -1 : 0);
+    }
+    return rc;
 }
 
 int IsZeroSHA(unsigned char sha[SHA_DIGEST_LENGTH])
@@ -34,12 +34,14 @@ listed in the file CREDITS.
 char em[4096];
 int emlen = sizeof(em);
 
-/* dummy function for ComputeViceSHA */
+/* dummy functions for ComputeViceSHA */
 int LWP_DispatchProcess(void)
 {
     return 0;
 }
 
+void PRE_Concurrent(int on) {}
+
 int main(int argc, char **argv)
 {
     int rc, fd, cfd;
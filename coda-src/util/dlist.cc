@@ -156,6 +156,20 @@ void dlist::append(dlink *p)
     cnt++;
 }
 
+/* add p following entry after, which must be on the dlist */
+void dlist::insert_after(dlink *p, dlink *after)
+{
+    if ((p->next != 0) || (p->prev != 0))
+        abort();
+
+    p->next           = after->next;
+    p->prev           = after;
+    after->next->prev = p;
+    after->next       = p;
+
+    cnt++;
+}
+
 dlink *dlist::remove(dlink *p)
 {
     if (head == 0)
@@ -191,6 +205,14 @@ dlink *dlist::last()
     return (head == 0 ? 0 : head->prev);
 }
 
+dlink *dlist::succ(dlink *p, DlIterOrder order)
+{
+    if (order == DlAscending)
+        return (p->next == head ? 0 : p->next);
+
+    return (p == head ? 0 : p->prev);
+}
+
 dlink *dlist::get(DlGetType type)
 {
     if (head == 0)
@@ -47,6 +47,12 @@ enum DlGetType
     DlGetMax
 };
 
+enum DlIterOrder
+{
+    DlAscending,
+    DlDescending
+};
+
 class dlist {
     friend class dhashtab;
     dlink *head; // head of list
@@ -59,9 +65,12 @@ public:
     void insert(dlink *); // insert in sorted order
     void prepend(dlink *); // add at beginning of list
     void append(dlink *); // add at end of list
+    void insert_after(dlink *, dlink *); // add following specified entry
     dlink *remove(dlink *); // remove specified entry
     dlink *first(); // return head of list
     dlink *last(); // return tail of list
+    dlink *succ(dlink *, DlIterOrder = DlAscending); // return entry following
+        // specified one in the given order or 0
     dlink *get(DlGetType = DlGetMin); // return and remove head or tail of list
     void clear(); // remove all entries
     int count();
@@ -71,12 +80,6 @@ public:
     virtual void print(int);
 };
 
-enum DlIterOrder
-{
-    DlAscending,
-    DlDescending
-};
-
 class dlist_iterator {
     dlist *cdlist; // current dlist
     dlink *cdlink; // current dlink
@@ -30,6 +30,7 @@ extern "C" {
 #include <stdlib.h>
 #include <setjmp.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <rvmlib.h>
 
@@ -59,9 +60,9 @@ void rec_ohashtab::operator delete(void *deadobj)
     rvmlib_rec_free(deadobj);
 }
 
-rec_ohashtab::rec_ohashtab(int hashtabsize, RHFN hashfn)
+rec_ohashtab::rec_ohashtab(int hashtabsize, RHFN hashfn, RLHFN entryhashfn)
 {
-    rec_ohashtab::Init(hashtabsize, hashfn);
+    rec_ohashtab::Init(hashtabsize, hashfn, entryhashfn);
 }
 
 rec_ohashtab::~rec_ohashtab()
@@ -69,28 +70,36 @@ rec_ohashtab::~rec_ohashtab()
     DeInit();
 }
 
-void rec_ohashtab::Init(int hashtabsize, RHFN hashfn)
+void rec_ohashtab::Init(int hashtabsize, RHFN hashfn, RLHFN entryhashfn)
 {
     RVMLIB_REC_OBJECT(*this);
 
     /* Ensure that hashtabsize is a power of 2 so that we can use "AND" for modulus division. */
     if (hashtabsize <= 0)
         abort();
-    for (sz = 1; sz < hashtabsize; sz *= 2)
+    for (segshift = 0; (1 << segshift) < hashtabsize; segshift++)
         ;
+    sz = 1 << segshift;
     if (sz != hashtabsize)
         abort();
+    level = sz;
+    split = 0;
 
-    /* Allocate and initialize the array. */
+    /* Allocate and initialize the first segment. */
     /* N.B. Normal vector construction won't work because RECOVERABLE vector must be allocated! */
     {
-        a = (rec_olist *)rvmlib_rec_malloc(sz * sizeof(rec_olist));
+        nsegs = 4;
+        segs  = (rec_olist **)rvmlib_rec_malloc(nsegs * sizeof(rec_olist *));
+        rvmlib_set_range(segs, nsegs * sizeof(rec_olist *));
+        memset(segs, 0, nsegs * sizeof(rec_olist *));
 
+        segs[0] = (rec_olist *)rvmlib_rec_malloc(sz * sizeof(rec_olist));
         for (int bucket = 0; bucket < sz; bucket++)
-            a[bucket].Init();
+            segs[0][bucket].Init();
     }
-    /* Store the hash function. */
-    hfn = hashfn;
+    /* Store the hash functions. */
+    hfn  = hashfn;
+    lhfn = entryhashfn;
 
     cnt = 0;
 }
@@ -99,12 +108,15 @@ void rec_ohashtab::DeInit()
 {
     RVMLIB_REC_OBJECT(*this);
 
-    /* Free up array. */
+    /* Free up the segments. */
     {
         for (int bucket = 0; bucket < sz; bucket++)
-            a[bucket].DeInit();
+            chain(bucket)->DeInit();
 
-        rvmlib_rec_free(a);
+        for (int seg = 0; seg < nsegs; seg++)
+            if (segs[seg])
+                rvmlib_rec_free(segs[seg]);
+        rvmlib_rec_free(segs);
     }
 }
 
@@ -120,34 +132,95 @@ int rec_ohashtab::operator=(rec_ohashtab &ht)
 }
 
 /* The hash function is not necessarily recoverable, so don't insist on an enclosing transaction! */
-void rec_ohashtab::SetHFn(RHFN hashfn) TRANSACTION_OPTIONAL
+void rec_ohashtab::SetHFn(RHFN hashfn, RLHFN entryhashfn) TRANSACTION_OPTIONAL
 {
     if (rvmlib_thread_data()->tid != 0)
         RVMLIB_REC_OBJECT(*this);
-    hfn = hashfn;
+    hfn  = hashfn;
+    lhfn = entryhashfn;
+}
+
+/* Active iterators are kept in volatile memory, a count in the table would
+ * be logged with it and could be rolled back by an aborted transaction. */
+static rec_ohashtab_iterator *live_iterators = NULL;
+
+/* returns the bucket number for hash value h */
+static inline int hashbucket(unsigned int h, int level, int split)
+{
+    int bucket = h & (level - 1);
+    if (bucket < split)
+        bucket = h & (2 * level - 1);
+    return (bucket);
+}
+
+/* Split the next bucket if the chains got too long. */
+void rec_ohashtab::grow()
+{
+    if (!lhfn || cnt / REC_OHASH_LOAD <= sz)
+        return;
+    for (rec_ohashtab_iterator *i = live_iterators; i; i = i->nextlive)
+        if (i->chashtab == this)
+            return;
+
+    /* Make room for the new bucket. */
+    int seg = sz >> segshift;
+    if (seg == nsegs) {
+        rec_olist **newsegs =
+            (rec_olist **)rvmlib_rec_malloc(2 * nsegs * sizeof(rec_olist *));
+        rvmlib_set_range(newsegs, 2 * nsegs * sizeof(rec_olist *));
+        memcpy(newsegs, segs, nsegs * sizeof(rec_olist *));
+        memset(newsegs + nsegs, 0, nsegs * sizeof(rec_olist *));
+        rvmlib_rec_free(segs);
+        segs = newsegs;
+        nsegs *= 2;
+    }
+    if (!segs[seg]) {
+        int segsize = 1 << segshift;
+        RVMLIB_REC_OBJECT(segs[seg]);
+        segs[seg] = (rec_olist *)rvmlib_rec_malloc(segsize * sizeof(rec_olist));
+        for (int bucket = 0; bucket < segsize; bucket++)
+            segs[seg][bucket].Init();
+    }
+
+    /* The entries of the split bucket either stay or move to the new one. */
+    rec_olist *from = chain(split);
+    rec_olist *to   = chain(sz);
+    int oldbucket   = split;
+    sz++;
+    if (++split == level) {
+        level *= 2;
+        split = 0;
+    }
+
+    for (int n = from->count(); n > 0; n--) {
+        rec_olink *p = from->get();
+        if (hashbucket(lhfn(p), level, split) == oldbucket)
+            from->append(p);
+        else
+            to->append(p);
+    }
 }
 
 void rec_ohashtab::insert(void *key, rec_olink *p)
 {
     RVMLIB_REC_OBJECT(*this);
-    int bucket = hfn(key) & (sz - 1);
-    a[bucket].insert(p);
+    chain(bucket(key))->insert(p);
     cnt++;
+    grow();
 }
 
 void rec_ohashtab::append(void *key, rec_olink *p)
 {
     RVMLIB_REC_OBJECT(*this);
-    int bucket = hfn(key) & (sz - 1);
-    a[bucket].append(p);
+    chain(bucket(key))->append(p);
     cnt++;
+    grow();
 }
 
 rec_olink *rec_ohashtab::remove(void *key, rec_olink *p)
 {
     RVMLIB_REC_OBJECT(*this);
-    int bucket = hfn(key) & (sz - 1);
-    return (cnt--, a[bucket].remove(p));
+    return (cnt--, chain(bucket(key))->remove(p));
 }
 
 rec_olink *rec_ohashtab::first()
@@ -156,7 +229,7 @@ rec_olink *rec_ohashtab::first()
         return (0);
 
     for (int i = 0; i < sz; i++) {
-        rec_olink *p = a[i].first();
+        rec_olink *p = chain(i)->first();
         if (p != 0)
             return (p);
     }
@@ -170,7 +243,7 @@ rec_olink *rec_ohashtab::last()
         return (0);
 
     for (int i = sz - 1; i >= 0; i--) {
-        rec_olink *p = a[i].last();
+        rec_olink *p = chain(i)->last();
         if (p != 0)
             return (p);
     }
@@ -181,8 +254,7 @@ rec_olink *rec_ohashtab::last()
 rec_olink *rec_ohashtab::get(void *key)
 {
     RVMLIB_REC_OBJECT(*this);
-    int bucket = hfn(key) & (sz - 1);
-    return (cnt--, a[bucket].get());
+    return (cnt--, chain(bucket(key))->get());
 }
 
 int rec_ohashtab::count()
@@ -192,13 +264,17 @@ int rec_ohashtab::count()
 
 int rec_ohashtab::IsMember(void *key, rec_olink *p)
 {
-    int bucket = hfn(key) & (sz - 1);
-    return (a[bucket].IsMember(p));
+    return (chain(bucket(key))->IsMember(p));
 }
 
 int rec_ohashtab::bucket(const void *key)
 {
-    return (hfn(key) & (sz - 1));
+    return (hashbucket(hfn(key), level, split));
+}
+
+int rec_ohashtab::buckets()
+{
+    return (sz);
 }
 
 void rec_ohashtab::print()
@@ -221,7 +297,7 @@ void rec_ohashtab::print(int fd)
 
     /* then print out all of the rec_olists */
     for (int i = 0; i < sz; i++)
-        a[i].print(fd);
+        chain(i)->print(fd);
 }
 
 rec_ohashtab_iterator::rec_ohashtab_iterator(rec_ohashtab &ht, const void *key)
@@ -229,7 +305,10 @@ rec_ohashtab_iterator::rec_ohashtab_iterator(rec_ohashtab &ht, const void *key)
     chashtab   = &ht;
     allbuckets = (key == (void *)-1);
     cbucket    = (allbuckets ? 0 : chashtab->bucket(key));
-    nextlink   = new rec_olist_iterator(chashtab->a[cbucket]);
+    nextlink   = new rec_olist_iterator(*chashtab->chain(cbucket));
+
+    nextlive       = live_iterators;
+    live_iterators = this;
 }
 
 void rec_ohashtab_iterator::Reset()
@@ -237,11 +316,15 @@ void rec_ohashtab_iterator::Reset()
     if (allbuckets)
         cbucket = 0;
     delete nextlink;
-    nextlink = new rec_olist_iterator(chashtab->a[cbucket]);
+    nextlink = new rec_olist_iterator(*chashtab->chain(cbucket));
 }
 
 rec_ohashtab_iterator::~rec_ohashtab_iterator()
 {
+    rec_ohashtab_iterator **pp;
+    for (pp = &live_iterators; *pp != this; pp = &(*pp)->nextlive)
+        ;
+    *pp = nextlive;
     delete nextlink;
 }
 
@@ -261,6 +344,6 @@ rec_olink *rec_ohashtab_iterator::operator()()
         if (++cbucket >= chashtab->sz)
             return (0);
         delete nextlink;
-        nextlink = new rec_olist_iterator(chashtab->a[cbucket]);
+        nextlink = new rec_olist_iterator(*chashtab->chain(cbucket));
     }
 }
@@ -21,6 +21,13 @@ listed in the file CREDITS.
  *    rec_ohash.h -- Specification of hash-table type where each bucket is a recoverable
  *    singly-linked list (a rec_olist).
  *
+ *    When the table knows how to hash its entries (an RLHFN was given) it
+ *    grows with linear hashing: each insertion that pushes the average
+ *    chain length over REC_OHASH_LOAD splits a single bucket. The split is
+ *    part of the inserting transaction, so a crash never leaves the table
+ *    half resized. Buckets are allocated in segments of the initial size,
+ *    existing buckets never move.
+ *
  */
 
 #ifndef _UTIL_REC_OHASH_H_
@@ -43,25 +50,39 @@ extern "C" {
 class rec_ohashtab;
 class rec_ohashtab_iterator;
 typedef int (*RHFN)(const void *);
+typedef int (*RLHFN)(rec_olink *); /* hash of an entry in the table */
+
+#define REC_OHASH_LOAD 4 /* average chain length that triggers a split */
 
 class rec_ohashtab {
     friend class rec_ohashtab_iterator;
-    int sz; /* size of the array */
-    rec_olist *a; /* array of olists */
+    int sz; /* number of buckets in use */
+    int level; /* buckets at the start of this round of splits */
+    int split; /* next bucket to split */
+    int segshift; /* log2 of the number of buckets in a segment */
+    int nsegs; /* size of the segment array */
+    rec_olist **segs; /* segments of olists */
     RHFN hfn; /* the hash function */
+    RLHFN lhfn; /* hashes entries when splitting, NULL if fixed size */
     int cnt;
 
+    rec_olist *chain(int b)
+    {
+        return (&segs[b >> segshift][b & ((1 << segshift) - 1)]);
+    }
+    void grow() REQUIRES_TRANSACTION;
+
 public:
     void *operator new(size_t) REQUIRES_TRANSACTION;
     void operator delete(void *)REQUIRES_TRANSACTION;
 
-    rec_ohashtab(int, RHFN);
+    rec_ohashtab(int, RHFN, RLHFN = NULL);
     rec_ohashtab(rec_ohashtab &); // not supported!
-    void Init(int, RHFN) REQUIRES_TRANSACTION;
+    void Init(int, RHFN, RLHFN = NULL) REQUIRES_TRANSACTION;
     int operator=(rec_ohashtab &); /* not supported! */
     ~rec_ohashtab();
     void DeInit() REQUIRES_TRANSACTION;
-    void SetHFn(RHFN);
+    void SetHFn(RHFN, RLHFN = NULL);
 
     void insert(void *,
                 rec_olink *) REQUIRES_TRANSACTION; /* add at head of list */
@@ -75,6 +96,7 @@ public:
     get(void *) REQUIRES_TRANSACTION; /* return and remove head of list */
 
     int count();
+    int buckets();
     int IsMember(void *, rec_olink *);
     int bucket(const void *); /* returns bucket number of key */
     /*virtual*/ void print();
@@ -83,7 +105,9 @@ public:
 };
 
 class rec_ohashtab_iterator {
+    friend class rec_ohashtab;
     rec_ohashtab *chashtab; /* current rec_ohashtab */
+    rec_ohashtab_iterator *nextlive; /* no splits while we are on the list */
     int allbuckets; /* iterate over all or single bucket */
     int cbucket; /* current bucket */
 
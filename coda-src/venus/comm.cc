@@ -919,6 +919,7 @@ srvent::srvent(struct in_addr *Host, RealmId realm)
     lastobs.tv_sec = lastobs.tv_usec = 0;
     refcount                         = 1;
     fetchpartial_support             = 0;
+    getdirattrs_support              = 1;
 
 #ifdef VENUSDEBUG
     allocs++;
@@ -223,6 +223,8 @@ class srvent : private RefCountedObject {
     friend class mgrpent;
     friend long VENUS_CallBack(RPC2_Handle, ViceFid *);
     friend long VENUS_CallBackFetch(RPC2_Handle, ViceFid *, SE_Descriptor *);
+    friend long VENUS_CallBackFetchDelta(RPC2_Handle, ViceFid *,
+                                         SE_Descriptor *);
     friend long VENUS_CallBackConnect(RPC2_Handle, RPC2_Integer, RPC2_Integer,
                                       RPC2_Integer, RPC2_Integer,
                                       RPC2_CountedBS *);
@@ -253,6 +255,7 @@ class srvent : private RefCountedObject {
     unsigned probeme : 1; /* should ProbeD probe this server? */
     unsigned unused : 1;
     unsigned fetchpartial_support : 1;
+    unsigned getdirattrs_support : 1;
     unsigned long bw; /* bandwidth estimate, Bytes/sec */
     struct timeval lastobs; /* time of most recent estimate */
 
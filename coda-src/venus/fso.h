@@ -31,7 +31,10 @@ listed in the file CREDITS.
 class fsdb;
 class fsobj;
 class fso_iterator;
+class fso_tier;
+class fso_prio_iterator;
 class connent;
+class mgrpent;
 class cmlent; /* we have compiler troubles if volume.h is included! */
 
 #ifdef __cplusplus
@@ -87,7 +90,7 @@ extern int global_kernfd;
 
 #define FSDB (rvg->recov_FSDB)
 const int FSDB_MagicNumber = 3620289;
-const int FSDB_NBUCKETS    = 2048;
+const int FSDB_NBUCKETS    = 2048; /* minimum, grows with CacheFiles */
 const int FSO_MagicNumber  = 2687694;
 
 const int MAX_PIGGY_VALIDATIONS = 50;
@@ -124,6 +127,7 @@ class fsdb {
     friend void FSODaemon();
     friend class fsobj;
     friend class fso_iterator;
+    friend class fso_prio_iterator;
     friend class hdb;
     friend class vproc;
     friend void RecovInit();
@@ -158,8 +162,8 @@ class fsdb {
     /* The free list. */
     rec_olist freelist;
 
-    /* The priority queue. */
-    /*T*/ bstree *prioq;
+    /* The replacement tiers, one for each hoard priority in use. */
+    /*T*/ dlist *tiers;
     long *LastRef;
     /*T*/ long RefCounter; /* used to compute short-term priority */
 
@@ -176,7 +180,7 @@ class fsdb {
     /*T*/ CacheStats FileDataStats;
     int VolumeLevelMiss; /* Counter to pass to data collection; Stored in RVM */
     /*T*/ int Recomputes; /* total priority recomputations */
-    /*T*/ int Reorders; /* number of resulting prioq reorders */
+    /*T*/ int Reorders; /* number of resulting tier changes */
 
     /* Synchronization stuff for matriculating objects. */
     /*T*/ char matriculation_sync;
@@ -206,8 +210,12 @@ class fsdb {
     void FreeBlocks(int);
     void ChangeDiskUsage(int);
 
+    /* Replacement tiers. */
+    fso_tier *GetTier(int);
+    void SortTiers();
+    int ReplaceableCount();
+
     /* Daemon. */
-    void RecomputePriorities(int = 0);
     void GarbageCollect() REQUIRES_TRANSACTION;
     void GetDown() REQUIRES_TRANSACTION;
     void FlushRefVec() EXCLUDES_TRANSACTION;
@@ -295,7 +303,9 @@ struct FsoFlags {
     unsigned expanded : 1; /* are we an expanded object */
     unsigned modified : 1; /* modified for expansion? */
     unsigned vastro : 1; /* is the file vastro?  */
-    unsigned padding : 7;
+    /*T*/ unsigned dirattrs : 1; /* entries' status fetched in bulk? */
+    /*T*/ unsigned signature : 1; /* container described for this writer? */
+    unsigned padding : 5;
 };
 
 enum MountStatus
@@ -342,10 +352,13 @@ typedef enum
 class ClientModifyLog;
 class fsobj {
     friend void FSOInit();
-    friend int FSO_PriorityFN(bsnode *, bsnode *);
+    friend int FSO_EntryHashFN(rec_olink *);
     friend class fsdb;
+    friend class fso_prio_iterator;
     friend class fso_iterator;
     friend long VENUS_CallBackFetch(RPC2_Handle, ViceFid *, SE_Descriptor *);
+    friend long VENUS_CallBackFetchDelta(RPC2_Handle, ViceFid *,
+                                         SE_Descriptor *);
     friend class vproc;
     friend class namectxt;
     friend class volent;
@@ -359,6 +372,7 @@ class fsobj {
     friend class hdb;
     friend class Realm; /* ~Realm */
     friend class plan9server;
+    friend class fetchstream;
     friend void RecoverPathName(char *, VenusFid *, ClientModifyLog *,
                                 cmlent *);
 
@@ -375,7 +389,8 @@ class fsobj {
     /* Links for various lists. */
     rec_olink primary_handle; /* link for {fstab, free-list} */
     /*T*/ struct dllist_head vol_handle; /* link for volent fso_list */
-    /*T*/ bsnode prio_handle; /* link for priority queue */
+    /*T*/ dlink prio_handle; /* link for replacement tier */
+    /*T*/ fso_tier *tier; /* tier we are linked into */
     /*T*/ dlink del_handle; /* link for delete queue */
     /*T*/ olink owrite_handle; /* link for owrite queue */
 
@@ -426,6 +441,8 @@ class fsobj {
     MiniVenusStat CleanStat; /* last status before becoming dirty */
     /* T */ ViceStoreId tSid; /* temporary for serializing MLEs */
     /*T*/ CacheFile *shadow; /* shadow copy, temporary during reintegration */
+    /*T*/ struct delta_sig *sigs; /* signature of the servers' copy, used to
+                                     store modifications as a delta */
 
     /* Data contents. */
     VenusData data;
@@ -504,7 +521,7 @@ class fsobj {
 
     /* Priority state. */
     void Reference();
-    void ComputePriority(int Force = 0);
+    void ComputePriority();
     void EnableReplacement();
     void DisableReplacement();
     binding *AttachHdbBinding(namectxt *);
@@ -610,6 +627,13 @@ class fsobj {
     int FetchFileRPC(connent *con, ViceStatus *status, uint64_t offset,
                      int64_t len, RPC2_CountedBS *PiggyBS,
                      SE_Descriptor *sed) EXCLUDES_TRANSACTION;
+    int FetchStreamHosts(mgrpent *m, struct in_addr *hosts,
+                         uint64_t offset, int64_t len) EXCLUDES_TRANSACTION;
+    int FetchFromVSG(struct in_addr *hosts, int nhosts, uid_t uid, int fd,
+                     uint64_t offset, int64_t len,
+                     ViceStatus *status) EXCLUDES_TRANSACTION;
+    void FetchStream(struct fetchstate *fs,
+                     struct in_addr *host) EXCLUDES_TRANSACTION;
     int OpenPioctlFile(void) EXCLUDES_TRANSACTION;
 
     void UpdateVastroFlag(uid_t uid, int force = 0,
@@ -620,6 +644,7 @@ public:
     int Fetch(uid_t) EXCLUDES_TRANSACTION;
     int Fetch(uid_t uid, uint64_t pos, int64_t count) EXCLUDES_TRANSACTION;
     int GetAttr(uid_t, RPC2_BoundedBS * = 0) EXCLUDES_TRANSACTION;
+    int GetDirAttrs(uid_t) EXCLUDES_TRANSACTION;
     int GetACL(RPC2_BoundedBS *, uid_t) EXCLUDES_TRANSACTION;
     int Store(unsigned long, Date_t, uid_t) EXCLUDES_TRANSACTION;
     int SetAttr(struct coda_vattr *, uid_t) EXCLUDES_TRANSACTION;
@@ -693,6 +718,9 @@ public:
     }
     int MakeShadow() REQUIRES_TRANSACTION;
     void RemoveShadow();
+    int NeedSignature();
+    void MakeSignature();
+    void DiscardSignature();
     void CacheReport(int, int);
     CacheChunkList *GetHoles(uint64_t start, int64_t len);
 
@@ -750,6 +778,45 @@ public:
     fsobj *operator()();
 };
 
+/* Replaceable objects with the same hoard priority. The short-term priority
+ * only depends on how recently an object was referenced, so keeping the list
+ * ordered by last reference also keeps it ordered by priority. */
+class fso_tier {
+public:
+    dlink handle; /* link for fsdb::tiers */
+    int hoardpri;
+    dlist lru; /* least recently referenced first */
+
+    /* Recovery appends objects in any order, it is restored by
+     * fsdb::SortTiers. */
+    static int ordered;
+
+    fso_tier(int pri) { hoardpri = pri; }
+};
+
+/* Returns the replaceable objects in priority order, lowest first unless
+ * DlDescending is given, by merging the replacement tiers. The priorities
+ * of the objects are recomputed as they are returned. Nothing is read ahead,
+ * the next object of a tier is found from the one last returned, so the
+ * caller may remove objects and yield between calls. */
+class fso_prio_iterator {
+    static fso_prio_iterator *live; /* iterators in use */
+    fso_prio_iterator *nextlive;
+    DlIterOrder order;
+    int ntiers;
+    fso_tier **tiers;
+    fsobj **last; /* object last returned from each tier, 0 before first */
+
+    fsobj *head(int);
+
+public:
+    fso_prio_iterator(DlIterOrder = DlAscending);
+    ~fso_prio_iterator();
+    fsobj *operator()();
+
+    static void Unlink(fsobj *);
+};
+
 /*  *****  Variables  ***** */
 
 extern unsigned int CacheFiles;
@@ -757,6 +824,7 @@ extern unsigned int PartialCacheFilesRatio;
 extern uint64_t WholeFileMaxSize;
 extern uint64_t WholeFileMinSize;
 extern uint64_t WholeFileMaxStall;
+extern int FetchStreams;
 extern int FSO_SWT;
 extern int FSO_MWT;
 extern int FSO_SSF;
@@ -765,7 +833,7 @@ extern int FSO_SSF;
 
 /* fso0.c */
 void FSOInit() EXCLUDES_TRANSACTION;
-extern int FSO_PriorityFN(bsnode *, bsnode *);
+extern int FSO_EntryHashFN(rec_olink *);
 extern void UpdateCacheStats(CacheStats *c, enum CacheEvent event,
                              unsigned long blocks);
 extern void PrintCacheStats(const char *description, CacheStats *, int);
@@ -809,8 +877,8 @@ void FSOD_ReclaimFSOs(void);
 #define FETCHABLE(f)                           \
     (!DYING(f) && REACHABLE(f) && !DIRTY(f) && \
      (!HAVESTATUS(f) || !WRITING(f) || ISVASTRO(f)) && !f->IsLocalObj())
-/* we are replaceable whenever we are linked into FSDB->prioq */
-#define REPLACEABLE(f) ((f)->prio_handle.tree() != 0)
+/* we are replaceable whenever we are linked into a replacement tier */
+#define REPLACEABLE(f) ((f)->prio_handle.is_linked())
 #define GCABLE(f) (DYING(f) && !DIRTY(f) && !BUSY(f))
 #define FLUSHABLE(f) ((DYING(f) || REPLACEABLE(f)) && !DIRTY(f) && !BUSY(f))
 #define BLOCKS(f) (NBLOCKS((f)->stat.Length))
@@ -67,14 +67,89 @@ unsigned int PartialCacheFilesRatio = 0;
 uint64_t WholeFileMaxSize           = 0;
 uint64_t WholeFileMinSize           = 0;
 uint64_t WholeFileMaxStall          = 0;
+int FetchStreams                    = 0;
 int FSO_SWT                         = UNSET_SWT;
 int FSO_MWT                         = UNSET_MWT;
 int FSO_SSF                         = UNSET_SSF;
 
+/* Checking the container files takes a stat() for each cached object and
+ * dominates restart time for large caches. The checks are spread over a
+ * number of LWPs that run concurrently on the LWP worker threads, see
+ * PRE_Concurrent(). */
+#define FSO_CHECKERS 8
+
+struct fso_check {
+    CacheFile **cfs; /* cache files of the cached objects */
+    char *valid; /* container check results */
+    int count;
+    int running; /* checkers that have not finished yet */
+};
+
+struct fso_checker {
+    struct fso_check *check;
+    int first;
+};
+
+static void FSOCheckContainers(void *arg)
+{
+    struct fso_checker *c   = (struct fso_checker *)arg;
+    struct fso_check *check = c->check;
+
+    /* only stat()s the containers, no venus state is touched */
+    PRE_Concurrent(1);
+    for (int i = c->first; i < check->count; i += FSO_CHECKERS)
+        check->valid[i] = check->cfs[i]->CheckContainer();
+    PRE_Concurrent(0);
+
+    check->running--;
+    LWP_NoYieldSignal(check);
+}
+
+static void FSOCheckAll(struct fso_check *check)
+{
+    struct fso_checker checkers[FSO_CHECKERS];
+    PROCESS pid;
+    int i;
+
+    check->running = 0;
+    for (i = 0; i < FSO_CHECKERS && i < check->count; i++) {
+        checkers[i].check = check;
+        checkers[i].first = i;
+        check->running++;
+        if (LWP_CreateProcess(FSOCheckContainers, 32 * 1024,
+                              LWP_NORMAL_PRIORITY, &checkers[i],
+                              "FSOCheckContainers", &pid) != LWP_SUCCESS) {
+            /* check this slice ourselves */
+            check->running--;
+            for (int j = i; j < check->count; j += FSO_CHECKERS)
+                check->valid[j] = check->cfs[j]->CheckContainer();
+        }
+    }
+
+    while (check->running)
+        LWP_WaitProcess(check);
+}
+
+/* milliseconds since *tv, which is set to the current time */
+static long FSOLapTime(struct timeval *tv)
+{
+    struct timeval now;
+    long msecs;
+
+    gettimeofday(&now, 0);
+    msecs = (now.tv_sec - tv->tv_sec) * 1000 +
+            (now.tv_usec - tv->tv_usec) / 1000;
+    *tv   = now;
+    return msecs;
+}
+
 /* Call with CacheDir the current directory. */
 void FSOInit()
 {
     unsigned int i;
+    struct timeval lap;
+    long check_ms = 0, recover_ms = 0, free_ms = 0, parent_ms = 0, cml_ms = 0,
+         tiers_ms = 0;
 
     /* Allocate the database if requested. */
     if (InitMetaData) { /* <==> FSDB == 0 */
@@ -155,13 +230,35 @@ void FSOInit()
             eprint("starting FSDB scan (%d, %d) (%d, %d, %d)", FSDB->MaxFiles,
                    FSDB->MaxBlocks, FSDB->swt, FSDB->mwt, FSDB->ssf);
 
+            gettimeofday(&lap, 0);
+
             /* Check entries in the table. */
             {
+                struct fso_check check;
                 fso_iterator next(NL);
-                fsobj *f;
-                while ((f = next())) {
+                fsobj *f, **fsos;
+                int n = 0;
+
+                check.count = (FSDB->htab).count();
+                check.cfs   = new CacheFile *[check.count];
+                check.valid = new char[check.count];
+                fsos        = new fsobj *[check.count];
+                while (n < check.count && (f = next())) {
+                    check.cfs[n] = &f->cf;
+                    fsos[n++]    = f;
+                }
+                check.count = n;
+
+                /* Check the cache-files in parallel. */
+                FSOCheckAll(&check);
+                check_ms = FSOLapTime(&lap);
+
+                for (n = 0; n < check.count; n++) {
+                    f = fsos[n];
+
                     /* Validate the cache-file, and record its blocks. */
-                    f->cf.Validate();
+                    if (!check.valid[n])
+                        f->cf.Validate();
                     FSDB->ChangeDiskUsage(NBLOCKS(f->cf.ValidData()));
 
                     /* Initialize transient members. */
@@ -170,6 +267,10 @@ void FSOInit()
                     /* Recover object state. */
                     f->Recover();
                 }
+                delete[] fsos;
+                delete[] check.cfs;
+                delete[] check.valid;
+                recover_ms = FSOLapTime(&lap);
 
                 eprint("\t%d cache files in table (%d blocks)",
                        (FSDB->htab).count(), FSDB->blocks);
@@ -188,6 +289,7 @@ void FSOInit()
 
                 eprint("\t%d cache files on free-list",
                        (FSDB->freelist).count());
+                free_ms = FSOLapTime(&lap);
             }
 
             if (FSDB->htab.count() + FSDB->freelist.count() != FSDB->MaxFiles)
@@ -214,6 +316,7 @@ void FSOInit()
                 } else
                     /* expanded objects need to be pinned down */
                     FSO_HOLD(cf);
+            parent_ms = FSOLapTime(&lap);
         }
 
         /* Recover fsobj <--> cmlent bindings: a grid-like data structure. */
@@ -231,7 +334,17 @@ void FSOInit()
                                f->mle_bindings->count() > 0) ||
                                   (!DIRTY(f) && f->mle_bindings == 0));
             }
+            cml_ms = FSOLapTime(&lap);
         }
+
+        /* Put the replacement tiers in LRU order. */
+        FSDB->SortTiers();
+        tiers_ms = FSOLapTime(&lap);
+
+        eprint("FSDB scan took %ld ms: containers %ld, recovery %ld, "
+               "free-list %ld, parents %ld, cml %ld, tiers %ld",
+               check_ms + recover_ms + free_ms + parent_ms + cml_ms + tiers_ms,
+               check_ms, recover_ms, free_ms, parent_ms, cml_ms, tiers_ms);
     }
 
     /* Set new Data version stamps. */
@@ -261,31 +374,18 @@ static int FSO_HashFN(const void *key)
     return (fid->Realm + fid->Volume + fid->Vnode);
 }
 
-int FSO_PriorityFN(bsnode *b1, bsnode *b2)
+int FSO_EntryHashFN(rec_olink *o)
 {
-    fsobj *f1 = strbase(fsobj, b1, prio_handle);
-    fsobj *f2 = strbase(fsobj, b2, prio_handle);
-    CODA_ASSERT((char *)f1 != (char *)f2);
-
-    if (f1->priority > f2->priority)
-        return (1);
-    if (f1->priority < f2->priority)
-        return (-1);
-
-    /* Use "random" bits assigned at allocation to break (most) ties. */
-    if (f1->flags.random > f2->flags.random)
-        return (1);
-    if (f1->flags.random < f2->flags.random)
-        return (-1);
+    return (FSO_HashFN(&strbase(fsobj, o, primary_handle)->fid));
+}
 
-    /* The chance of this ever happening should be miniscule! -JJK */
-    /*
-    eprint("FSO_PriorityFN: priorities tied (%d, %d)!\n",
-	    f1->priority, f1->flags.random);
-*/
-    LOG(1, ("FSO_PriorityFN: priorities tied (%d, %d)!\n", f1->priority,
-            f1->flags.random));
-    return (0);
+/* Start with a table that doesn't have to grow to hold a full cache. */
+static int FSO_NBuckets()
+{
+    int nbuckets = FSDB_NBUCKETS;
+    while ((unsigned int)nbuckets * REC_OHASH_LOAD < CacheFiles)
+        nbuckets *= 2;
+    return (nbuckets);
 }
 
 void UpdateCacheStats(CacheStats *c, enum CacheEvent event,
@@ -342,7 +442,7 @@ void *fsdb::operator new(size_t len)
 }
 
 fsdb::fsdb()
-    : htab(FSDB_NBUCKETS, FSO_HashFN)
+    : htab(FSO_NBuckets(), FSO_HashFN, FSO_EntryHashFN)
 {
     /* Initialize the persistent members. */
     RVMLIB_REC_OBJECT(*this);
@@ -365,8 +465,8 @@ void fsdb::ResetTransient()
     /* MaxBlocks, FreeBlockMargin reset in FsoInit */
     blocks = 0; /* this will get updated in fsobj::Recover() */
 
-    htab.SetHFn(FSO_HashFN);
-    prioq      = new bstree(FSO_PriorityFN);
+    htab.SetHFn(FSO_HashFN, FSO_EntryHashFN);
+    tiers      = new dlist;
     RefCounter = 0;
     for (unsigned int i = 0; i < MaxFiles; i++)
         if (LastRef[i] > RefCounter)
@@ -1215,8 +1315,11 @@ void fsdb::ClearPriorities()
     fso_iterator next(NL);
     fsobj *f;
     while ((f = next())) {
+        /* Move the object to the least recently used end of its tier. */
+        f->DisableReplacement();
         LastRef[f->ix] = 0;
         f->ComputePriority();
+        f->EnableReplacement();
     }
 }
 
@@ -1300,14 +1403,10 @@ void fsdb::ReclaimFsos(int priority, int count)
 {
     vproc *vp     = VprocSelf();
     int reclaimed = 0;
-    bstree_iterator next(*prioq);
-    bsnode *b, *bnext;
-
-    bnext = next();
-    while ((b = bnext) != NULL) {
-        bnext    = next();
-        fsobj *f = strbase(fsobj, b, prio_handle);
+    fso_prio_iterator next;
+    fsobj *f;
 
+    while ((f = next())) {
         if (!REPLACEABLE(f)) {
             f->print(logFile);
             CHOKE("fsdb::ReclaimFsos: !REPLACEABLE");
@@ -1348,6 +1447,74 @@ void fsdb::FreeFso(fsobj *f)
     freelist.append(&f->primary_handle);
 }
 
+/* Returns the replacement tier for objects with the given hoard priority. */
+fso_tier *fsdb::GetTier(int hoardpri)
+{
+    dlist_iterator next(*tiers);
+    dlink *d;
+    while ((d = next())) {
+        fso_tier *t = strbase(fso_tier, d, handle);
+        if (t->hoardpri == hoardpri)
+            return (t);
+    }
+
+    /* Tiers are never removed, there are only a few hoard priorities. */
+    fso_tier *t = new fso_tier(hoardpri);
+    tiers->append(&t->handle);
+    return (t);
+}
+
+struct fso_lastref {
+    long lastref;
+    fsobj *f;
+};
+
+static int FSO_LastRefFN(const void *a, const void *b)
+{
+    long r1 = ((const struct fso_lastref *)a)->lastref;
+    long r2 = ((const struct fso_lastref *)b)->lastref;
+
+    return (r1 < r2 ? -1 : r1 > r2 ? 1 : 0);
+}
+
+int fso_tier::ordered = 0;
+
+/* Sorting the tiers once is cheaper than keeping them in order while all
+ * objects are recovered. EnableReplacement keeps them in order from now on. */
+void fsdb::SortTiers()
+{
+    dlist_iterator next(*tiers);
+    dlink *d;
+    while ((d = next())) {
+        fso_tier *t = strbase(fso_tier, d, handle);
+        int count   = t->lru.count();
+        if (count < 2)
+            continue;
+
+        struct fso_lastref *refs = new struct fso_lastref[count];
+        for (int i = 0; i < count; i++) {
+            fsobj *f        = strbase(fsobj, t->lru.get(), prio_handle);
+            refs[i].lastref = LastRef[f->ix];
+            refs[i].f       = f;
+        }
+        qsort(refs, count, sizeof(struct fso_lastref), FSO_LastRefFN);
+        for (int i = 0; i < count; i++)
+            t->lru.append(&refs[i].f->prio_handle);
+        delete[] refs;
+    }
+    fso_tier::ordered = 1;
+}
+
+int fsdb::ReplaceableCount()
+{
+    int count = 0;
+    dlist_iterator next(*tiers);
+    dlink *d;
+    while ((d = next()))
+        count += strbase(fso_tier, d, handle)->lru.count();
+    return (count);
+}
+
 int fsdb::FreeBlockCount()
 {
     int count = MaxBlocks - blocks;
@@ -1442,11 +1609,9 @@ int fsdb::GrabFreeBlocks(int priority, int nblocks)
 void fsdb::ReclaimBlocks(int priority, int nblocks)
 {
     int reclaimed = 0;
-    bstree_iterator next(*prioq);
-    bsnode *b;
-    while ((b = next())) {
-        fsobj *f = strbase(fsobj, b, prio_handle);
-
+    fso_prio_iterator next;
+    fsobj *f;
+    while ((f = next())) {
         if (!REPLACEABLE(f)) {
             f->print(logFile);
             CHOKE("fsdb::ReclaimBlocks: !REPLACEABLE");
@@ -1526,8 +1691,8 @@ void fsdb::print(int fd, int SummaryOnly)
             DataVersion);
     fdprint(fd, "Files = (%d, %d, %d), Blocks = (%d, %d, %d)\n", MaxFiles,
             htab.count(), FreeFileMargin, MaxBlocks, blocks, FreeBlockMargin);
-    fdprint(fd, "Counts: fl = %d, prioq = %d, delq = %d, owq = %d\n",
-            freelist.count(), prioq->count(), delq->count(), owriteq->count());
+    fdprint(fd, "Counts: fl = %d, replaceable = %d, delq = %d, owq = %d\n",
+            freelist.count(), ReplaceableCount(), delq->count(), owriteq->count());
 #ifdef VENUSDEBUG
     {
         int normal_blocks = 0;
@@ -38,6 +38,7 @@ extern "C" {
 
 #include <sys/types.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <struct.h>
 #include <stdlib.h>
@@ -199,6 +200,7 @@ void fsobj::ResetTransient()
     /* This is a horrible way of resetting handles! */
     list_head_init(&vol_handle);
     memset((void *)&prio_handle, 0, (int)sizeof(prio_handle));
+    tier = 0;
     memset((void *)&del_handle, 0, (int)sizeof(del_handle));
     memset((void *)&owrite_handle, 0, (int)sizeof(owrite_handle));
 
@@ -211,7 +213,9 @@ void fsobj::ResetTransient()
     flags.ckmtpt   = 0;
     flags.fetching = 0;
     flags.vastro   = 0;
-    flags.random   = ::random();
+    flags.dirattrs  = 0;
+    flags.signature = 0;
+    flags.random    = ::random();
 
     memset((void *)&u, 0, (int)sizeof(u));
 
@@ -229,6 +233,7 @@ void fsobj::ResetTransient()
 
     mle_bindings = 0;
     shadow       = 0;
+    sigs         = 0;
 
     /*
      * sync doesn't need to be initialized.
@@ -1501,11 +1506,18 @@ void fsobj::Reference()
               FSDB->LastRef[ix], FSDB->RefCounter));
 
     FSDB->LastRef[ix] = FSDB->RefCounter++;
+
+    /* Move to the most recently used end of our tier. */
+    if (REPLACEABLE(this)) {
+        fso_prio_iterator::Unlink(this);
+        tier->lru.remove(&prio_handle);
+        tier->lru.append(&prio_handle);
+    }
 }
 
 /* local-repair modification */
 /* Need not be called from within transaction. */
-void fsobj::ComputePriority(int Force)
+void fsobj::ComputePriority()
 {
     LOG(1000, ("fsobj::ComputePriority: (%s)\n", FID_(&fid)));
 
@@ -1555,18 +1567,16 @@ void fsobj::ComputePriority(int Force)
         new_priority = FSDB->MakePri(spri, mpri);
     }
 
-    /* Force is only set by RecomputePriorities when called by the Hoard
-     * daemon (once every 10 minutes). By forcefully taking all FSO's off
-     * the priority queue and requeueing them the random seed is perturbed
-     * to avoid cache pollution by unreferenced low priority objects which
-     * happen to have a high random seed */
-    if (Force || priority == -1 || new_priority != priority) {
+    /* Aging doesn't change the order within a replacement tier, we only
+     * have to move to another tier when our hoard priority changed. */
+    if (priority == -1 || (REPLACEABLE(this) && tier->hoardpri != HoardPri)) {
         FSDB->Reorders++; /* transient value; punt set_range */
 
         DisableReplacement(); /* remove... */
         priority = new_priority; /* update key... */
         EnableReplacement(); /* reinsert... */
-    }
+    } else
+        priority = new_priority;
 }
 
 /* local-repair modification */
@@ -1603,20 +1613,17 @@ void fsobj::EnableReplacement()
         ("fsobj::EnableReplacement: (%s), priority = [%d (%d) %d %d]\n",
          FID_(&fid), priority, flags.random, HoardPri, FSDB->LastRef[ix]));
 
-#ifdef VENUSDEBUG
-    if (LogLevel >= 10000)
-        FSDB->prioq->print(logFile);
-#endif
-
-    FSDB->prioq->insert(&prio_handle);
-
-#ifdef VENUSDEBUG
-    if (LogLevel >= 10000 && !(FSDB->prioq->IsOrdered())) {
-        print(logFile);
-        FSDB->prioq->print(logFile);
-        CHOKE("fsobj::EnableReplacement: !IsOrdered after insert");
-    }
-#endif
+    /* Keep the tier in order of last reference. We usually were in use
+     * until just now, so search from the most recently referenced end. */
+    tier     = FSDB->GetTier(HoardPri);
+    dlink *d = tier->lru.last();
+    while (d && fso_tier::ordered &&
+           FSDB->LastRef[strbase(fsobj, d, prio_handle)->ix] > FSDB->LastRef[ix])
+        d = tier->lru.succ(d, DlDescending);
+    if (d)
+        tier->lru.insert_after(&prio_handle, d);
+    else
+        tier->lru.prepend(&prio_handle);
 }
 
 /* Need not be called from within transaction. */
@@ -1641,23 +1648,12 @@ void fsobj::DisableReplacement()
         ("fsobj::DisableReplacement: (%s), priority = [%d (%d) %d %d]\n",
          FID_(&fid), priority, flags.random, HoardPri, FSDB->LastRef[ix]));
 
-#ifdef VENUSDEBUG
-    if (LogLevel >= 10000)
-        FSDB->prioq->print(logFile);
-#endif
-
-    if (FSDB->prioq->remove(&prio_handle) != &prio_handle) {
-        print(logFile);
-        CHOKE("fsobj::DisableReplacement: prioq remove");
-    }
-
-#ifdef VENUSDEBUG
-    if (LogLevel >= 10000 && !(FSDB->prioq->IsOrdered())) {
+    fso_prio_iterator::Unlink(this);
+    if (tier->lru.remove(&prio_handle) != &prio_handle) {
         print(logFile);
-        FSDB->prioq->print(logFile);
-        CHOKE("fsobj::DisableReplacement: !IsOrdered after remove");
+        CHOKE("fsobj::DisableReplacement: tier remove");
     }
-#endif
+    tier = 0;
 }
 
 binding *CheckForDuplicates(dlist *hdb_bindings_list, void *binder)
@@ -1942,6 +1938,7 @@ void fsobj::DiscardData()
     RVMLIB_REC_OBJECT(data);
     switch (stat.VnodeType) {
     case File:
+        DiscardSignature();
         if (ISVASTRO(this) && ACTIVE(this)) {
             DiscardPartialData();
         } else {
@@ -1971,6 +1968,9 @@ void fsobj::DiscardData()
         rvmlib_rec_free(data.dir);
         data.dir = 0;
 
+        /* New contents get their entries fetched in bulk again. */
+        flags.dirattrs = 0;
+
         break;
     }
     case SymbolicLink: {
@@ -2450,6 +2450,44 @@ void fsobj::RemoveShadow()
     }
 }
 
+/* A clean file that is open for writing is described once, right before
+ * it is first modified, so that the next store of a large file can be sent
+ * to the servers as a delta against the version they already have. A dirty
+ * file keeps the signature of the version the servers have. */
+int fsobj::NeedSignature()
+{
+    return (WRITING(this) && !DIRTY(this) && !flags.signature &&
+            HAVEALLDATA(this) && !ISVASTRO(this) &&
+            data.file->Length() >= DELTA_MINSIZE);
+}
+
+/* Called from the access intents the kernel sends before a write. */
+void fsobj::MakeSignature()
+{
+    if (!NeedSignature())
+        return;
+
+    /* Set before we yield, the first write of another writer must not
+     * describe the container again while it is being modified. */
+    flags.signature = 1;
+    DiscardSignature();
+
+    int fd = data.file->Open(O_RDONLY);
+    sigs   = delta_signature(fd);
+    data.file->Close(fd);
+
+    LOG(10, ("fsobj::MakeSignature: (%s) %s\n", FID_(&fid),
+             sigs ? "done" : "failed"));
+}
+
+void fsobj::DiscardSignature()
+{
+    if (!sigs)
+        return;
+    delta_free(sigs);
+    sigs = 0;
+}
+
 /* Only call this on directory objects (or mount points)! */
 /* Locking is irrelevant, but this routine MUST NOT yield! */
 void fsobj::CacheReport(int fd, int level)
@@ -3009,3 +3047,93 @@ fsobj *fso_iterator::operator()() TRANSACTION_OPTIONAL
         }
     }
 }
+
+fso_prio_iterator *fso_prio_iterator::live = 0;
+
+fso_prio_iterator::fso_prio_iterator(DlIterOrder Order)
+{
+    dlist_iterator tnext(*FSDB->tiers);
+    dlink *d;
+
+    order  = Order;
+    ntiers = FSDB->tiers->count();
+    tiers  = new fso_tier *[ntiers];
+    last   = new fsobj *[ntiers];
+    for (int i = 0; i < ntiers && (d = tnext()); i++) {
+        tiers[i] = strbase(fso_tier, d, handle);
+        last[i]  = 0;
+    }
+
+    nextlive = live;
+    live     = this;
+}
+
+fso_prio_iterator::~fso_prio_iterator()
+{
+    fso_prio_iterator **pp;
+    for (pp = &live; *pp != this; pp = &(*pp)->nextlive)
+        ;
+    *pp = nextlive;
+
+    delete[] tiers;
+    delete[] last;
+}
+
+/* Returns the object that follows the one last returned from tier i. */
+fsobj *fso_prio_iterator::head(int i)
+{
+    fso_tier *t = tiers[i];
+    dlink *d;
+
+    for (;;) {
+        if (last[i])
+            d = t->lru.succ(&last[i]->prio_handle, order);
+        else
+            d = (order == DlAscending ? t->lru.first() : t->lru.last());
+        if (!d)
+            return (0);
+
+        /* The object leaves the tier when its hoard priority changed. */
+        fsobj *f = strbase(fsobj, d, prio_handle);
+        f->ComputePriority();
+        if (f->tier == t)
+            return (f);
+    }
+}
+
+fsobj *fso_prio_iterator::operator()()
+{
+    fsobj *best = 0;
+    int besti   = -1;
+
+    for (int i = 0; i < ntiers; i++) {
+        fsobj *f = head(i);
+        if (!f)
+            continue;
+        if (!best || (order == DlAscending ? f->priority < best->priority :
+                                             f->priority > best->priority)) {
+            best  = f;
+            besti = i;
+        }
+    }
+    if (besti != -1)
+        last[besti] = best;
+    return (best);
+}
+
+/* Must be called before f is removed from its tier, iterators that last
+ * returned f continue from the object before it. */
+void fso_prio_iterator::Unlink(fsobj *f)
+{
+    for (fso_prio_iterator *it = live; it; it = it->nextlive) {
+        DlIterOrder reverse =
+            (it->order == DlAscending ? DlDescending : DlAscending);
+
+        for (int i = 0; i < it->ntiers; i++) {
+            if (it->last[i] != f)
+                continue;
+            dlink *d    = f->tier->lru.succ(&f->prio_handle, reverse);
+            it->last[i] = d ? strbase(fsobj, d, prio_handle) : 0;
+        }
+    }
+}
@@ -148,13 +148,34 @@ void CacheFile::SetPartial(bool is_partial)
 /* MUST NOT be called from within transaction! */
 void CacheFile::Reset()
 {
-    if (access(name, F_OK) == 0 && length != 0) {
+    if (length != 0 && access(name, F_OK) == 0) {
         Recov_BeginTrans();
         Truncate(0);
         Recov_EndTrans(MAXFP);
     }
 }
 
+/* does a container with these attributes hold length bytes of our data */
+static int ContainerMatches(struct stat *tstat, uint64_t length)
+{
+    return
+#ifndef __CYGWIN32__
+        tstat->st_uid == (uid_t)V_UID && tstat->st_gid == (gid_t)V_GID &&
+        (tstat->st_mode & ~S_IFMT) == V_MODE &&
+#endif
+        tstat->st_size == (off_t)length;
+}
+
+int CacheFile::CheckContainer()
+{
+    struct stat tstat;
+
+    if (::stat(name, &tstat))
+        return 0;
+
+    return ContainerMatches(&tstat, length);
+}
+
 int CacheFile::ValidContainer()
 {
     struct stat tstat;
@@ -164,12 +185,7 @@ int CacheFile::ValidContainer()
     if (rc)
         return 0;
 
-    int valid =
-#ifndef __CYGWIN32__
-        tstat.st_uid == (uid_t)V_UID && tstat.st_gid == (gid_t)V_GID &&
-        (tstat.st_mode & ~S_IFMT) == V_MODE &&
-#endif
-        tstat.st_size == (off_t)length;
+    int valid = ContainerMatches(&tstat, length);
 
     if (!valid && LogLevel >= 0) {
         dprint("CacheFile::ValidContainer: %s invalid\n", name);
@@ -462,6 +462,14 @@ public:
      */
     void Validate() EXCLUDES_TRANSACTION;
 
+    /**
+     * Check the container file without logging or resetting it, this is
+     * safe to call from concurrent LWPs
+     *
+     * @return zero if file is invalid and different than zero otherwise
+     */
+    int CheckContainer();
+
     /**
      * Reset the container file to zero length and no data
      */
@@ -41,6 +41,7 @@ extern "C" {
 #include <rpc2/se.h>
 /* interfaces */
 #include <vice.h>
+#include <dirattrs.h>
 #include <lka.h>
 #include <struct.h>
 
@@ -263,6 +264,188 @@ TillEndFetching:
     return 0;
 }
 
+/* Large files in replicated volumes can be fetched from several servers at
+ * once. The range is split up in chunks which are handed out in file order
+ * to one fetch stream per server, a stream claims the next chunk as soon as
+ * the previous one has arrived so that faster servers end up fetching more
+ * of the file. */
+static const uint64_t FETCHSTREAM_CHUNK = 1024 * 1024;
+static const int FetchStreamStackSize   = 65536;
+
+struct fetchstate {
+    uid_t uid;
+    int fd; /* container file, shared by all streams */
+    uint64_t next; /* start of the first chunk that has not been claimed */
+    uint64_t end;
+    uint64_t chunk;
+    int running; /* number of streams that have not finished */
+    int code; /* first error returned by any of the streams */
+    int gotstatus;
+    ViceStatus status;
+    char sync;
+};
+
+class fetchstream : protected vproc {
+    fsobj *f;
+    struct fetchstate *fs;
+    struct in_addr host;
+
+    void main(void) EXCLUDES_TRANSACTION;
+
+public:
+    fetchstream(fsobj *obj, struct fetchstate *state, struct in_addr *h);
+};
+
+fetchstream::fetchstream(fsobj *obj, struct fetchstate *state,
+                         struct in_addr *h)
+    : vproc("FetchStream", NULL, VPT_FetchStream, FetchStreamStackSize)
+{
+    f       = obj;
+    fs      = state;
+    host    = *h;
+    u.u_uid = fs->uid;
+
+    start_thread();
+}
+
+void fetchstream::main(void)
+{
+    f->FetchStream(fs, &host);
+
+    fs->running--;
+    VprocSignal(&fs->sync);
+}
+
+/* Fetch chunks from host until there are no more chunks left to claim */
+void fsobj::FetchStream(struct fetchstate *fs, struct in_addr *host)
+{
+    ViceStatus status;
+    RPC2_CountedBS PiggyBS;
+    SE_Descriptor sed;
+    connent *c = NULL;
+    uint64_t offset, bytes;
+    int64_t len;
+    int code;
+
+    srvent *s = GetServer(host, vol->GetRealmId());
+    code      = s->GetConn(&c, fs->uid);
+    PutServer(&s);
+
+    while (code == 0 && fs->code == 0 && fs->next < fs->end) {
+        offset = fs->next;
+        len    = fs->chunk;
+        if (offset + len > fs->end)
+            len = fs->end - offset;
+        fs->next += len;
+
+        memset(&status, 0, sizeof(ViceStatus));
+        PiggyBS.SeqLen  = 0;
+        PiggyBS.SeqBody = NULL;
+
+        memset(&sed, 0, sizeof(SE_Descriptor));
+        sed.Tag                                   = SMARTFTP;
+        sed.Value.SmartFTPD.TransmissionDirection = SERVERTOCLIENT;
+        sed.Value.SmartFTPD.SeekOffset            = offset;
+        sed.Value.SmartFTPD.ByteQuota             = len;
+        sed.Value.SmartFTPD.Tag                   = FILEBYFD;
+        sed.Value.SmartFTPD.FileInfo.ByFD.fd      = fs->fd;
+
+        code = FetchFileRPC(c, &status, offset, len, &PiggyBS, &sed);
+        if (code != 0)
+            break;
+
+        bytes = sed.Value.SmartFTPD.BytesTransferred;
+        code  = CheckTransferredData(offset, len, status.Length, bytes, true);
+
+        /* keep whatever arrived, a retried fetch continues from there */
+        Recov_BeginTrans();
+        cf.SetValidData(offset, bytes);
+        Recov_EndTrans(CMFP);
+
+        if (code == 0 && VV_Cmp(&status.VV, &stat.VV) != VV_EQ) {
+            LOG(1, ("fsobj::FetchStream: failed validation\n"));
+            code = EAGAIN;
+        }
+
+        if (code == 0 && !fs->gotstatus) {
+            fs->status    = status;
+            fs->gotstatus = 1;
+        }
+    }
+
+    if (code != 0 && fs->code == 0)
+        fs->code = code;
+
+    if (c)
+        PutConn(&c);
+}
+
+/* Collects the hosts of the mgrp that can serve partial fetches, returns
+ * their number when the range is large enough to be worth splitting up */
+int fsobj::FetchStreamHosts(mgrpent *m, struct in_addr *hosts,
+                            uint64_t offset, int64_t len)
+{
+    uint64_t end = Size();
+    int i, nhosts = 0;
+
+    if (FetchStreams <= 1 || !IsFile())
+        return 0;
+
+    if (len >= 0 && offset + len < end)
+        end = offset + len;
+
+    for (i = 0; i < VSG_MEMBERS && nhosts < FetchStreams; i++) {
+        if (!m->rocc.hosts[i].s_addr)
+            continue;
+
+        srvent *s = GetServer(&m->rocc.hosts[i], vol->GetRealmId());
+        if (s->fetchpartial_support)
+            hosts[nhosts++] = m->rocc.hosts[i];
+        PutServer(&s);
+    }
+
+    if (nhosts < 2 || end <= offset ||
+        end - offset < nhosts * align_to_ccblock_ceil(FETCHSTREAM_CHUNK))
+        return 0;
+
+    return nhosts;
+}
+
+/* Fetch the range from the hosts found by FetchStreamHosts, the valid data
+ * of the container file is updated as chunks arrive */
+int fsobj::FetchFromVSG(struct in_addr *hosts, int nhosts, uid_t uid, int fd,
+                        uint64_t offset, int64_t len, ViceStatus *status)
+{
+    struct fetchstate fs;
+    int i;
+
+    memset(&fs, 0, sizeof(fs));
+    fs.uid   = uid;
+    fs.fd    = fd;
+    fs.next  = offset;
+    fs.end   = (len < 0 || offset + len > Size()) ? Size() : offset + len;
+    fs.chunk = align_to_ccblock_ceil(FETCHSTREAM_CHUNK);
+
+    LOG(10, ("fsobj::FetchFromVSG: (%s), %d streams [%lu - %lu]\n",
+             GetComp(), nhosts, fs.next, fs.end));
+
+    for (i = 0; i < nhosts; i++) {
+        fs.running++;
+        (void)new fetchstream(this, &fs, &hosts[i]);
+    }
+
+    while (fs.running)
+        VprocWait(&fs.sync);
+
+    if (fs.code == 0 && !fs.gotstatus)
+        fs.code = ERETRY;
+
+    if (fs.code == 0)
+        *status = fs.status;
+
+    return fs.code;
+}
+
 int fsobj::Fetch(uid_t uid)
 {
     return Fetch(uid, 0, -1);
@@ -427,7 +610,14 @@ int fsobj::Fetch(uid_t uid, uint64_t pos, int64_t count)
         }
 
         /* The COP:Fetch call. */
-        {
+        struct in_addr hosts[VSG_MEMBERS];
+        int nhosts;
+        nhosts = FetchStreamHosts(m, hosts, offset, len);
+        if (nhosts > 1) {
+            code = FetchFromVSG(hosts, nhosts, uid, fd, offset, len, &status);
+            if (code != 0)
+                goto RepExit;
+        } else {
             /* Make multiple copies of the IN/OUT and OUT parameters. */
             int ph_ix;
             struct in_addr *phost;
@@ -1255,6 +1445,209 @@ int fsobj::GetAttr(uid_t uid, RPC2_BoundedBS *acl)
     return (code);
 }
 
+/* Upper bound on the size of a ViceGetDirAttrs reply. */
+static const int DIRATTRS_MAXLEN = 1024 * 1024;
+
+/* Add the size of the ViceGetDirAttrs record for an entry to *hook. */
+static int DirAttrsLength(PDirEntry de, void *hook)
+{
+    int *length = (int *)hook;
+    ViceFid fid;
+    ViceStatus status;
+    BUFFER buffer = {};
+
+    if (STREQ(de->name, ".") || STREQ(de->name, ".."))
+        return 0;
+
+    memset(&fid, 0, sizeof(ViceFid));
+    memset(&status, 0, sizeof(ViceStatus));
+    pack_dirattrs(&buffer, de->name, 0, &fid, &status);
+    *length += (intptr_t)buffer.buffer;
+    return 0;
+}
+
+/*
+ * Fetch the status of all entries of this directory with a single
+ * ViceGetDirAttrs call. This is done once after the directory contents are
+ * fetched, when the first entry that isn't cached yet is looked up, so that
+ * listing a cold directory doesn't take a ViceGetAttr per entry.
+ *
+ * Objects are only created while there are free fsobjs, cached objects are
+ * never replaced for this. The status comes from a single server, on volumes
+ * with more than one replica it isn't marked valid and the entries are
+ * validated as piggybacked fids of the next ViceValidateAttrs instead.
+ */
+/* Call with object read-locked. */
+int fsobj::GetDirAttrs(uid_t uid)
+{
+    repvol *vp = (repvol *)vol;
+    connent *c = NULL;
+    mgrpent *m = NULL;
+    int code   = 0;
+    int maxlen = 0;
+    int trusted, ph_ix;
+    struct in_addr ph_addr;
+    long cbtemp;
+    char *buf = NULL;
+    RPC2_Unsigned count = 0, created = 0, validated = 0;
+
+    if (flags.dirattrs || !IsDir() || !HAVEALLDATA(this) || IsFake() ||
+        IsExpandedDir() || IsLocalObj() || !vol->IsReadWrite() ||
+        !REACHABLE(this) || DIRTY(this))
+        return 0;
+
+    LOG(10, ("fsobj::GetDirAttrs: (%s), uid = %d\n", GetComp(), uid));
+
+    /* Only try once for this copy of the directory, even if it fails. */
+    flags.dirattrs = 1;
+
+    DH_EnumerateDir(&data.dir->dh, DirAttrsLength, (void *)&maxlen);
+    if (maxlen == 0)
+        return 0;
+    if (maxlen > DIRATTRS_MAXLEN)
+        maxlen = DIRATTRS_MAXLEN;
+
+    trusted = !vol->IsReplicated() || vp->vsg->NHosts() == 1;
+
+    /* Status parameters. */
+    ViceStatus status;
+
+    /* COP2 Piggybacking. */
+    char PiggyData[COP2SIZE];
+    RPC2_CountedBS PiggyBS;
+    PiggyBS.SeqLen  = 0;
+    PiggyBS.SeqBody = (RPC2_ByteSeq)PiggyData;
+
+    code = vp->GetConn(&c, uid, &m, &ph_ix, &ph_addr);
+    if (code != 0)
+        goto Exit;
+
+    if (!c->srv->getdirattrs_support)
+        goto Exit;
+
+    buf = (char *)malloc(maxlen);
+    CODA_ASSERT(buf);
+
+    {
+        SE_Descriptor sed;
+        memset(&sed, 0, sizeof(SE_Descriptor));
+        sed.Tag = SMARTFTP;
+
+        struct SFTP_Descriptor *sei           = &sed.Value.SmartFTPD;
+        sei->TransmissionDirection            = SERVERTOCLIENT;
+        sei->hashmark                         = 0;
+        sei->SeekOffset                       = 0;
+        sei->ByteQuota                        = -1;
+        sei->Tag                              = FILEINVM;
+        sei->FileInfo.ByAddr.vmfile.MaxSeqLen = maxlen;
+        sei->FileInfo.ByAddr.vmfile.SeqBody   = (RPC2_ByteSeq)buf;
+
+        /* Make the RPC call. */
+        cbtemp = cbbreaks;
+        CFSOP_PRELUDE("fetch::GetDirAttrs %s\n", comp, fid);
+        UNI_START_MESSAGE(ViceGetDirAttrs_OP);
+        code = (int)ViceGetDirAttrs(c->connid, MakeViceFid(&fid), &status,
+                                    maxlen, &count, &PiggyBS, &sed);
+        UNI_END_MESSAGE(ViceGetDirAttrs_OP);
+        CFSOP_POSTLUDE("fetch::GetDirAttrs done\n");
+
+        /* Servers that don't know about the call will say so only once. */
+        if (code == RPC2_INVALIDOPCODE) {
+            LOG(0, ("fsobj::GetDirAttrs: %s doesn't support ViceGetDirAttrs\n",
+                    c->srv->name));
+            c->srv->getdirattrs_support = 0;
+            code                        = 0;
+            goto Exit;
+        }
+
+        /* Examine the return code to decide what to do next. */
+        code = vol->Collate(c, code);
+        UNI_RECORD_STATS(ViceGetDirAttrs_OP);
+        if (code != 0)
+            goto Exit;
+
+        /* Our copy of the directory is stale, don't mix it with the new
+         * entries. The normal validation will refetch it. */
+        if (VV_Cmp(&status.VV, &stat.VV) != VV_EQ ||
+            (!vol->IsReplicated() && status.DataVersion != stat.DataVersion))
+            goto Exit;
+
+        BUFFER buffer = {};
+        buffer.who    = RP2_CLIENT;
+        buffer.buffer = buf;
+        buffer.eob    = buf + sei->FileInfo.ByAddr.vmfile.SeqLen;
+
+        /* Callbacks broken during the call make the status suspect. */
+        if (cbtemp != cbbreaks)
+            trusted = 0;
+
+        Recov_BeginTrans();
+        for (unsigned int i = 0; i < count; i++) {
+            RPC2_CountedBS name;
+            ViceFid vfid;
+            ViceStatus cstatus;
+            VenusFid cfid;
+            fsobj *f;
+
+            if (unpack_dirattrs(&buffer, fid.Volume, &name, &vfid, &cstatus)) {
+                LOG(0, ("fsobj::GetDirAttrs: (%s) bad record %d\n", GetComp(),
+                        i));
+                break;
+            }
+            MakeVenusFid(&cfid, vol->GetRealmId(), &vfid);
+
+            f = FSDB->Find(&cfid);
+            if (f) {
+                /* Revalidate status we already have. */
+                if (!trusted || cstatus.CallBack != CallBackSet ||
+                    !HAVESTATUS(f) || STATUSVALID(f) || DIRTY(f) || BUSY(f) ||
+                    DYING(f) || f->IsFake() ||
+                    VV_Cmp(&cstatus.VV, &f->stat.VV) != VV_EQ ||
+                    (!vol->IsReplicated() &&
+                     cstatus.DataVersion != f->stat.DataVersion))
+                    continue;
+
+                f->SetRcRights(RC_STATUS | RC_DATA);
+                if (f->IsDir()) {
+                    f->PromoteAcRights(ANYUSER_UID);
+                    f->PromoteAcRights(uid);
+                }
+                validated++;
+                continue;
+            }
+
+            /* Don't push anything else out of the cache. */
+            if (FSDB->FreeFsoCount() <= FSDB->FreeFileMargin)
+                continue;
+
+            f = new (FROMFREELIST, VprocSelf()->u.u_priority)
+                fsobj(&cfid, (char *)name.SeqBody);
+            if (!f)
+                break;
+
+            f->UpdateStatus(&cstatus, NULL, uid);
+            if (trusted && cstatus.CallBack == CallBackSet)
+                f->SetRcRights(RC_STATUS);
+            f->UnLock(WR);
+            f->ComputePriority();
+            created++;
+        }
+        Recov_EndTrans(MAXFP);
+    }
+
+    LOG(10, ("fsobj::GetDirAttrs: (%s), %d entries, %d created, %d valid\n",
+             GetComp(), count, created, validated));
+
+Exit:
+    if (m)
+        m->Put();
+    if (c)
+        PutConn(&c);
+    free(buf);
+
+    return (code);
+}
+
 int fsobj::GetACL(RPC2_BoundedBS *acl, uid_t uid)
 {
     LOG(10, ("fsobj::GetACL: (%s), uid = %d\n", GetComp(), uid));
@@ -245,6 +245,12 @@ int fsobj::Open(int writep, int truncp, struct venus_cnode *cp, uid_t uid)
     openers++;
     if (writep) {
         FSO_ASSERT(this, IsFile());
+        /* The container of a clean file is described when it is first
+         * written to, there is no point when all of it is replaced. */
+        if (Writers == 0 && !DIRTY(this)) {
+            DiscardSignature();
+            flags.signature = truncp ? 1 : 0;
+        }
         Writers++;
         if (!flags.owrite) {
             Recov_BeginTrans();
@@ -489,6 +495,12 @@ void fsobj::Release(int writep)
                 stat.Length = 0; /* Necessary for blocks maintenance! */
             }
             Recov_EndTrans(DMFP);
+
+            /* Nothing to store, the servers already have this version. */
+            if (!DIRTY(this)) {
+                DiscardSignature();
+                flags.signature = 0;
+            }
         }
     } else if (IsPioctlFile()) {
         LOG(10, ("fsobj::Release: dropping pioctl file (%s)\n", FID_(&fid)));
@@ -731,6 +743,10 @@ int fsobj::Lookup(fsobj **target_fso_addr, VenusFid *inc_fid, const char *name,
                     target_fid.Unique = realm->Id();
                 }
             }
+            /* The first entry that isn't cached yet brings in the status of
+             * all other entries as well. */
+            else if (!FSDB->Find(&target_fid))
+                GetDirAttrs(uid);
         }
     }
 
@@ -113,32 +113,6 @@ void FSODaemon(void)
     }
 }
 
-/* This is needed to "age" object priorities. */
-void fsdb::RecomputePriorities(int Force)
-{
-    static long LastRefCounter = 0;
-
-    int Count = (int)(RefCounter - LastRefCounter);
-    if (Count == 0)
-        return; /* don't recompute if nothing has been referenced */
-    if (!Force && Count < /*MAXRC*/ (int)(MaxFiles >> 16))
-        return;
-
-    LastRefCounter = RefCounter;
-
-    START_TIMING();
-    int recomputes = 0;
-    fso_iterator next(NL);
-    fsobj *f;
-    while ((f = next())) {
-        recomputes++;
-        f->ComputePriority(Force);
-    }
-    END_TIMING();
-    LOG(100, ("fsdb::RecomputePriorities: recomputes = %d, elapsed = %3.1f\n",
-              recomputes, elapsed));
-}
-
 /* MUST be called from within transaction! */
 void fsdb::GarbageCollect()
 {
@@ -184,9 +158,6 @@ void fsdb::GetDown()
     /* GC anything out there first. */
     GarbageCollect();
 
-    /* Start with fso priorities at their correct values. */
-    RecomputePriorities();
-
     /* Reclaim fsos and/or blocks as needed. */
     START_TIMING();
     int FsosNeeded = FreeFileMargin - FreeFsoCount();
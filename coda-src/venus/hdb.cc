@@ -692,10 +692,9 @@ void hdb::DataWalk(vproc *vp, int TotalBytesToFetch, int BytesFetched)
         InitTally(); // Delete old list and start over
         TallyPrint(PrimaryUser);
 
-        bstree_iterator next(*FSDB->prioq, BstDescending);
-        bsnode *b = 0;
-        while ((b = next())) {
-            fsobj *f = strbase(fsobj, b, prio_handle);
+        fso_prio_iterator next(DlDescending);
+        fsobj *f;
+        while ((f = next())) {
             CODA_ASSERT(f != NULL);
             int blocks = BLOCKS(f);
 
@@ -806,11 +805,10 @@ void hdb::DataWalk(vproc *vp, int TotalBytesToFetch, int BytesFetched)
 	 * Count the number of indigent fsobjs/blocks and find the
          * find first one (for informational purposes only).
 	 */
-        bstree_iterator next(*FSDB->prioq, BstDescending);
-        bsnode *b = 0;
+        fso_prio_iterator next(DlDescending);
+        fsobj *f;
         InitTally();
-        while ((b = next())) {
-            fsobj *f = strbase(fsobj, b, prio_handle);
+        while ((f = next())) {
             CODA_ASSERT(f != NULL);
             int blocks = (int)BLOCKS(f);
 
@@ -899,8 +897,7 @@ int hdb::Walk(hdb_walk_msg *m, uid_t local_id)
     if (local_id == V_UID || AuthorizedUser(local_id))
         SetDemandWalkTime();
 
-    /* 1. Start with fso priorities at their correct values. */
-    FSDB->RecomputePriorities(1);
+    /* 1. Fso priorities are recomputed as the walk visits them. */
 
     /* 2. Bring the cache into STATUS equilibrium. */
     /*    (i.e., validate/expand hoard entries s.t. priority and resource
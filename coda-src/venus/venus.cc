@@ -754,6 +754,7 @@ static void DefaultCmdlineParms()
     const char *TmpCacheChunkBlockSize = NULL;
     const char *TmpWFMax               = NULL;
     const char *TmpWFMin               = NULL;
+    const char *TmpReadAhead           = NULL;
 
     /* Load the "venus.conf" configuration file */
     codaconf_init("venus.conf");
@@ -805,12 +806,22 @@ static void DefaultCmdlineParms()
 
     CODACONF_INT(PartialCacheFilesRatio, "partialcachefilesratio", 1);
 
+    CODACONF_INT(FetchStreams, "fetchstreams", 1);
+
+    if (!ReadAheadMax) {
+        CODACONF_STR(TmpReadAhead, "readaheadmax", "1MB");
+        ReadAheadMax = ParseSizeWithUnits(TmpReadAhead) * 1024;
+    }
+
+    CODACONF_INT(UpcallBatch, "upcallbatch", DFLT_UPCALLBATCH);
+
     CODACONF_STR(CacheDir, "cachedir", DFLT_CD);
     CODACONF_STR(SpoolDir, "checkpointdir", "/usr/coda/spool");
     CODACONF_STR(VenusLogFile, "logfile", DFLT_LOGFILE);
     CODACONF_STR(consoleFile, "errorlog", DFLT_ERRLOG);
     CODACONF_STR(kernDevice, "kerneldevice", "/dev/cfs0,/dev/coda/0");
     CODACONF_INT(MapPrivate, "mapprivate", 0);
+    CODACONF_INT(RdsCoalesceBlocks, "rds_coalesce", DFLT_RDSCB);
     CODACONF_STR(MarinerSocketPath, "marinersocket", "/usr/coda/spool/mariner");
     CODACONF_INT(masquerade_port, "masquerade_port", 0);
     CODACONF_INT(allow_backfetch, "allow_backfetch", 0);
@@ -166,9 +166,9 @@ marinersocket=/var/run/coda-client.mariner
 # anonymous mmap. Using a private mmap will reduce startup times, as
 # missing pages are paged in when they are accesses. Also swap usage is
 # reduced as any unmodified pages do not have to be backed up by swap
-# memory when memory gets tight. Private mappings do not work when rvm
-# data is stored on a raw partition on Linux. Set to 1 to use private
-# mappings, 0 to use anonymous mappings.
+# memory when memory gets tight. When rvm data is stored on a raw partition
+# that cannot be mmapped, the data is read in at startup as with anonymous
+# mappings. Set to 1 to use private mappings, 0 to use anonymous mappings.
 #
 # We enabled this setting because venus uses files for RVM and the
 # faster startup times and reduced memory pressure are very noticeable.
@@ -176,6 +176,14 @@ marinersocket=/var/run/coda-client.mariner
 #mapprivate=0
 mapprivate=1
 
+#
+# Number of RVM heap blocks the recovery daemon examines every 5 seconds
+# when merging adjacent free blocks in the background. This keeps the free
+# space from fragmenting so large allocations do not have to wait for the
+# whole heap to be coalesced. Set to 0 to disable.
+#
+#rds_coalesce=256
+
 #
 # Kernel device,
 # The character device used by venus to communicate with the kernel module.
@@ -354,6 +362,28 @@ mapprivate=1
 #
 #partialcachefilesratio=1
 
+#
+# Maximum number of servers a large file in a replicated volume is fetched
+# from at the same time. The file is split in chunks that are fetched
+# in parallel from the available replicas. The default value of 1 fetches
+# every file from a single server.
+#
+#fetchstreams=1
+
+#
+# Maximum amount of data that is read ahead when a partially cached file is
+# read sequentially. The readahead window starts at twice the size of a read
+# and doubles on every following sequential read up to this size. A value of
+# 0 disables readahead. The default value is 1MB.
+#
+#readaheadmax=1MB
+
+#
+# Maximum number of kernel upcalls that are read and handed to worker threads
+# every time the kernel device becomes readable. The default value is 16.
+#
+#upcallbatch=16
+
 #
 # Directory containing Coda CA certificates
 #
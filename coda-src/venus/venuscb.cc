@@ -311,6 +311,100 @@ GetLost:
     return (code);
 }
 
+/* Larger deltas are not worth it, the server fetches the whole file. */
+#define MAXDELTALEN (64 * 1024 * 1024)
+
+long VENUS_CallBackFetchDelta(RPC2_Handle RPCid, ViceFid *Fid,
+                              SE_Descriptor *BD) EXCLUDES_TRANSACTION
+{
+    VenusFid vf;
+    srvent *s = FindServerByCBCid(RPCid);
+
+    MakeVenusFid(&vf, s->realmid, Fid);
+
+    LOG(1, ("CallBackFetchDelta: host = %s, fid = (%s)\n", s->name, FID_(&vf)));
+
+    long code   = 0;
+    int fd      = -1;
+    char *delta = NULL;
+    size_t len  = 0, maxlen;
+
+    /* Get the object. */
+    fsobj *f = FSDB->Find(&vf);
+    if (!f) {
+        code = ENOENT;
+        goto GetLost;
+    }
+
+    /* Without a signature of the servers' version there is nothing to
+     * compute the delta against. */
+    if (!f->sigs || !f->shadow || !f->IsFile() || !HAVEALLDATA(f)) {
+        code = EINVAL;
+        goto GetLost;
+    }
+
+    /* Compute the delta from the shadow copy made for this reintegration. */
+    maxlen = f->shadow->Length() / 2;
+    if (maxlen > MAXDELTALEN)
+        maxlen = MAXDELTALEN;
+
+    fd = f->shadow->Open(O_RDONLY);
+    if (delta_encode(f->sigs, fd, &delta, &len, maxlen) < 0) {
+        LOG(1, ("CallBackFetchDelta: no delta smaller than %d bytes\n",
+                (int)maxlen));
+        code = EFBIG;
+        goto GetLost;
+    }
+
+    /* Notify Codacon. */
+    MarinerLog("callback::BackFetchDelta %s, %s [%d]\n", s->name, f->GetComp(),
+               NBLOCKS(len));
+
+    /* Do the transfer. */
+    {
+        SE_Descriptor sid;
+        memset(&sid, 0, sizeof(SE_Descriptor));
+        sid.Tag                     = SMARTFTP;
+        struct SFTP_Descriptor *sei = &sid.Value.SmartFTPD;
+        sei->TransmissionDirection  = SERVERTOCLIENT;
+        sei->hashmark               = (LogLevel >= 10 ? '#' : '\0');
+        sei->SeekOffset             = 0;
+        sei->ByteQuota              = -1;
+
+        sei->Tag                              = FILEINVM;
+        sei->FileInfo.ByAddr.vmfile.SeqLen    = len;
+        sei->FileInfo.ByAddr.vmfile.MaxSeqLen = len;
+        sei->FileInfo.ByAddr.vmfile.SeqBody   = (RPC2_ByteSeq)delta;
+
+        if ((code = RPC2_InitSideEffect(RPCid, &sid)) <= RPC2_ELIMIT) {
+            LOG(1, ("CallBackFetchDelta: InitSE failed (%d)\n", code));
+            goto GetLost;
+        }
+
+        if ((code = RPC2_CheckSideEffect(RPCid, &sid, SE_AWAITLOCALSTATUS)) <=
+            RPC2_ELIMIT) {
+            LOG(1, ("CallBackFetchDelta: CheckSE failed (%d)\n", code));
+            if (code == RPC2_SEFAIL1)
+                code = EIO;
+            goto GetLost;
+        }
+
+        LOG(100, ("CallBackFetchDelta: transferred %d bytes for %llu\n",
+                  sid.Value.SmartFTPD.BytesTransferred,
+                  (unsigned long long)f->shadow->Length()));
+        if (f->vol->IsReadWrite())
+            ((reintvol *)f->vol)->BytesBackFetched +=
+                sid.Value.SmartFTPD.BytesTransferred;
+    }
+
+GetLost:
+    if (fd != -1)
+        f->shadow->Close(fd);
+    free(delta);
+    LOG(1, ("CallBackFetchDelta: returning %d\n", code));
+    return (code);
+}
+
 /* CallBackNEWCONNECTION() */
 long VENUS_CallBackConnect(RPC2_Handle RPCid, RPC2_Integer SideEffectType,
                            RPC2_Integer SecurityLevel,
@@ -83,6 +83,7 @@ const char *VenusDataDevice       = NULL;
 unsigned long VenusDataDeviceSize = UNSET_VDDS;
 int RdsChunkSize                  = UNSET_RDSCS;
 int RdsNlists                     = UNSET_RDSNL;
+int RdsCoalesceBlocks             = 0;
 int CMFP                          = UNSET_CMFP;
 int DMFP                          = UNSET_DMFP;
 int MAXFP                         = UNSET_MAXFP;
@@ -390,7 +391,7 @@ static void Recov_InitRVM()
     Recov_Options.log_dev  = logdev;
     Recov_Options.truncate = 0;
     //Recov_Options.flags = RVM_COALESCE_TRANS;  /* oooh, daring */
-    Recov_Options.flags = RVM_ALL_OPTIMIZATIONS;
+    Recov_Options.flags = RVM_ALL_OPTIMIZATIONS | RVM_ASYNC_IO;
     if (MapPrivate)
         Recov_Options.flags |= RVM_MAP_PRIVATE;
 
@@ -741,9 +742,13 @@ void RecovPrint(int fd)
             fd,
             "RecovPrint:  Free bytes in heap = %d; Malloc'd bytes in heap = %d\n\n",
             rdsstats.freebytes, rdsstats.mallocbytes);
-    // We wish there were a way to find out if heap_header_t.maxlist < heap_header_t.nlists.
-    // If there were, that would be a sign that fragmentation is becoming a problem.
-    // Unfortunately, heap_header_t is in rds_private.h
+
+    unsigned long nfree, largest;
+    int frag = rds_fragmentation(&nfree, &largest);
+    fdprint(
+        fd,
+        "RecovPrint:  Free blocks = %lu; Largest free block = %lu; Fragmentation = %d%%\n\n",
+        nfree, largest, frag);
 }
 
 /*  *****  RVM String Routines  *****  */
@@ -808,6 +813,13 @@ void RecovDaemon(void)
             WorkerIdleTime >= WITT)
             RecovFlush();
 
+        /* Merge some of the free space in the heap. */
+        if (RvmType != VM && RdsCoalesceBlocks > 0) {
+            int err;
+            if (rds_coalesce_step(RdsCoalesceBlocks, &err) < 0)
+                LOG(0, ("RecovDaemon: rds_coalesce_step failed (%d)\n", err));
+        }
+
         /* Bump sequence number. */
         vp->seq++;
     }
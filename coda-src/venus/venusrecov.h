@@ -63,6 +63,7 @@ const int DFLT_RDSCS            = 64; /* RDS chunk size */
 const int UNSET_RDSCS           = -1;
 const int DFLT_RDSNL            = 16; /* RDS nlists */
 const int UNSET_RDSNL           = -1;
+const int DFLT_RDSCB            = 256; /* RDS blocks coalesced per pass */
 const int DFLT_CMFP             = 600; /* Connected-Mode Flush Period */
 const int UNSET_CMFP            = -1;
 const int DFLT_DMFP             = 30; /* Disconnected-Mode Flush Period */
@@ -77,7 +78,7 @@ const unsigned long DFLT_MAXTS  = 256 * 1024; /* Maximum Truncate Size */
 const unsigned long UNSET_MAXTS = (unsigned long)-1;
 
 const int RecovMagicNumber   = 0x8675309;
-const int RecovVersionNumber = 41; /* Update this when format changes. */
+const int RecovVersionNumber = 44; /* Update this when format changes. */
 
 /*  *****  Types  *****  */
 /* local-repair modification */
@@ -142,6 +143,7 @@ extern const char *VenusDataDevice;
 extern unsigned long VenusDataDeviceSize;
 extern int RdsChunkSize;
 extern int RdsNlists;
+extern int RdsCoalesceBlocks;
 extern int CMFP;
 extern int DMFP;
 extern int WITT;
@@ -279,6 +279,16 @@ int VOL_HashFN(const void *key)
     return volid->Realm + volid->Volume;
 }
 
+int VOL_EntryHashFN(rec_olink *o)
+{
+    volent *v = strbase(volent, o, handle);
+    Volid volid;
+
+    volid.Realm  = v->realm->Id();
+    volid.Volume = v->vid;
+    return VOL_HashFN(&volid);
+}
+
 static void GetRootVolume(Realm *realm, char **buf) EXCLUDES_TRANSACTION
 {
     connent *c = NULL;
@@ -337,8 +347,8 @@ void *vdb::operator new(size_t len)
 }
 
 vdb::vdb()
-    : volrep_hash(VDB_NBUCKETS, VOL_HashFN)
-    , repvol_hash(VDB_NBUCKETS, VOL_HashFN)
+    : volrep_hash(VDB_NBUCKETS, VOL_HashFN, VOL_EntryHashFN)
+    , repvol_hash(VDB_NBUCKETS, VOL_HashFN, VOL_EntryHashFN)
 {
     /* Initialize the persistent members. */
     RVMLIB_REC_OBJECT(*this);
@@ -353,8 +363,8 @@ void vdb::ResetTransient()
     if (MagicNumber != VDB_MagicNumber)
         CHOKE("vdb::ResetTransient: bad magic number (%d)", MagicNumber);
 
-    volrep_hash.SetHFn(VOL_HashFN);
-    repvol_hash.SetHFn(VOL_HashFN);
+    volrep_hash.SetHFn(VOL_HashFN, VOL_EntryHashFN);
+    repvol_hash.SetHFn(VOL_HashFN, VOL_EntryHashFN);
 }
 
 void vdb::operator delete(void *deadobj)
@@ -89,7 +89,7 @@ enum VolLockType
 
 #define VDB (rvg->recov_VDB)
 const int VDB_MagicNumber     = 6820348;
-const int VDB_NBUCKETS        = 512;
+const int VDB_NBUCKETS        = 512; /* initial size, grows as needed */
 const int VOLENT_MagicNumber  = 3614246;
 const int MLENT_MagicNumber   = 5214113;
 const int MLENTMaxFreeEntries = 32;
@@ -630,6 +630,7 @@ class volent {
     friend class vdb;
     friend class volent_iterator;
     friend class vproc; /* End_VFS(int *); wants vol->realm->GetUser() */
+    friend int VOL_EntryHashFN(rec_olink *);
 
     int MagicNumber;
 
@@ -749,6 +750,8 @@ class reintvol : public volent {
     friend class cmlent;
     friend class vdb;
     friend long VENUS_CallBackFetch(RPC2_Handle, ViceFid *, SE_Descriptor *);
+    friend long VENUS_CallBackFetchDelta(RPC2_Handle, ViceFid *,
+                                         SE_Descriptor *);
 
 private:
 protected:
@@ -941,6 +944,8 @@ class repvol : public reintvol {
     friend class vdb;
     friend class volent; /* CML_Lock */
     friend long VENUS_CallBackFetch(RPC2_Handle, ViceFid *, SE_Descriptor *);
+    friend long VENUS_CallBackFetchDelta(RPC2_Handle, ViceFid *,
+                                         SE_Descriptor *);
     friend void Resolve(volent *);
     friend void Reintegrate(reintvol *);
     friend void VolInit(void);
@@ -1135,7 +1140,8 @@ extern int default_reintegration_time;
 /* venusvol.c */
 void VolInit(void) EXCLUDES_TRANSACTION;
 void VolInitPost(void);
-int VOL_HashFN(void *);
+int VOL_HashFN(const void *);
+int VOL_EntryHashFN(rec_olink *);
 
 /* vol_COP2.c */
 const unsigned int COP2SIZE = 1024;
@@ -533,6 +533,12 @@ void vproc::GetStamp(char *buf)
     case VPT_Daemon:
         t = 'd';
         break;
+    case VPT_FetchStream:
+        t = 'S';
+        break;
+    case VPT_ReadAhead:
+        t = 'a';
+        break;
     default:
         t = '?';
         eprint("???vproc::GetStamp: bogus type (%d)!", type);
@@ -109,7 +109,9 @@ enum vproctype
     VPT_VmonDaemon,
     VPT_AdviceDaemon,
     VPT_LRDaemon,
-    VPT_Daemon
+    VPT_Daemon,
+    VPT_FetchStream,
+    VPT_ReadAhead
 };
 
 /* Holds user/call specific context. */
@@ -341,6 +343,7 @@ int VprocSelect(int, fd_set *, fd_set *, fd_set *,
 extern void VprocSetRetry(int = -1, struct timeval * = 0);
 extern int VprocIdle();
 extern int VprocInterrupted();
+extern uint64_t ReadAheadMax;
 //extern void PrintVprocs();
 //extern void PrintVprocs(FILE *);
 //extern void PrintVprocs(int);
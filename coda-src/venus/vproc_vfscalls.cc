@@ -1625,17 +1625,167 @@ void vproc::fsync(struct venus_cnode *cp)
     }
 }
 
+/* Readahead for partially cached files. Sequential reads are detected per
+ * file, once a file is being streamed the chunks following the current read
+ * are fetched by a separate thread while the application consumes the data
+ * it already has. The readahead window doubles on every sequential read up to
+ * ReadAheadMax and is dropped as soon as the file is accessed randomly. */
+uint64_t ReadAheadMax = 0;
+
+#define READAHEAD_STREAMS 8
+static const int ReadAheadStackSize = 65536;
+
+struct rastate {
+    VenusFid fid;
+    uint64_t next; /* where the next sequential read would start */
+    uint64_t window; /* current readahead size, 0 for random access */
+    uint64_t mark; /* end of the data that has been read ahead */
+    uint64_t start, end; /* range being read ahead, end is 0 when idle */
+    int active; /* readahead thread has started fetching */
+    unsigned long used;
+    char sync;
+};
+static struct rastate ReadAheadState[READAHEAD_STREAMS];
+static unsigned long ReadAheadClock;
+
+/* Find the readahead state of fid, or recycle the least recently used idle
+ * state when create is set */
+static struct rastate *GetReadAhead(VenusFid *fid, int create)
+{
+    struct rastate *ra, *victim = NULL;
+    int i;
+
+    for (i = 0; i < READAHEAD_STREAMS; i++) {
+        ra = &ReadAheadState[i];
+        if (FID_EQ(&ra->fid, fid)) {
+            ra->used = ++ReadAheadClock;
+            return ra;
+        }
+        if (!ra->end && (!victim || ra->used < victim->used))
+            victim = ra;
+    }
+    if (!create || !victim)
+        return NULL;
+
+    memset(victim, 0, sizeof(*victim));
+    victim->fid  = *fid;
+    victim->used = ++ReadAheadClock;
+    return victim;
+}
+
+class readaheadproc : protected vproc {
+    struct rastate *ra;
+
+    void main(void) EXCLUDES_TRANSACTION;
+
+public:
+    readaheadproc(struct rastate *state, uid_t uid, int priority);
+};
+
+readaheadproc::readaheadproc(struct rastate *state, uid_t uid, int priority)
+    : vproc("ReadAhead", NULL, VPT_ReadAhead, ReadAheadStackSize)
+{
+    ra           = state;
+    u.u_uid      = uid;
+    u.u_priority = priority;
+
+    start_thread();
+}
+
+void readaheadproc::main(void)
+{
+    VenusFid fid  = ra->fid;
+    uint64_t pos  = ra->start;
+    int64_t count = ra->end - ra->start;
+    fsobj *f;
+
+    Begin_VFS(&fid, CODA_ACCESS_INTENT, VM_OBSERVING);
+    if (!u.u_error) {
+        ra->active = 1;
+
+        f = FSDB->Find(&fid);
+        if (f && f->ReadIntent(u.u_uid, u.u_priority, pos, count) == 0)
+            f->ReadIntentFinish(pos, count);
+
+        End_VFS(NULL);
+    }
+
+    LOG(10, ("readaheadproc: fid = %s, pos = %lu, count = %ld, done\n",
+             FID_(&fid), pos, count));
+
+    ra->active = 0;
+    ra->end    = 0;
+    VprocSignal(&ra->sync);
+}
+
+/* Called after a successful read of [pos, pos + count), starts reading ahead
+ * when the file is being read sequentially and less than half a window of
+ * data is left in front of the reader */
+static void ReadAhead(fsobj *f, VenusFid *fid, uid_t uid, int priority,
+                      uint64_t pos, int64_t count)
+{
+    struct rastate *ra;
+    uint64_t end, start, len;
+
+    if (!ReadAheadMax || count <= 0)
+        return;
+
+    ra = GetReadAhead(fid, 1);
+    if (!ra)
+        return;
+
+    end = pos + count;
+    if (pos != ra->next) {
+        ra->next   = end;
+        ra->window = 0;
+        ra->mark   = 0;
+        return;
+    }
+    ra->next = end;
+
+    if (!ra->window)
+        ra->window = align_to_ccblock_ceil(2 * count);
+    else if (ra->window < ReadAheadMax)
+        ra->window *= 2;
+    if (ra->window > ReadAheadMax)
+        ra->window = align_to_ccblock_ceil(ReadAheadMax);
+
+    if (ra->end || (ra->mark > end && ra->mark - end > ra->window / 2))
+        return;
+
+    start = ra->mark > end ? ra->mark : end;
+    if (start >= f->Size())
+        return;
+
+    len = ra->window;
+    if (start + len > f->Size())
+        len = f->Size() - start;
+
+    ra->start = start;
+    ra->end   = start + len;
+    ra->mark  = start + len;
+    (void)new readaheadproc(ra, uid, priority);
+}
+
 void vproc::read(struct venus_cnode *node, uint64_t pos, int64_t count)
 {
     LOG(1, ("vproc::read: fid = %s, pos = %d, count = %d\n", FID_(&node->c_fid),
             pos, count));
 
     fsobj *f = NULL;
+    struct rastate *ra;
 
     Begin_VFS(&node->c_fid, CODA_ACCESS_INTENT, VM_OBSERVING);
     if (u.u_error)
         return;
 
+    /* Wait for a readahead of the data we need, but only when it already
+     * got into the volume, we would otherwise fetch it ourselves */
+    ra = GetReadAhead(&node->c_fid, 0);
+    while (ra && ra->active && pos < ra->end &&
+           (count < 0 || pos + count > ra->start))
+        VprocWait(&ra->sync);
+
     /* Get the object. */
     f = FSDB->Find(&node->c_fid);
     if (!f) {
@@ -1646,6 +1796,13 @@ void vproc::read(struct venus_cnode *node, uint64_t pos, int64_t count)
     /* Perform the read access intent */
     u.u_error = f->ReadIntent(u.u_uid, u.u_priority, pos, count);
 
+    if (!u.u_error)
+        ReadAhead(f, &node->c_fid, u.u_uid, u.u_priority, pos, count);
+    /* The kernel stops sending intents for this file when they are not
+     * supported, we still need to see the first write. */
+    else if (u.u_error == EOPNOTSUPP && f->NeedSignature())
+        u.u_error = 0;
+
 FreeVFS:
     End_VFS(NULL);
 }
@@ -1671,6 +1828,9 @@ void vproc::write(struct venus_cnode *node, uint64_t pos, int64_t count)
     if (f->IsPioctlFile())
         goto FreeVFS;
 
+    /* Describe a clean file before it is modified. */
+    f->MakeSignature();
+
     if (!ISVASTRO(f)) {
         u.u_error = EOPNOTSUPP;
         goto FreeVFS;
@@ -1758,6 +1918,9 @@ void vproc::mmap(struct venus_cnode *node, uint64_t pos, int64_t count)
         goto FreeVFS;
     }
 
+    /* A shared mapping may be written to without further notice. */
+    f->MakeSignature();
+
     /* Perform a read access intent to make sure the file content is cached */
     u.u_error = f->ReadIntent(u.u_uid, u.u_priority, pos, count);
 
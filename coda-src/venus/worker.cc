@@ -47,6 +47,7 @@ extern "C" {
 #include <unistd.h>
 #include <stdlib.h>
 #include <fcntl.h>
+#include <poll.h>
 
 #ifdef __FreeBSD__
 #include <sys/param.h>
@@ -119,6 +120,7 @@ const int WorkerStackSize = 131072;
 
 int MaxWorkers     = UNSET_MAXWORKERS;
 int MaxPrefetchers = UNSET_MAXWORKERS;
+int UpcallBatch    = 0;
 static int Mounted = 0;
 
 /* Only for the crazy people among us.
@@ -182,8 +184,8 @@ msgent *AllocMsgent(void)
     return m;
 }
 
-/* read a msg from the given socket */
-void ReadUpcallMsg(int fd, size_t size)
+/* read a msg from the given socket, returns -1 when nothing was read */
+int ReadUpcallMsg(int fd, size_t size)
 {
     msgent *m = AllocMsgent();
     ssize_t len;
@@ -197,7 +199,7 @@ void ReadUpcallMsg(int fd, size_t size)
     if (len < (ssize_t)sizeof(struct coda_in_hdr)) {
         eprint("Failed to read upcall");
         worker::FreeMsgs.append(m);
-        return;
+        return -1;
     }
 
     if (fd != worker::muxfd) {
@@ -215,6 +217,7 @@ void ReadUpcallMsg(int fd, size_t size)
 
     m->return_fd = fd;
     DispatchWorker(m);
+    return 0;
 }
 
 ssize_t WriteDowncallMsg(int fd, const char *buf, size_t size)
@@ -780,6 +783,9 @@ void WorkerInit()
         exit(EXIT_FAILURE);
     }
 
+    if (UpcallBatch < 1)
+        UpcallBatch = 1;
+
 #ifdef __CYGWIN32__
     int sd[2];
     if (socketpair(AF_LOCAL, SOCK_STREAM, 0, sd)) {
@@ -984,9 +990,27 @@ void WorkerMux(int fd, void *udata)
     len = read(fd, (char *)&msg_size, sizeof(msg_size));
     CODA_ASSERT(len == sizeof(msg_size));
     size = msg_size;
-#endif
 
     ReadUpcallMsg(fd, size);
+#else
+    struct pollfd pfd;
+    int i;
+
+    /* A busy client tends to have several upcalls queued up by the time we
+     * get woken up. Drain them all and hand them to idle workers before we
+     * yield, so the workers run back to back and we avoid going through the
+     * select loop once for every single upcall. */
+    pfd.fd     = fd;
+    pfd.events = POLLIN;
+    for (i = 0; i < UpcallBatch; i++) {
+        if (i && (poll(&pfd, 1, 0) <= 0 || !(pfd.revents & POLLIN)))
+            break;
+        if (ReadUpcallMsg(fd, size) < 0)
+            break;
+    }
+    if (i > 1)
+        LOG(100, ("WorkerMux: dispatched %d upcalls\n", i));
+#endif
 }
 
 time_t GetWorkerIdleTime()
@@ -51,17 +51,18 @@ class worker;
 class worker_iterator;
 
 int WorkerCloseMuxfd(void);
-void ReadUpcallMsg(int fd, size_t size);
+int ReadUpcallMsg(int fd, size_t size);
 
 const int DFLT_MAXWORKERS     = 20;
 const int UNSET_MAXWORKERS    = -1;
 const int DFLT_MAXPREFETCHERS = 1;
+const int DFLT_UPCALLBATCH    = 16;
 
 class msgent : public olink {
     friend msgent *FindMsg(olist &, u_long);
     friend worker *FindWorker(u_long);
     friend msgent *AllocMsgent(void);
-    friend void ReadUpcallMsg(int fd, size_t size);
+    friend int ReadUpcallMsg(int fd, size_t size);
     friend void DispatchWorker(msgent *);
     friend int IsAPrefetch(msgent *);
     friend class worker;
@@ -95,7 +96,7 @@ class worker : public vproc {
     friend worker *GetIdleWorker();
     friend void DispatchWorker(msgent *);
     friend msgent *AllocMsgent(void);
-    friend void ReadUpcallMsg(int fd, size_t size);
+    friend int ReadUpcallMsg(int fd, size_t size);
     friend ssize_t WriteDowncallMsg(int fd, const char *buf, size_t size);
     friend ssize_t MsgWrite(const char *msg, size_t size);
     friend void WorkerMux(int fd, void *udata);
@@ -193,6 +194,7 @@ public:
 
 extern int MaxWorkers;
 extern int MaxPrefetchers;
+extern int UpcallBatch;
 
 extern msgent *FindMsg(olist &, u_long);
 extern int k_Purge();
@@ -374,8 +374,9 @@ void CLIENT_CleanUpHost(HostTable *ht)
         RPC2_Unbind(ht->id);
         ht->id = 0;
     }
-    ht->host.s_addr = INADDR_ANY;
-    ht->port        = 0;
+    ht->host.s_addr  = INADDR_ANY;
+    ht->port         = 0;
+    ht->NoFetchDelta = 0;
 }
 
 /* This needs to be called with ht->lock taken!! */
@@ -50,6 +50,7 @@ extern "C" {
 #include <callback.h>
 #include <vice.h>
 #include <cml.h>
+#include <lka.h>
 
 #ifdef __cplusplus
 }
@@ -181,6 +182,8 @@ static int GetReintegrateObjects(ClientEntry *, struct dllist_head *, dlist *,
 static int CheckSemanticsAndPerform(ClientEntry *, VolumeId, VolumeId,
                                     struct dllist_head *, dlist *, int *,
                                     RPC2_Integer *) EXCLUDES_TRANSACTION;
+static int BackFetchDelta(ClientEntry *, HostTable *, Volume *, vle *,
+                          struct rle *);
 static void PutReintegrateObjects(int, Volume *, struct dllist_head *, dlist *,
                                   int, RPC2_Integer, ClientEntry *,
                                   RPC2_Unsigned, RPC2_Unsigned *, ViceFid *,
@@ -1822,6 +1825,17 @@ static int CheckSemanticsAndPerform(ClientEntry *client, VolumeId Vid,
                     /* Don't fetch intermediate versions. */
                     continue;
 
+                /* Large files that changed a little come as a delta,
+                 * otherwise (or when that fails) fetch the whole file. */
+                errorCode = BackFetchDelta(client, he, volptr, v, r);
+                if (errorCode == 0)
+                    continue;
+                if (errorCode < RPC2_ELIMIT) {
+                    CLIENT_CleanUpHost(he);
+                    index = -1;
+                    goto LockExit;
+                }
+
                 SE_Descriptor sid;
                 memset(&sid, 0, sizeof(SE_Descriptor));
                 sid.Tag                                   = client->SEType;
@@ -1884,6 +1898,81 @@ Exit:
     return (errorCode);
 }
 
+/*
+ * Fetch the new contents of a stored file as a delta against the version
+ * we had before the reintegration, which is still around as f_sinode. The
+ * result is only accepted if it matches the SHA the client computed for the
+ * new contents. Returns 0 when f_finode holds the new contents, errors below
+ * RPC2_ELIMIT mean the client went away, anything else that the whole file
+ * has to be fetched instead.
+ */
+static int BackFetchDelta(ClientEntry *client, HostTable *he, Volume *volptr,
+                          vle *v, struct rle *r)
+{
+    SE_Descriptor sid;
+    uint64_t length = 0;
+    int errorCode, basefd, outfd;
+    FILE *tmp;
+
+    if (r->u.u_store.Length < DELTA_MINSIZE || !v->f_sinode ||
+        he->NoFetchDelta)
+        return EINVAL;
+
+    tmp = tmpfile();
+    if (!tmp)
+        return errno;
+
+    /* A useful delta is smaller than the file itself. */
+    memset(&sid, 0, sizeof(SE_Descriptor));
+    sid.Tag                                   = client->SEType;
+    sid.Value.SmartFTPD.TransmissionDirection = SERVERTOCLIENT;
+    sid.Value.SmartFTPD.SeekOffset            = 0;
+    sid.Value.SmartFTPD.hashmark  = (SrvDebugLevel > 2 ? '#' : '\0');
+    sid.Value.SmartFTPD.ByteQuota = r->u.u_store.Length;
+    sid.Value.SmartFTPD.Tag       = FILEBYFD;
+
+    sid.Value.SmartFTPD.FileInfo.ByFD.fd = fileno(tmp);
+
+    errorCode = CallBackFetchDelta(he->id, &r->u.u_store.UntranslatedFid, &sid);
+    if (errorCode == RPC2_INVALIDOPCODE) {
+        /* older clients, don't ask them again */
+        SLog(0, "CBFetchDelta: %s doesn't support deltas",
+             inet_ntoa(he->host));
+        he->NoFetchDelta = 1;
+    }
+    if (errorCode) {
+        SLog(2, "CBFetchDelta: failed (%d), fetching all of (%s)", errorCode,
+             FID_(&v->fid));
+        fclose(tmp);
+        return errorCode;
+    }
+
+    basefd = iopen(V_device(volptr), v->f_sinode, O_RDONLY);
+    outfd  = iopen(V_device(volptr), v->f_finode, O_WRONLY | O_TRUNC);
+    rewind(tmp);
+
+    errorCode = EINVAL;
+    if (basefd != -1 && outfd != -1 &&
+        delta_apply(basefd, fileno(tmp), outfd, &length) == 0 &&
+        length == (uint64_t)r->u.u_store.Length)
+        errorCode = 0;
+
+    if (basefd != -1)
+        close(basefd);
+    if (outfd != -1)
+        close(outfd);
+    fclose(tmp);
+
+    if (errorCode)
+        SLog(0, "CBFetchDelta: bad delta for (%s), fetching the whole file",
+             FID_(&v->fid));
+    else
+        SLog(2, "CBFetchDelta: transferred %d bytes for %d (%s)",
+             sid.Value.SmartFTPD.BytesTransferred, r->u.u_store.Length,
+             FID_(&v->fid));
+    return errorCode;
+}
+
 /*
  *
  *    Phase IV consists of the following steps:
@@ -9,10 +9,21 @@
 #vicedir=/vice
 
 #
-# Should the server use private mmaps for RVM
+# Should the server use private mmaps for RVM. With private mmaps the RVM
+# data segment is paged in on demand instead of being read in completely
+# before the server starts serving requests. Raw partitions that cannot be
+# mmapped are still read in at startup.
 #
 #mapprivate=0
 
+#
+# Number of RVM heap blocks that are examined every second when merging
+# adjacent free blocks in the background. This keeps the free space from
+# fragmenting so large allocations do not stall while the whole heap is
+# coalesced. Set to 0 to disable.
+#
+#rds_coalesce=256
+
 #
 # RVM parameters
 #
@@ -93,6 +104,24 @@ allow_sha=1
 #
 #check_reintegration_retry=1
 
+#
+# Maximum number of packets pulled from the network socket with a single
+# system call (up to 32). Batching reduces the number of system calls per
+# received packet on busy servers, the default of 0 reads one packet at a
+# time.
+#
+#rpc2_recvbatch=0
+
+#
+# Maximum number of packets sent with a single system call (up to 32).
+# Replies, acks and SFTP data packets are collected while the server works
+# through the received packets and sent in batches, when supported by the
+# kernel packets for the same client are passed on as a single UDP
+# segmentation offload packet. The default of 0 sends every packet right
+# away.
+#
+#rpc2_xmitbatch=0
+
 #
 # Fork a helper process to handle client-server communication.
 #
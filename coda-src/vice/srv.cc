@@ -187,12 +187,15 @@ static int SrvWindowSize     = 0; // default 32
 static int SrvSendAhead      = 0; // default 8
 static int timeout           = 0; // default 60, formerly 15, 30, then 60
 static int retrycnt          = 0; // default 5, formerly 4, 20, then 6
+static int recvbatch         = 0; // default 0
+static int xmitbatch         = 0; // default 0
 static int debuglevel        = 0; // Command line set only.
 static int auth_lwps         = 0; // default 5
 static int server_lwps       = 0; // default 10
 int stack                    = 0; // default 96
 static int cbwait            = 0; // default 240
 static int chk               = 0; // default 30
+static int rdscoalesce       = 0; // default 256
 static int ForceSalvage      = 0; // default 1
 static int SalvageOnShutdown = 0; // default 0 */
 static int datalen           = 0;
@@ -242,6 +245,7 @@ static void AuthLWP(void *);
 static void ServerLWP(void *);
 static void ResLWP(void *);
 static void CallBackCheckLWP(void *) EXCLUDES_TRANSACTION;
+static void CoalesceLWP(void *) EXCLUDES_TRANSACTION;
 
 static void ClearCounters();
 static void FileMsg();
@@ -539,6 +543,8 @@ int main(int argc, char *argv[]) EXCLUDES_TRANSACTION
     sei.Port.Value.InetPortNumber = s->s_port;
 
     SFTP_Activate(&sei);
+    RPC2_RecvBatch = recvbatch;
+    RPC2_XmitBatch = xmitbatch;
     CODA_ASSERT(RPC2_Init(RPC2_VERSION, 0, &port1, retrycnt,
                           srv_rpc2_timeout()) == RPC2_SUCCESS);
     RPC2_InitTraceBuffer(trace);
@@ -596,6 +602,12 @@ int main(int argc, char *argv[]) EXCLUDES_TRANSACTION
                                   LWP_NORMAL_PRIORITY, (void *)&cbwait,
                                   "CheckCallBack", &serverPid) == LWP_SUCCESS);
 
+    if (rdscoalesce > 0) {
+        rc = LWP_CreateProcess(CoalesceLWP, stack * 1024, LWP_NORMAL_PRIORITY,
+                               NULL, "CoalesceLWP", &serverPid);
+        CODA_ASSERT(rc == LWP_SUCCESS);
+    }
+
     for (i = 0; i < auth_lwps; i++) {
         n = snprintf(sname, sizeof(sname), "AuthLWP-%d", i);
         CODA_ASSERT(n >= 0 && n < (int)sizeof(sname));
@@ -933,6 +945,25 @@ static void CallBackCheckLWP(void *arg)
     }
 }
 
+/* Merge free space in the recoverable heap a few blocks at a time, so that
+ * large allocations do not have to coalesce the whole heap in one go. */
+static void CoalesceLWP(void *arg)
+{
+    struct timeval time;
+    int err;
+
+    SLog(1, "Starting Coalesce process");
+
+    while (1) {
+        time.tv_sec  = 1;
+        time.tv_usec = 0;
+        IOMGR_Select(0, 0, 0, 0, &time);
+
+        if (rds_coalesce_step(rdscoalesce, &err) < 0)
+            SLog(0, "rds_coalesce_step failed (%d)", err);
+    }
+}
+
 static void ShutDown()
 {
     int fd;
@@ -1133,6 +1164,16 @@ void PrintCounters(FILE *fp)
          rpc2_PBCount, rpc2_PBHoldCount, rpc2_PBFreezeCount,
          rpc2_PBSmallFreeCount, rpc2_PBMediumFreeCount, rpc2_PBLargeFreeCount);
     SLog(0, "RPC2 HW:  Freeze %d, Hold %d", rpc2_FreezeHWMark, rpc2_HoldHWMark);
+    SLog(0,
+         "RPC2 Recv batches: Wakeups %d, Calls %d, Packets %d, Full %d, Largest %d",
+         rpc2_RecvBatched.Wakeups, rpc2_RecvBatched.Calls,
+         rpc2_RecvBatched.Packets, rpc2_RecvBatched.Full,
+         rpc2_RecvBatched.Largest);
+    SLog(0,
+         "RPC2 Xmit batches: Flushes %d, Calls %d, Packets %d, Coalesced %d, Largest %d",
+         rpc2_XmitBatched.Flushes, rpc2_XmitBatched.Calls,
+         rpc2_XmitBatched.Packets, rpc2_XmitBatched.Coalesced,
+         rpc2_XmitBatched.Largest);
     SLog(
         0,
         "SFTP:	datas %d, datar %d, acks %d, ackr %d, retries %d, duplicates %d",
@@ -1458,6 +1499,8 @@ static int ReadConfigFile(void)
     CODACONF_INT(SrvSendAhead, "sendahead", 8);
     CODACONF_INT(timeout, "timeout", 60);
     CODACONF_INT(retrycnt, "retrycnt", 5);
+    CODACONF_INT(recvbatch, "rpc2_recvbatch", 0);
+    CODACONF_INT(xmitbatch, "rpc2_xmitbatch", 0);
     CODACONF_INT(auth_lwps, "auth_lwps", 5);
     CODACONF_INT(server_lwps, "lwps", 10);
     if (server_lwps > MAXLWP)
@@ -1466,6 +1509,7 @@ static int ReadConfigFile(void)
     CODACONF_INT(stack, "stack", 96);
     CODACONF_INT(cbwait, "cbwait", 240);
     CODACONF_INT(chk, "chk", 30);
+    CODACONF_INT(rdscoalesce, "rds_coalesce", 256);
     CODACONF_INT(ForceSalvage, "forcesalvage", 1);
     CODACONF_INT(SalvageOnShutdown, "salvageonshutdown", 0);
     CODACONF_INT(DumpVM, "dumpvm", 0);
@@ -1766,7 +1810,8 @@ static void InitializeServerRVM(const char *name)
         rvm_options_t *options = rvm_malloc_options();
 
         options->log_dev = tmp = strdup(_Rvm_Log_Device);
-        options->flags         = optimizationson;
+        options->flags         = optimizationson | RVM_GROUP_COMMIT;
+        options->flags |= RVM_ASYNC_IO;
 
         if (MapPrivate)
             options->flags |= RVM_MAP_PRIVATE;
@@ -97,6 +97,7 @@ extern "C" {
 #include <repio.h>
 #include <codadir.h>
 #include <operations.h>
+#include <dirattrs.h>
 #include <lockqueue.h>
 #include <resutil.h>
 #include <ops.h>
@@ -535,6 +536,226 @@ Exit:
     return (errorCode);
 }
 
+/*
+  ViceGetDirAttrs: Fetch the attributes of a directory and of all its entries
+*/
+
+/* Entries of the directory, collected before the vnodes are looked at. */
+struct DirAttrsEntry {
+    ViceFid Fid;
+    char *Name;
+};
+
+struct DirAttrsHook {
+    VolumeId Volume;
+    struct DirAttrsEntry *Entries;
+    int Count;
+    int Size;
+    int Length; /* bytes needed to ship all records */
+};
+
+static int CollectDirAttrsEntry(struct DirEntry *de, void *hook)
+{
+    struct DirAttrsHook *h = (struct DirAttrsHook *)hook;
+    struct DirAttrsEntry *e;
+    ViceStatus status;
+    BUFFER buffer = {};
+
+    if (STREQ(de->name, ".") || STREQ(de->name, ".."))
+        return 0;
+
+    if (h->Count == h->Size) {
+        h->Size    = h->Size ? 2 * h->Size : 64;
+        h->Entries = (struct DirAttrsEntry *)realloc(
+            h->Entries, h->Size * sizeof(struct DirAttrsEntry));
+        CODA_ASSERT(h->Entries);
+    }
+
+    e             = &h->Entries[h->Count++];
+    e->Fid.Volume = h->Volume;
+    FID_NFid2Int(&de->fid, &e->Fid.Vnode, &e->Fid.Unique);
+    e->Name = strdup(de->name);
+    CODA_ASSERT(e->Name);
+
+    memset(&status, 0, sizeof(ViceStatus));
+    pack_dirattrs(&buffer, e->Name, h->Volume, &e->Fid, &status);
+    h->Length += (intptr_t)buffer.buffer;
+    return 0;
+}
+
+/* The reply is a sequence of records as packed by pack_dirattrs, with the
+   fids in the volume the client asked for. Entries that can't be read (f.i.
+   inconsistent objects or directories the caller has no rights on) are left
+   out, the client falls back to ViceGetAttr for those. */
+long FS_ViceGetDirAttrs(RPC2_Handle RPCid, ViceFid *Fid, ViceStatus *Status,
+                        RPC2_Unsigned MaxLength, RPC2_Unsigned *Count,
+                        RPC2_CountedBS *PiggyBS,
+                        SE_Descriptor *BD) EXCLUDES_TRANSACTION
+{
+    int errorCode       = 0; /* return code to caller */
+    Volume *volptr      = 0; /* pointer to the volume */
+    ClientEntry *client = 0; /* pointer to the client data */
+    Rights rights       = 0; /* rights for this user */
+    Rights anyrights    = 0; /* rights for any user */
+    VolumeId VSGVolnum  = Fid->Volume;
+    int voltype;
+    dlist *vlist = new dlist((CFN)VLECmp);
+    vle *v       = 0;
+    vle *av      = 0;
+    struct DirAttrsHook hook;
+    BUFFER buffer = {};
+    char *buf     = NULL;
+    int size      = 0;
+    int i;
+
+    START_TIMING(GetDirAttrs_Total);
+    SLog(1, "ViceGetDirAttrs: Fid = %s, MaxLength = %u", FID_(Fid), MaxLength);
+
+    *Count = 0;
+    memset(&hook, 0, sizeof(hook));
+
+    /* Validate parameters. */
+    {
+        if ((errorCode = ValidateParms(RPCid, &client, &voltype, &Fid->Volume,
+                                       PiggyBS, NULL)))
+            goto FreeLocks;
+
+        if (!ISDIR(*Fid)) {
+            errorCode = ENOTDIR;
+            goto FreeLocks;
+        }
+    }
+
+    /* Get objects. */
+    errorCode = GetFsoAndParent(Fid, vlist, &volptr, &v, &av, READ_LOCK,
+                                NO_LOCK, 0);
+    if (errorCode)
+        goto FreeLocks;
+
+    /* Check semantics. */
+    {
+        /* Same as fetching the directory, this needs lookup rights. */
+        if ((errorCode = CheckFetchSemantics(client, &av->vptr, &v->vptr,
+                                             &volptr, &rights, &anyrights)))
+            goto FreeLocks;
+    }
+
+    /* Perform operation. */
+    {
+        PDirHandle dh;
+
+        PerformGetAttr(client, volptr, v->vptr);
+
+        SetStatus(v->vptr, Status, rights, anyrights);
+
+        if (VolumeWriteable(volptr))
+            Status->CallBack = CodaAddCallBack(client->VenusId, Fid, VSGVolnum);
+
+        hook.Volume = Fid->Volume;
+        dh          = VN_SetDirHandle(v->vptr);
+        DH_EnumerateDir(dh, CollectDirAttrsEntry, (void *)&hook);
+        VN_PutDirHandle(v->vptr);
+
+        size = hook.Length;
+        if ((RPC2_Unsigned)size > MaxLength)
+            size = MaxLength;
+        if (size) {
+            buf = (char *)malloc(size);
+            CODA_ASSERT(buf);
+        }
+        buffer.who    = RP2_SERVER;
+        buffer.buffer = buf;
+        buffer.eob    = buf + size;
+
+        for (i = 0; i < hook.Count; i++) {
+            struct DirAttrsEntry *e = &hook.Entries[i];
+            Vnode *cvptr            = 0;
+            Rights crights          = rights;
+            Rights canyrights       = anyrights;
+            ViceStatus cstatus;
+            BUFFER probe = {};
+            Error fileCode;
+
+            /* Stop when the record doesn't fit in the reply anymore. */
+            pack_dirattrs(&probe, e->Name, VSGVolnum, &e->Fid, Status);
+            if (buffer.buffer + (intptr_t)probe.buffer > buffer.eob)
+                break;
+
+            if (GetFsObj(&e->Fid, &volptr, &cvptr, READ_LOCK, NO_LOCK, 0, 0,
+                         0))
+                continue;
+
+            /* Directories are protected by their own access list, leave
+               out the ones the caller may not look at. */
+            if (cvptr->disk.type == vDirectory &&
+                CheckGetAttrSemantics(client, &cvptr, &cvptr, &volptr, &crights,
+                                      &canyrights)) {
+                VPutVnode(&fileCode, cvptr);
+                continue;
+            }
+
+            SetStatus(cvptr, &cstatus, crights, canyrights);
+            VPutVnode(&fileCode, cvptr);
+
+            if (VolumeWriteable(volptr))
+                cstatus.CallBack =
+                    CodaAddCallBack(client->VenusId, &e->Fid, VSGVolnum);
+
+            pack_dirattrs(&buffer, e->Name, VSGVolnum, &e->Fid, &cstatus);
+            (*Count)++;
+        }
+        size = buffer.buffer - buf;
+    }
+
+    /* Ship the records. */
+    {
+        SE_Descriptor sid;
+        memset(&sid, 0, sizeof(SE_Descriptor));
+        sid.Tag                                   = client->SEType;
+        sid.Value.SmartFTPD.TransmissionDirection = SERVERTOCLIENT;
+        sid.Value.SmartFTPD.SeekOffset            = 0;
+        sid.Value.SmartFTPD.hashmark  = (SrvDebugLevel > 2 ? '#' : '\0');
+        sid.Value.SmartFTPD.ByteQuota = -1;
+        sid.Value.SmartFTPD.Tag       = FILEINVM;
+        sid.Value.SmartFTPD.FileInfo.ByAddr.vmfile.SeqLen    = size;
+        sid.Value.SmartFTPD.FileInfo.ByAddr.vmfile.MaxSeqLen = size;
+        sid.Value.SmartFTPD.FileInfo.ByAddr.vmfile.SeqBody = (RPC2_ByteSeq)buf;
+
+        if ((errorCode = (int)RPC2_InitSideEffect(RPCid, &sid)) <=
+            RPC2_ELIMIT) {
+            SLog(0, "ViceGetDirAttrs: InitSE failed (%d), %s", errorCode,
+                 FID_(Fid));
+            goto FreeLocks;
+        }
+
+        if ((errorCode = (int)RPC2_CheckSideEffect(
+                 RPCid, &sid, SE_AWAITLOCALSTATUS)) <= RPC2_ELIMIT) {
+            SLog(0, "ViceGetDirAttrs: CheckSE failed (%d), %s", errorCode,
+                 FID_(Fid));
+            if (errorCode == RPC2_SEFAIL1)
+                errorCode = EIO;
+            goto FreeLocks;
+        }
+        errorCode = 0;
+    }
+
+FreeLocks:
+    /* Put objects. */
+    {
+        PutObjects(errorCode, volptr, NO_LOCK, vlist, 0, 0);
+    }
+
+    for (i = 0; i < hook.Count; i++)
+        free(hook.Entries[i].Name);
+    free(hook.Entries);
+    free(buf);
+
+    SLog(2, "ViceGetDirAttrs returns %s, %u of %d entries",
+         ViceErrorMsg(errorCode), *Count, hook.Count);
+    END_TIMING(GetDirAttrs_Total);
+    return (errorCode);
+}
+
 /*
   ViceGetACL: Fetch the acl of a directory
 */
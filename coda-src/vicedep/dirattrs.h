@@ -0,0 +1,68 @@
+/* BLURB lgpl
+
+                           Coda File System
+                              Release 8
+
+          Copyright (c) 1987-2021 Carnegie Mellon University
+                  Additional copyrights listed below
+
+This  code  is  distributed "AS IS" without warranty of any kind under
+the  terms of the  GNU  Library General Public Licence  Version 2,  as
+shown in the file LICENSE. The technical and financial contributors to
+Coda are listed in the file CREDITS.
+
+                        Additional copyrights
+                           none currently
+
+#*/
+
+#ifndef _DIRATTRS_H_
+#define _DIRATTRS_H_ 1
+
+/*
+ * dirattrs.h
+ *	Records of the ViceGetDirAttrs reply, shared by server and client.
+ *
+ * Each directory entry is shipped as its name (a counted, NUL terminated
+ * string), its fid and its status. The fids carry the volume id the client
+ * asked for, servers look objects up in the translated read/write volume.
+ */
+
+#include <string.h>
+#include <vcrcommon.h>
+
+/* Pack one record, with buf->eob == NULL this only advances buf->buffer by
+ * the size of the record. The fid is shipped with volume id vid. */
+static inline int pack_dirattrs(BUFFER *buf, const char *name, VolumeId vid,
+                                ViceFid *fid, ViceStatus *status)
+{
+    RPC2_CountedBS bs;
+    ViceFid vfid = *fid;
+
+    bs.SeqLen   = strlen(name) + 1;
+    bs.SeqBody  = (RPC2_ByteSeq)name;
+    vfid.Volume = vid;
+
+    if (pack_countedbs(buf, &bs) || pack_struct_ViceFid(buf, &vfid) ||
+        pack_struct_ViceStatus(buf, status))
+        return -1;
+    return 0;
+}
+
+/* Unpack one record, fails when it is truncated or malformed or when the
+ * fid is not in volume vid. */
+static inline int unpack_dirattrs(BUFFER *buf, VolumeId vid,
+                                  RPC2_CountedBS *name, ViceFid *fid,
+                                  ViceStatus *status)
+{
+    if (unpack_countedbs(buf, name) || unpack_struct_ViceFid(buf, fid) ||
+        unpack_struct_ViceStatus(buf, status))
+        return -1;
+
+    if (name->SeqLen == 0 || name->SeqBody[name->SeqLen - 1] != '\0' ||
+        fid->Volume != vid)
+        return -1;
+    return 0;
+}
+
+#endif /* _DIRATTRS_H_ */
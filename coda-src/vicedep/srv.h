@@ -119,6 +119,7 @@ typedef struct HostTable {
     time_t LastCall; /* time of last call from host	*/
     time_t ActiveCall; /* time of any call but gettime	*/
     struct Lock lock; /* lock used for client sync	*/
+    int NoFetchDelta; /* client lacks CallBackFetchDelta	*/
 } HostTable;
 
 typedef struct ClientEntry {
@@ -131,8 +131,12 @@ void FSYNC_fsInit()
 static void FSYNC_sync(void *arg)
 {
     LogMsg(9, VolDebugLevel, stdout, "Entering FSYNC_sync()");
-    while (!VInit) // Wait for fileserver initialization to complete
+    /* Wait for fileserver initialization to complete, poll so that threads
+     * waiting for I/O (asynchronous RVM log writes) can make progress */
+    while (!VInit) {
+        IOMGR_Poll();
         LWP_DispatchProcess();
+    }
     InitUtilities();
     while (1) {
         struct timeval *timep, timeout;
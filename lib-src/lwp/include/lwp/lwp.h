@@ -133,6 +133,13 @@ extern void LWP_ProtectStacks();
 #define LWP_SignalProcess(event) LWP_INTERNALSIGNAL(event, 1)
 #define LWP_NoYieldSignal(event) LWP_INTERNALSIGNAL(event, 0)
 
+/* Number of kernel threads that run concurrent processes, the default of 0
+   starts one per processor up to a maximum of 8. */
+extern int lwp_concurrency;
+
+/* PRE_Concurrent(1) moves the calling process to a worker thread, where it
+   runs in parallel with the other LWPs until PRE_Concurrent(0). Only use
+   it around thread-safe code. */
 void PRE_Concurrent(int on);
 void PRE_BeginCritical(void);
 void PRE_EndCritical(void);
@@ -141,6 +148,7 @@ void PRE_EndCritical(void);
 extern int IOMGR_SoftSig(void (*aproc)(void *), char *arock);
 extern int IOMGR_Initialize();
 extern int IOMGR_Finalize();
+extern int IOMGR_Running(void);
 extern int IOMGR_Poll();
 extern int IOMGR_Select(int fds, fd_set *readfds, fd_set *writefds,
                         fd_set *exceptfds, struct timeval *timeout);
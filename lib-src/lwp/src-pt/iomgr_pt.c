@@ -86,6 +86,11 @@ int IOMGR_Finalize()
     return 0;
 }
 
+int IOMGR_Running(void)
+{
+    return 1;
+}
+
 /* signal delivery is not implemented yet */
 int IOMGR_SoftSig(void (*aproc)(void *), char *arock)
 {
@@ -235,6 +235,14 @@ static int IOMGR_CheckDescriptors(int PollingCheck)
             nfds = req->nfds;
     });
 
+    /* Wake up when concurrent processes return to the main thread. */
+    if (lwp_pool_fd >= 0) {
+        FD_SET(lwp_pool_fd, &readfds);
+        rf = 1;
+        if (lwp_pool_fd >= nfds)
+            nfds = lwp_pool_fd + 1;
+    }
+
     /* Set timeout for select syscall. */
     if (PollingCheck) {
         timeout.tv_sec  = 0;
@@ -518,6 +526,13 @@ int IOMGR_Initialize()
     return LWP_CreateProcess(IOMGR, STACK_SIZE, 0, 0, "IO MANAGER", &IOMGR_Id);
 }
 
+/* Returns non-zero once IOMGR_Initialize has been called, before that
+   IOMGR_Select cannot be used to wait for descriptors. */
+int IOMGR_Running(void)
+{
+    return IOMGR_Id != NULL;
+}
+
 int IOMGR_Finalize()
 {
     int status;
@@ -536,6 +551,7 @@ int IOMGR_Finalize()
 int IOMGR_Poll()
 {
     int woke_someone = FALSE;
+    int resume       = lwp_join();
 
     for (;;) {
         /* Check for pending signals. */
@@ -558,6 +574,7 @@ int IOMGR_Poll()
         break;
     }
 
+    lwp_leave(resume);
     return (woke_someone);
 }
 
@@ -565,7 +582,7 @@ int IOMGR_Select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds,
                  struct timeval *timeout)
 {
     struct IoRequest *request;
-    int result, i;
+    int result, i, resume;
 
     /* See if polling request. If so, handle right here */
     if (timeout != NULL && timeout->tv_sec == 0 && timeout->tv_usec == 0) {
@@ -574,6 +591,9 @@ int IOMGR_Select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds,
         return (result);
     }
 
+    /* requests are queued and waited for on the main thread */
+    resume = lwp_join();
+
     /* Construct request block & insert */
     request = NewRequest();
 
@@ -639,15 +659,19 @@ int IOMGR_Select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds,
     result = request->result;
     FreeRequest(request);
 
+    lwp_leave(resume);
     return (result);
 }
 
 int IOMGR_Cancel(PROCESS pid)
 {
     struct IoRequest *request;
+    int resume = lwp_join();
 
-    if ((request = pid->iomgrRequest) == 0)
+    if ((request = pid->iomgrRequest) == 0) {
+        lwp_leave(resume);
         return -1;
+    }
 
     request->nfds = 0;
     FD_ZERO(&request->readfds);
@@ -658,6 +682,7 @@ int IOMGR_Cancel(PROCESS pid)
     LWP_QSignal(request->pid);
     pid->iomgrRequest = 0;
 
+    lwp_leave(resume);
     return 0;
 }
 
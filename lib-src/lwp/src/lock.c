@@ -227,65 +227,83 @@ void Lock_ReleaseW(struct Lock *lock)
 
 /*  Previously these were macros. You can't stop a debugger on a macro,
     so I changed them to inline functions.
+
+    Concurrent processes briefly return to the main thread to take and
+    release locks, see PRE_Concurrent().
 */
 
 void ObtainReadLock(struct Lock *lock)
 {
+    int resume = lwp_join();
     PROCESS me = LWP_ThisProcess();
 
-    if (!(lock->excl_locked & WRITE_LOCK) && !(lock)->wait_states) {
+    if (!(lock->excl_locked & WRITE_LOCK) && !(lock)->wait_states)
         lock->readers_reading++;
-        return;
-    }
-    if ((lock->excl_locked & WRITE_LOCK) && lock->excl_locker == me) {
+    else if ((lock->excl_locked & WRITE_LOCK) && lock->excl_locker == me)
         lock->readers_reading++;
-        return;
-    } else
+    else
         Lock_Obtain(lock, READ_LOCK);
+
+    lwp_leave(resume);
 }
 
 void ObtainWriteLock(struct Lock *lock)
 {
+    int resume = lwp_join();
     PROCESS me = LWP_ThisProcess();
 
     if (!(lock)->excl_locked && !(lock)->readers_reading) {
         lock->excl_locked = WRITE_LOCK;
         lock->excl_locker = me;
-        return;
-    }
-    if ((lock->excl_locked & WRITE_LOCK) && lock->excl_locker == me)
-        return;
-    Lock_Obtain(lock, WRITE_LOCK);
-    return;
+    } else if (!(lock->excl_locked & WRITE_LOCK) || lock->excl_locker != me)
+        Lock_Obtain(lock, WRITE_LOCK);
+
+    lwp_leave(resume);
 }
 
 void ObtainSharedLock(struct Lock *lock)
 {
+    int resume = lwp_join();
+
     if (!(lock)->excl_locked && !(lock)->wait_states)
         (lock)->excl_locked = SHARED_LOCK;
     else
         Lock_Obtain(lock, SHARED_LOCK);
+
+    lwp_leave(resume);
 }
 
 void ReleaseReadLock(struct Lock *lock)
 {
+    int resume = lwp_join();
+
     if (!--(lock)->readers_reading && (lock)->wait_states)
         Lock_ReleaseW(lock);
+
+    lwp_leave(resume);
 }
 
 void ReleaseWriteLock(struct Lock *lock)
 {
+    int resume = lwp_join();
+
     if ((lock)->wait_states)
         Lock_ReleaseR(lock);
     (lock)->excl_locked &= ~WRITE_LOCK;
+
+    lwp_leave(resume);
 }
 
 /* can be used on shared or boosted (write) locks */
 void ReleaseSharedLock(struct Lock *lock)
 {
+    int resume = lwp_join();
+
     if ((lock)->wait_states)
         Lock_ReleaseR(lock);
     (lock)->excl_locked &= ~(SHARED_LOCK | WRITE_LOCK);
+
+    lwp_leave(resume);
 }
 
 int CheckLock(struct Lock *lock)
@@ -70,6 +70,7 @@ Pittsburgh, PA.
 #define OFF 0
 #define READY 2
 #define WAITING 3
+#define CONCURRENT 4 /* running on a worker thread, see pool.c */
 #define MINSTACK 32768 /* allocate at least 32KB for stacks */
 #define STACKPAD 4096 /* pad any requested stack size to PAGE_SIZE */
 #ifndef MAX
@@ -94,15 +95,18 @@ char *lwp_stackbase = (char *)0x15000000;
 struct QUEUE {
     PROCESS head;
     int count;
-} runnable[MAX_PRIORITIES], blocked;
+} runnable[MAX_PRIORITIES], blocked, concurrent;
 
 #define REAPER_STACKSIZE 32768
 #define TRACER_STACKSIZE 32768
+#define MIGRATOR_STACKSIZE 32768
 
 static struct lwp_ucontext reaper; /* reaper context, see lwp_Reaper() */
 static char reaper_stack[REAPER_STACKSIZE];
 static struct lwp_ucontext tracer; /* context for the stack tracing thread */
 static char tracer_stack[TRACER_STACKSIZE];
+static struct lwp_ucontext migrator; /* hands processes to the workers */
+static char migrator_stack[MIGRATOR_STACKSIZE];
 
 /* Invariant for runnable queues: The head of each queue points to the
 currently running process if it is in that queue, or it points to the
@@ -215,6 +219,27 @@ static void lwpmove(PROCESS p, struct QUEUE *from, struct QUEUE *to)
     lwpinsert(p, to);
 }
 
+/* returns the QUEUE a PROCESS p is on */
+static struct QUEUE *lwpqueue(PROCESS p)
+{
+    switch (p->status) {
+    case WAITING:
+        return &blocked;
+    case CONCURRENT:
+        return &concurrent;
+    default:
+        return &runnable[p->priority];
+    }
+}
+
+/* the current process, which is not lwp_cpptr when called from a worker
+ * thread */
+static PROCESS lwp_self(void)
+{
+    PROCESS pid = lwp_pool_self();
+    return pid ? pid : lwp_cpptr;
+}
+
 int LWP_TerminateProcessSupport(void) /* terminate all LWP support */
 {
     int i;
@@ -230,6 +255,7 @@ int LWP_TerminateProcessSupport(void) /* terminate all LWP support */
     for (i = 0; i < MAX_PRIORITIES; i++)
         for_all_elts(cur, runnable[i], { Free_PCB(cur); });
     for_all_elts(cur, blocked, { Free_PCB(cur); });
+    /* concurrent processes are still running, leave them alone */
     free((char *)lwp_init);
     lwp_init = NULL;
 
@@ -243,12 +269,13 @@ int LWP_GetRock(int Tag, char **Value)
             LWP_SUCCESS    if specified rock exists and Value has been filled
             LWP_EBADROCK   rock specified does not exist
     */
+    PROCESS pid = lwp_self();
     int i;
     struct rock *ra;
 
-    ra = lwp_cpptr->rlist;
+    ra = pid->rlist;
 
-    for (i = 0; i < lwp_cpptr->rused; i++)
+    for (i = 0; i < pid->rused; i++)
         if (ra[i].tag == Tag) {
             *Value = ra[i].value;
             return (LWP_SUCCESS);
@@ -270,21 +297,22 @@ int LWP_NewRock(int Tag, char *Value)
         clobbering others.  You can always use one level of
         indirection to obtain a rock whose contents can change.  */
 
+    PROCESS pid = lwp_self();
     int i;
     struct rock *ra; /* rock array */
 
-    ra = lwp_cpptr->rlist;
+    ra = pid->rlist;
 
     /* check if rock has been used before */
-    for (i = 0; i < lwp_cpptr->rused; i++)
+    for (i = 0; i < pid->rused; i++)
         if (ra[i].tag == Tag)
             return (LWP_EBADROCK);
 
     /* insert new rock in rock list and increment count of rocks */
-    if (lwp_cpptr->rused < MAXROCKS) {
-        ra[lwp_cpptr->rused].tag   = Tag;
-        ra[lwp_cpptr->rused].value = Value;
-        lwp_cpptr->rused++;
+    if (pid->rused < MAXROCKS) {
+        ra[pid->rused].tag   = Tag;
+        ra[pid->rused].value = Value;
+        pid->rused++;
         return (LWP_SUCCESS);
     } else
         return (LWP_ENOROCKS);
@@ -293,14 +321,14 @@ int LWP_NewRock(int Tag, char *Value)
 int LWP_CurrentProcess(PROCESS *pid)
 {
     lwpdebug(0, "Entered LWP_CurrentProcess");
-    *pid = lwp_cpptr;
+    *pid = lwp_self();
     return lwp_init ? LWP_SUCCESS : LWP_EINIT;
 }
 
 PROCESS LWP_ThisProcess()
 {
     lwpdebug(0, "Entered LWP_ThisProcess");
-    return lwp_init ? lwp_cpptr : NULL;
+    return lwp_init ? lwp_self() : NULL;
 }
 
 void LWP_SetLog(FILE *file, int level)
@@ -338,12 +366,12 @@ static void Exit_LWP()
 
 char *LWP_Name()
 {
-    return (lwp_cpptr->name);
+    return (lwp_self()->name);
 }
 
 int LWP_Index()
 {
-    return (lwp_cpptr->index);
+    return (lwp_self()->index);
 }
 
 int LWP_HighestIndex()
@@ -429,22 +457,31 @@ static void CheckRunWaitTime(PROCESS thread)
  */
 int LWP_QWait()
 {
-    if (--lwp_cpptr->qpending >= 0)
+    int resume = lwp_join();
+
+    if (--lwp_cpptr->qpending >= 0) {
+        lwp_leave(resume);
         return LWP_SUCCESS;
+    }
 
     lwp_cpptr->status = WAITING;
     lwpmove(lwp_cpptr, &runnable[lwp_cpptr->priority], &blocked);
     timerclear(&lwp_cpptr->lastReady);
     LWP_DispatchProcess();
 
+    lwp_leave(resume);
     return LWP_SUCCESS;
 }
 
 /* signal the PROCESS pid - by adding it to the runnable queue */
 int LWP_QSignal(PROCESS pid)
 {
-    if (++pid->qpending != 0)
+    int resume = lwp_join();
+
+    if (++pid->qpending != 0) {
+        lwp_leave(resume);
         return LWP_ENOWAIT;
+    }
 
     lwpdebug(0, "LWP_Qsignal: %s is going to QSignal %s\n", lwp_cpptr->name,
              pid->name);
@@ -455,6 +492,7 @@ int LWP_QSignal(PROCESS pid)
              pid->name);
     if (timerisset(&run_wait_threshold))
         gettimeofday(&pid->lastReady, NULL);
+    lwp_leave(resume);
     return LWP_SUCCESS;
 }
 
@@ -463,6 +501,7 @@ int LWP_CreateProcess(void (*ep)(void *), int stacksize, int priority,
 {
     PROCESS temp;
     char *stackptr;
+    int resume;
 #ifdef MMAP_LWP_STACKS
     int pagesize;
 #endif
@@ -472,9 +511,14 @@ int LWP_CreateProcess(void (*ep)(void *), int stacksize, int priority,
     if (!lwp_init)
         return LWP_EINIT;
 
+    /* stacks are set up and dispatched from the main thread */
+    resume = lwp_join();
+
     temp = (PROCESS)malloc(sizeof(struct lwp_pcb));
-    if (!temp)
+    if (!temp) {
+        lwp_leave(resume);
         return LWP_ENOMEM;
+    }
 
     if (stacksize < MINSTACK)
         stacksize = MINSTACK;
@@ -508,12 +552,14 @@ int LWP_CreateProcess(void (*ep)(void *), int stacksize, int priority,
 #endif
     if (!stackptr) {
         free(temp);
+        lwp_leave(resume);
         return LWP_ENOMEM;
     }
 
     if (priority < 0 || priority >= MAX_PRIORITIES) {
         munmap(stackptr, stacksize);
         free(temp);
+        lwp_leave(resume);
         return LWP_EBADPRI;
     }
 
@@ -526,6 +572,7 @@ int LWP_CreateProcess(void (*ep)(void *), int stacksize, int priority,
 
     LWP_DispatchProcess();
     *pid = temp;
+    lwp_leave(resume);
     return 0;
 }
 
@@ -542,6 +589,42 @@ static void lwp_Reaper(void *arg)
     /* we never get here */
 }
 
+/* The migrator takes the current process out of the run queues and hands it
+ * to the worker threads once its context has been saved, see
+ * PRE_Concurrent(). */
+static void lwp_Migrator(void *arg)
+{
+    /* See comment in lwp_Reaper() */
+    lwp_getcontext(&migrator);
+    lwp_cpptr->status = CONCURRENT;
+    lwpmove(lwp_cpptr, &runnable[lwp_cpptr->priority], &concurrent);
+    timerclear(&lwp_cpptr->lastReady);
+    lwp_pool_submit(lwp_cpptr);
+    lwp_cpptr = NULL;
+    LWP_DispatchProcess();
+    /* we never get here */
+}
+
+/* Make processes that returned from the worker threads runnable again. */
+static void lwp_Rejoin(int wait)
+{
+    PROCESS pid, next;
+
+    for (pid = lwp_pool_rejoined(wait); pid; pid = next) {
+        next             = pid->pool_next;
+        pid->ctx.uc_link = &reaper;
+
+        if (pid->exited || pid->destroyed) {
+            Free_PCB(pid);
+            continue;
+        }
+        pid->status = READY;
+        lwpmove(pid, &concurrent, &runnable[pid->priority]);
+        if (timerisset(&run_wait_threshold))
+            gettimeofday(&pid->lastReady, NULL);
+    }
+}
+
 static void Dump_One_Process(PROCESS pid, FILE *fp)
 {
     stack_t *stack = &pid->stack;
@@ -558,6 +641,9 @@ static void Dump_One_Process(PROCESS pid, FILE *fp)
     case WAITING:
         fprintf(fp, "WAITING");
         break;
+    case CONCURRENT:
+        fprintf(fp, "CONCURRENT");
+        break;
     default:
         fprintf(fp, "unknown");
     }
@@ -602,6 +688,11 @@ static void lwp_Tracer(void *arg)
         Dump_One_Process(x, lwp_logfile);
         fflush(lwp_logfile);
     });
+    for_all_elts(x, concurrent, {
+        fprintf(lwp_logfile, "[Concurrent]\n");
+        Dump_One_Process(x, lwp_logfile);
+        fflush(lwp_logfile);
+    });
     fprintf(lwp_logfile, "Trace done\n");
 
     /* jump back to the thread that called us */
@@ -619,18 +710,37 @@ static void init_contexts(void)
     tracer.uc_stack.ss_sp   = tracer_stack;
     tracer.uc_stack.ss_size = TRACER_STACKSIZE;
     lwp_makecontext(&tracer, lwp_Tracer, NULL);
+
+    lwp_getcontext(&migrator);
+    migrator.uc_stack.ss_sp   = migrator_stack;
+    migrator.uc_stack.ss_size = MIGRATOR_STACKSIZE;
+    lwp_makecontext(&migrator, lwp_Migrator, NULL);
 }
 
 int LWP_DestroyProcess(PROCESS pid)
 {
+    int resume;
+
     lwpdebug(0, "Entered Destroy_Process");
     if (!lwp_init)
         return LWP_EINIT;
 
+    resume = lwp_join();
+
+    /* we can't free a process that is running on a worker thread, it is
+     * reaped when it returns to the main thread */
+    if (pid->status == CONCURRENT) {
+        pid->destroyed = 1;
+        lwp_leave(resume);
+        return LWP_SUCCESS;
+    }
+
+    /* a process destroying itself never returns from the reaper */
     if (lwp_cpptr == pid)
         lwp_swapcontext(&lwp_cpptr->ctx, &reaper);
 
     Free_PCB(pid);
+    lwp_leave(resume);
     return LWP_SUCCESS;
 }
 
@@ -674,10 +784,12 @@ static int InitializeProcessSupport(int priority, PROCESS *pid)
         runnable[i].head  = NULL;
         runnable[i].count = 0;
     }
-    blocked.head  = NULL;
-    blocked.count = 0;
-    lwp_init      = (struct lwp_ctl *)malloc(sizeof(struct lwp_ctl));
-    temp          = (PROCESS)malloc(sizeof(struct lwp_pcb));
+    blocked.head     = NULL;
+    blocked.count    = 0;
+    concurrent.head  = NULL;
+    concurrent.count = 0;
+    lwp_init         = (struct lwp_ctl *)malloc(sizeof(struct lwp_ctl));
+    temp             = (PROCESS)malloc(sizeof(struct lwp_pcb));
     if (lwp_init == NULL || temp == NULL)
         Abort_LWP("Insufficient Storage to Initialize LWP Support");
 
@@ -715,7 +827,7 @@ int LWP_Init(int version, int priority, PROCESS *pid)
 /* wait on m of n events */
 int LWP_MwaitProcess(int wcount, const void *evlist[])
 {
-    int ecount, i;
+    int ecount, i, resume;
 
     lwpdebug(0, "Entered Mwait_Process [waitcnt = %d]", wcount);
     if (evlist == NULL) {
@@ -732,6 +844,7 @@ int LWP_MwaitProcess(int wcount, const void *evlist[])
     if (wcount > ecount || wcount < 0) {
         return LWP_EBADCOUNT;
     }
+    resume = lwp_join();
     if (ecount > lwp_cpptr->eventlistsize) {
         lwp_cpptr->eventlist =
             realloc(lwp_cpptr->eventlist, ecount * sizeof(void *));
@@ -749,6 +862,7 @@ int LWP_MwaitProcess(int wcount, const void *evlist[])
     lwp_cpptr->eventcnt = ecount;
     LWP_DispatchProcess();
     lwp_cpptr->eventcnt = 0;
+    lwp_leave(resume);
     return LWP_SUCCESS;
 }
 
@@ -767,8 +881,7 @@ static void Free_PCB(PROCESS pid)
 
     IOMGR_Cancel(pid);
 
-    lwpremove(pid,
-              (pid->status == WAITING ? &blocked : &runnable[pid->priority]));
+    lwpremove(pid, lwpqueue(pid));
     LWPANCHOR.processcnt--;
 
     if (pid->name)
@@ -836,6 +949,10 @@ static int lwp_DispatchProcess(int dummy)
             break;
         }
     }
+    /* Pick up processes that are done running concurrently. */
+    if (concurrent.count)
+        lwp_Rejoin(0);
+
     /* Move head of current runnable queue forward if current LWP is still in it. */
     if (lwp_cpptr && lwp_cpptr == runnable[lwp_cpptr->priority].head) {
         runnable[lwp_cpptr->priority].head =
@@ -844,11 +961,19 @@ static int lwp_DispatchProcess(int dummy)
             gettimeofday(&lwp_cpptr->lastReady, NULL); /* back in queue */
     }
 
-    /* Find highest priority with runnable processes. */
-    for (i = MAX_PRIORITIES - 1; i >= 0; i--)
-        if (runnable[i].head)
+    for (;;) {
+        /* Find highest priority with runnable processes. */
+        for (i = MAX_PRIORITIES - 1; i >= 0; i--)
+            if (runnable[i].head)
+                break;
+
+        if (i >= 0 || !concurrent.count)
             break;
 
+        /* everyone else is running on a worker thread */
+        lwp_Rejoin(1);
+    }
+
     if (i < 0)
         Abort_LWP(
             "LWP_DispatchProcess: Possible deadlock, "
@@ -883,6 +1008,11 @@ static int lwp_DispatchProcess(int dummy)
 
 int LWP_DispatchProcess(void)
 {
+    /* a concurrent process yields to the others on the same worker */
+    if (lwp_pool_self()) {
+        lwp_pool_switch(LWP_POOL_YIELD);
+        return LWP_SUCCESS;
+    }
     return lwp_DispatchProcess(0);
 }
 
@@ -968,14 +1098,16 @@ static int Internal_Signal(const void *event)
 
 int LWP_INTERNALSIGNAL(const void *event, int yield)
 {
-    int rc;
+    int rc, resume;
     lwpdebug(0, "Entered LWP_SignalProcess");
     if (!lwp_init)
         return LWP_EINIT;
 
-    rc = Internal_Signal(event);
+    resume = lwp_join();
+    rc     = Internal_Signal(event);
     if (yield)
         LWP_DispatchProcess();
+    lwp_leave(resume);
 
     return rc;
 }
@@ -1027,6 +1159,76 @@ static void Overflow_Complain()
     (void)write(STDERR_FILENO, msg2, strlen(msg2));
 }
 
-void PRE_Concurrent(int on) {}
-void PRE_BeginCritical(void) {}
-void PRE_EndCritical(void) {}
+/* Return a concurrent process to the main thread, returns 1 when the
+ * caller was running concurrently. */
+int lwp_join(void)
+{
+    if (!lwp_pool_self())
+        return 0;
+
+    lwp_pool_switch(LWP_POOL_REJOIN);
+    return 1;
+}
+
+void lwp_leave(int resume)
+{
+    if (resume)
+        PRE_Concurrent(1);
+}
+
+/* on != 0 : Move the calling process to a worker thread and let it run
+ *           concurrently with the other LWPs.
+ * on == 0 : Return the calling process to the LWP scheduler.
+ *
+ * A concurrent process may only run thread-safe code. Calls into the LWP,
+ * IOMGR and lock routines are allowed, they temporarily return the process
+ * to the main thread. Pointers to thread-local data, such as the address
+ * of errno, should not be kept across this call. The main process has no
+ * stack of its own and always stays on the main thread. */
+void PRE_Concurrent(int on)
+{
+    if (!on) {
+        lwp_join();
+        return;
+    }
+
+    if (!lwp_init || lwp_pool_self() || !lwp_cpptr->stack.ss_sp ||
+        lwp_cpptr->critical)
+        return;
+
+    if (lwp_pool_init())
+        return;
+
+    lwpdebug(0, "Entered PRE_Concurrent");
+    lwp_cpptr->topstack = &on;
+    lwp_swapcontext(&lwp_cpptr->ctx, &migrator);
+    /* we are now running on one of the worker threads */
+}
+
+/* Critical sections always run on the main thread */
+void PRE_BeginCritical(void)
+{
+    PROCESS pid;
+    int resume;
+
+    if (!lwp_init)
+        return;
+
+    resume = lwp_join();
+    pid    = lwp_cpptr;
+    if (pid->critical++ == 0)
+        pid->resume = resume;
+}
+
+void PRE_EndCritical(void)
+{
+    PROCESS pid = LWP_ThisProcess();
+
+    if (!pid || pid->critical == 0)
+        return;
+
+    if (--pid->critical == 0 && pid->resume) {
+        pid->resume = 0;
+        PRE_Concurrent(1);
+    }
+}
@@ -83,6 +83,11 @@ struct lwp_pcb { /* process control block */
     int index; /* LWP index: should be small index; actually is
                                            incremented on each lwp_create_process */
     struct timeval lastReady; /* if ready, time placed in the run queue */
+    PROCESS pool_next; /* next in a worker queue or the rejoin list */
+    char exited; /* returned from its entry point while concurrent */
+    char destroyed; /* destroyed while concurrent */
+    char resume; /* was concurrent before PRE_BeginCritical */
+    int critical; /* nesting level of PRE_BeginCritical */
 
     stack_t stack; /* allocated stack for this thread */
     struct lwp_ucontext ctx; /* saved context for next dispatch */
@@ -97,6 +102,24 @@ struct lwp_ctl { /* LWP control structure */
     void *outersp;
 };
 
+/* Worker threads for concurrent processes [pool.c] */
+#define LWP_POOL_EXIT 0 /* process returned from its entry point */
+#define LWP_POOL_YIELD 1 /* let other processes on the worker run */
+#define LWP_POOL_REJOIN 2 /* continue on the main thread */
+
+extern int lwp_pool_fd; /* readable when processes want to rejoin */
+int lwp_pool_init(void);
+void lwp_pool_submit(PROCESS pid);
+PROCESS lwp_pool_self(void);
+void lwp_pool_switch(int action);
+PROCESS lwp_pool_rejoined(int wait);
+
+/* Concurrent processes return to the main thread before they touch the
+   scheduler state, lwp_join() returns whether the caller was concurrent
+   and lwp_leave() makes it concurrent again */
+int lwp_join(void);
+void lwp_leave(int concurrent);
+
 /* Debugging macro */
 #ifdef LWPDEBUG
 extern FILE *lwp_logfile;
@@ -0,0 +1,284 @@
+/* BLURB lgpl
+
+                           Coda File System
+                              Release 8
+
+          Copyright (c) 2026 Carnegie Mellon University
+                  Additional copyrights listed below
+
+This  code  is  distributed "AS IS" without warranty of any kind under
+the  terms of the  GNU  Library General Public Licence  Version 2,  as
+shown in the file LICENSE. The technical and financial contributors to
+Coda are listed in the file CREDITS.
+
+                        Additional copyrights
+
+#*/
+
+/*
+ * Worker threads for concurrent LWPs
+ *
+ * Normally all LWPs share the single kernel thread of the process and only
+ * one of them runs at a time. A process that calls PRE_Concurrent(1) is
+ * taken out of the LWP run queues and continues on one of a small pool of
+ * kernel threads, so that CPU-bound work in thread-safe code can use the
+ * other processors. PRE_Concurrent(0) brings it back under the LWP
+ * scheduler on the main thread.
+ *
+ * Each worker keeps a queue of the concurrent processes it runs, new
+ * processes are handed out round robin and an idle worker steals from the
+ * queues of the busy ones. A concurrent process that calls
+ * LWP_DispatchProcess() yields to the other processes on its worker.
+ *
+ * Processes on their way back to the main thread are collected on the
+ * rejoin list. A byte is written to lwp_pool_fd when that list becomes
+ * non-empty, so the IOMGR notices them even while it sleeps in select().
+ *
+ * The pool state is protected by pool.lock. The LWP scheduler state is
+ * only touched from the main thread.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <pthread.h>
+#include <assert.h>
+
+#include <lwp/lwp.h>
+#include "lwp.private.h"
+
+#define MAXWORKERS 8 /* default upper limit of the pool size */
+
+int lwp_concurrency = 0; /* number of worker threads, 0 for one per cpu */
+int lwp_pool_fd     = -1; /* readable when processes want to rejoin */
+
+struct lwp_worker {
+    pthread_t thread;
+    struct lwp_ucontext ctx; /* where the worker schedules processes */
+    PROCESS current; /* process running on this worker */
+    int action; /* why the current process switched back */
+    PROCESS head, tail; /* processes queued on this worker */
+};
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t work; /* idle workers wait for processes */
+    pthread_cond_t rejoin; /* main thread waits for rejoining processes */
+    pthread_key_t self; /* worker of the calling thread */
+
+    int state; /* 0 not started, 1 running, -1 failed to start */
+    int nworkers;
+    int next; /* worker that gets the next submitted process */
+    struct lwp_worker *workers;
+
+    PROCESS rejoined; /* processes waiting to return to the main thread */
+    int nrejoined;
+    int wakeup; /* write side of lwp_pool_fd */
+} pool = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER,
+           PTHREAD_COND_INITIALIZER };
+
+static void enqueue(struct lwp_worker *w, PROCESS pid)
+{
+    pid->pool_next = NULL;
+    if (w->tail)
+        w->tail->pool_next = pid;
+    else
+        w->head = pid;
+    w->tail = pid;
+}
+
+static PROCESS dequeue(struct lwp_worker *w)
+{
+    PROCESS pid = w->head;
+
+    if (pid) {
+        w->head = pid->pool_next;
+        if (!w->head)
+            w->tail = NULL;
+    }
+    return pid;
+}
+
+/* pick the next process for worker w, steal from the others if it has
+   nothing queued itself */
+static PROCESS pool_take(struct lwp_worker *w)
+{
+    PROCESS pid = dequeue(w);
+    int i, n = w - pool.workers;
+
+    for (i = 1; !pid && i < pool.nworkers; i++)
+        pid = dequeue(&pool.workers[(n + i) % pool.nworkers]);
+    return pid;
+}
+
+static void pool_rejoin(PROCESS pid)
+{
+    char c = 0;
+
+    pid->pool_next = pool.rejoined;
+    pool.rejoined  = pid;
+    if (__atomic_fetch_add(&pool.nrejoined, 1, __ATOMIC_RELEASE) == 0) {
+        (void)write(pool.wakeup, &c, 1);
+        pthread_cond_signal(&pool.rejoin);
+    }
+}
+
+static void *lwp_Worker(void *arg)
+{
+    struct lwp_worker *w = arg;
+    PROCESS pid;
+
+    pthread_setspecific(pool.self, w);
+
+    pthread_mutex_lock(&pool.lock);
+    for (;;) {
+        pid = pool_take(w);
+        if (!pid) {
+            pthread_cond_wait(&pool.work, &pool.lock);
+            continue;
+        }
+        pthread_mutex_unlock(&pool.lock);
+
+        /* a process that returns from its entry point ends up back here
+           with the action still set to LWP_POOL_EXIT */
+        w->current       = pid;
+        w->action        = LWP_POOL_EXIT;
+        pid->ctx.uc_link = &w->ctx;
+        lwp_swapcontext(&w->ctx, &pid->ctx);
+        w->current = NULL;
+
+        pthread_mutex_lock(&pool.lock);
+        if (w->action == LWP_POOL_YIELD) {
+            enqueue(w, pid);
+            continue;
+        }
+        pid->exited = (w->action == LWP_POOL_EXIT);
+        pool_rejoin(pid);
+    }
+    /* not reached */
+    return NULL;
+}
+
+/* start the worker threads, returns 0 when the pool is running */
+int lwp_pool_init(void)
+{
+    sigset_t all, old;
+    int fds[2], i, n;
+
+    if (pool.state)
+        return pool.state > 0 ? 0 : -1;
+    pool.state = -1;
+
+    n = lwp_concurrency;
+    if (n <= 0) {
+        n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+        if (n > MAXWORKERS)
+            n = MAXWORKERS;
+        if (n < 1)
+            n = 1;
+    }
+
+    if (pthread_key_create(&pool.self, NULL))
+        return -1;
+
+    if (pipe(fds) < 0)
+        return -1;
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    fcntl(fds[1], F_SETFL, O_NONBLOCK);
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+
+    pool.workers = calloc(n, sizeof(struct lwp_worker));
+    if (!pool.workers) {
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+
+    /* signals are handled by the IOMGR on the main thread, the workers
+       inherit a mask that blocks all of them */
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    for (i = 0; i < n; i++)
+        if (pthread_create(&pool.workers[i].thread, NULL, lwp_Worker,
+                           &pool.workers[i]))
+            break;
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+    if (i == 0) {
+        free(pool.workers);
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+
+    pool.nworkers = i;
+    pool.wakeup   = fds[1];
+    lwp_pool_fd   = fds[0];
+    pool.state    = 1;
+    lwpdebug(0, "Started %d worker threads", i);
+    return 0;
+}
+
+/* hand a process to the workers, called from the main thread */
+void lwp_pool_submit(PROCESS pid)
+{
+    pthread_mutex_lock(&pool.lock);
+    enqueue(&pool.workers[pool.next], pid);
+    pool.next = (pool.next + 1) % pool.nworkers;
+    pthread_cond_signal(&pool.work);
+    pthread_mutex_unlock(&pool.lock);
+}
+
+/* returns the process running on the calling worker thread, or NULL when
+   called from the main thread */
+PROCESS lwp_pool_self(void)
+{
+    struct lwp_worker *w;
+
+    if (pool.state <= 0)
+        return NULL;
+    w = pthread_getspecific(pool.self);
+    return w ? w->current : NULL;
+}
+
+/* switch from a concurrent process back to its worker thread, with
+   LWP_POOL_REJOIN the process continues on the main thread */
+void lwp_pool_switch(int action)
+{
+    struct lwp_worker *w = pthread_getspecific(pool.self);
+    PROCESS pid          = w->current;
+
+    w->action = action;
+    lwp_swapcontext(&pid->ctx, &w->ctx);
+    /* we may be running on another thread now */
+}
+
+/* returns the list of processes that returned to the main thread, linked
+   through pool_next. If wait is set, block until there is at least one */
+PROCESS lwp_pool_rejoined(int wait)
+{
+    PROCESS list;
+    char buf[16];
+
+    if (pool.state <= 0 ||
+        (!wait && !__atomic_load_n(&pool.nrejoined, __ATOMIC_ACQUIRE)))
+        return NULL;
+
+    pthread_mutex_lock(&pool.lock);
+    while (wait && !pool.nrejoined)
+        pthread_cond_wait(&pool.rejoin, &pool.lock);
+
+    list          = pool.rejoined;
+    pool.rejoined = NULL;
+    __atomic_store_n(&pool.nrejoined, 0, __ATOMIC_RELAXED);
+    while (read(lwp_pool_fd, buf, sizeof(buf)) > 0)
+        ;
+    pthread_mutex_unlock(&pool.lock);
+    return list;
+}
@@ -224,3 +224,37 @@ ssize_t codatunnel_recvfrom(int sockfd, void *buf, size_t len, int flags,
     // assert(rc == p.msglen); /* I think this should hold true -JH */
     return rc;
 }
+
+int codatunnel_recvmmsg(int sockfd, struct codatunnel_mmsg *msgs,
+                        unsigned int vlen, int flags)
+{
+    if (!codatunnel_enable_codatunnel)
+        return codatunnel_udp_recvmmsg(sockfd, msgs, vlen, flags);
+
+    if (vlen == 0)
+        return 0;
+
+    /* codatunneld hands us one packet at a time */
+    msgs[0].n = codatunnel_recvfrom(sockfd, msgs[0].buf, msgs[0].len, flags,
+                                    msgs[0].addr, &msgs[0].addrlen);
+    return (msgs[0].n < 0) ? -1 : 1;
+}
+
+int codatunnel_sendmmsg(int sockfd, struct codatunnel_mmsg *msgs,
+                        unsigned int vlen, int flags)
+{
+    unsigned int i;
+
+    if (!codatunnel_enable_codatunnel)
+        return codatunnel_udp_sendmmsg(sockfd, msgs, vlen,
+                                       flags & ~CODATUNNEL_HINTS);
+
+    /* codatunneld takes one packet at a time */
+    for (i = 0; i < vlen; i++) {
+        msgs[i].n = codatunnel_sendto(sockfd, msgs[i].buf, msgs[i].len, flags,
+                                      msgs[i].addr, msgs[i].addrlen);
+        if (msgs[i].n < 0)
+            break;
+    }
+    return (i == 0 && vlen) ? -1 : (int)i;
+}
@@ -53,3 +53,16 @@ ssize_t codatunnel_recvfrom(int sockfd, void *buf, size_t len, int flags,
 {
     return recvfrom(sockfd, buf, len, flags, from, fromlen);
 }
+
+int codatunnel_recvmmsg(int sockfd, struct codatunnel_mmsg *msgs,
+                        unsigned int vlen, int flags)
+{
+    return codatunnel_udp_recvmmsg(sockfd, msgs, vlen, flags);
+}
+
+int codatunnel_sendmmsg(int sockfd, struct codatunnel_mmsg *msgs,
+                        unsigned int vlen, int flags)
+{
+    return codatunnel_udp_sendmmsg(sockfd, msgs, vlen,
+                                   flags & ~CODATUNNEL_ISRETRY_HINT);
+}
@@ -0,0 +1,81 @@
+/* BLURB lgpl
+
+                           Coda File System
+                              Release 8
+
+          Copyright (c) 2026 Carnegie Mellon University
+                  Additional copyrights listed below
+
+This  code  is  distributed "AS IS" without warranty of any kind under
+the  terms of the  GNU  Library General Public Licence  Version 2,  as
+shown in the file LICENSE. The technical and financial contributors to
+Coda are listed in the file CREDITS.
+
+                        Additional copyrights
+
+#*/
+
+/* recvmmsg is a GNU extension */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <errno.h>
+#include <string.h>
+
+#include "wrapper.h"
+
+/* upper bound for the number of datagrams pulled in by a single call */
+#define UDP_MAXBATCH 64
+
+int codatunnel_udp_recvmmsg(int sockfd, struct codatunnel_mmsg *msgs,
+                            unsigned int vlen, int flags)
+{
+#ifdef HAVE_RECVMMSG
+    struct mmsghdr hdr[UDP_MAXBATCH];
+    struct iovec iov[UDP_MAXBATCH];
+    unsigned int i;
+    int n;
+
+    if (vlen > UDP_MAXBATCH)
+        vlen = UDP_MAXBATCH;
+
+    memset(hdr, 0, vlen * sizeof(struct mmsghdr));
+    for (i = 0; i < vlen; i++) {
+        iov[i].iov_base            = msgs[i].buf;
+        iov[i].iov_len             = msgs[i].len;
+        hdr[i].msg_hdr.msg_iov     = &iov[i];
+        hdr[i].msg_hdr.msg_iovlen  = 1;
+        hdr[i].msg_hdr.msg_name    = msgs[i].addr;
+        hdr[i].msg_hdr.msg_namelen = msgs[i].addrlen;
+    }
+
+    n = recvmmsg(sockfd, hdr, vlen, flags | MSG_DONTWAIT, NULL);
+
+    for (i = 0; n > 0 && i < (unsigned int)n; i++) {
+        msgs[i].addrlen = hdr[i].msg_hdr.msg_namelen;
+        msgs[i].n       = hdr[i].msg_len;
+    }
+    return n;
+#else
+    /* no recvmmsg, emulate it by reading until the socket queue is empty */
+    unsigned int i;
+    ssize_t n;
+
+    for (i = 0; i < vlen; i++) {
+        n = recvfrom(sockfd, msgs[i].buf, msgs[i].len, flags | MSG_DONTWAIT,
+                     msgs[i].addr, &msgs[i].addrlen);
+        if (n < 0)
+            break;
+        msgs[i].n = n;
+    }
+    return (i == 0) ? -1 : (int)i;
+#endif
+}
@@ -0,0 +1,170 @@
+/* BLURB lgpl
+
+                           Coda File System
+                              Release 8
+
+          Copyright (c) 2026 Carnegie Mellon University
+                  Additional copyrights listed below
+
+This  code  is  distributed "AS IS" without warranty of any kind under
+the  terms of the  GNU  Library General Public Licence  Version 2,  as
+shown in the file LICENSE. The technical and financial contributors to
+Coda are listed in the file CREDITS.
+
+                        Additional copyrights
+
+#*/
+
+/* sendmmsg is a GNU extension */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <stdint.h>
+#include <errno.h>
+#include <string.h>
+
+#include "wrapper.h"
+
+/* upper bound for the number of datagrams sent by a single call */
+#define UDP_MAXBATCH 64
+
+#if defined(HAVE_SENDMMSG) && defined(UDP_SEGMENT)
+/* UDP segmentation offload, consecutive datagrams of the same size for the
+ * same peer are passed to the kernel as a single super-packet that is split
+ * up by the kernel or the network card. The kernel limits the number of
+ * segments and the super-packet has to fit in an IP datagram. */
+#define UDP_MAXSEGS 64
+#define UDP_MAXGSO 65000
+
+static int udp_gso = 1; /* cleared when the kernel refuses to segment */
+
+/* Can msgs[i] be appended to the super-packet that starts at msgs[first] */
+static int udp_can_segment(struct codatunnel_mmsg *msgs, unsigned int first,
+                           unsigned int i, size_t total)
+{
+    size_t segsize = msgs[first].len;
+
+    /* only the last segment may be shorter than the others */
+    if (msgs[i - 1].len != segsize || msgs[i].len > segsize)
+        return 0;
+    if (i - first >= UDP_MAXSEGS || total + msgs[i].len > UDP_MAXGSO)
+        return 0;
+    return (msgs[i].addrlen == msgs[first].addrlen &&
+            memcmp(msgs[i].addr, msgs[first].addr, msgs[i].addrlen) == 0);
+}
+#endif
+
+int codatunnel_udp_sendmmsg(int sockfd, struct codatunnel_mmsg *msgs,
+                            unsigned int vlen, int flags)
+{
+#ifdef HAVE_SENDMMSG
+    struct mmsghdr hdr[UDP_MAXBATCH];
+    struct iovec iov[UDP_MAXBATCH];
+    unsigned int first[UDP_MAXBATCH]; /* first datagram in each hdr */
+    unsigned int i, h, end, nhdr = 0, sent = 0;
+    int n = 0;
+#ifdef UDP_SEGMENT
+    union {
+        char buf[CMSG_SPACE(sizeof(uint16_t))];
+        struct cmsghdr align;
+    } ctrl[UDP_MAXBATCH];
+    struct cmsghdr *cmsg;
+    size_t total = 0;
+    int gso      = udp_gso;
+#endif
+
+    if (vlen > UDP_MAXBATCH)
+        vlen = UDP_MAXBATCH;
+    if (vlen == 0)
+        return 0;
+
+    memset(hdr, 0, vlen * sizeof(struct mmsghdr));
+    for (i = 0; i < vlen; i++) {
+        iov[i].iov_base = msgs[i].buf;
+        iov[i].iov_len  = msgs[i].len;
+        msgs[i].n       = -1;
+
+#ifdef UDP_SEGMENT
+        if (gso && nhdr && udp_can_segment(msgs, first[nhdr - 1], i, total)) {
+            hdr[nhdr - 1].msg_hdr.msg_iovlen++;
+            total += msgs[i].len;
+            continue;
+        }
+        total = msgs[i].len;
+#endif
+        first[nhdr]                   = i;
+        hdr[nhdr].msg_hdr.msg_iov     = &iov[i];
+        hdr[nhdr].msg_hdr.msg_iovlen  = 1;
+        hdr[nhdr].msg_hdr.msg_name    = msgs[i].addr;
+        hdr[nhdr].msg_hdr.msg_namelen = msgs[i].addrlen;
+        nhdr++;
+    }
+
+#ifdef UDP_SEGMENT
+    for (i = 0; i < nhdr; i++) {
+        if (hdr[i].msg_hdr.msg_iovlen == 1)
+            continue;
+
+        hdr[i].msg_hdr.msg_control    = ctrl[i].buf;
+        hdr[i].msg_hdr.msg_controllen = sizeof(ctrl[i].buf);
+        cmsg                          = CMSG_FIRSTHDR(&hdr[i].msg_hdr);
+        cmsg->cmsg_level              = IPPROTO_UDP;
+        cmsg->cmsg_type               = UDP_SEGMENT;
+        cmsg->cmsg_len                = CMSG_LEN(sizeof(uint16_t));
+        *(uint16_t *)CMSG_DATA(cmsg)  = msgs[first[i]].len;
+    }
+#endif
+
+    /* sendmmsg may stop early, keep going with the remaining headers until
+     * everything is sent or the kernel reports an error */
+    for (h = 0; h < nhdr; h += n) {
+        n = sendmmsg(sockfd, hdr + h, nhdr - h, flags);
+
+#ifdef UDP_SEGMENT
+        /* older kernels or network setups that cannot segment UDP, fall back
+         * to sending every datagram separately from now on */
+        if (n == -1 && nhdr < vlen &&
+            (errno == EIO || errno == EINVAL || errno == ENOPROTOOPT)) {
+            udp_gso = 0;
+            n = codatunnel_udp_sendmmsg(sockfd, msgs + sent, vlen - sent,
+                                        flags);
+            if (n < 0)
+                return sent ? (int)sent : n;
+            return sent + n;
+        }
+#endif
+        if (n <= 0)
+            break;
+
+        end = first[h + n - 1] + hdr[h + n - 1].msg_hdr.msg_iovlen;
+        for (; sent < end; sent++)
+            msgs[sent].n = msgs[sent].len;
+    }
+
+    /* a short count tells the caller which datagrams were not sent */
+    return sent ? (int)sent : n;
+#else
+    /* no sendmmsg, send the datagrams one by one */
+    unsigned int i;
+    ssize_t n;
+
+    for (i = 0; i < vlen; i++) {
+        n = sendto(sockfd, msgs[i].buf, msgs[i].len, flags, msgs[i].addr,
+                   msgs[i].addrlen);
+        msgs[i].n = n;
+        if (n < 0)
+            break;
+    }
+    return (i == 0 && vlen) ? -1 : (int)i;
+#endif
+}
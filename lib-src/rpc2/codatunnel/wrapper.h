@@ -43,4 +43,32 @@ ssize_t codatunnel_sendto(int sockfd, const void *buf, size_t len, int flags,
 ssize_t codatunnel_recvfrom(int sockfd, void *buf, size_t len, int flags,
                             struct sockaddr *src_addr, socklen_t *addrlen);
 
+/* Batched receive, buf/len/addr/addrlen are set up by the caller the same way
+ * as the arguments to codatunnel_recvfrom, n returns the received length */
+struct codatunnel_mmsg {
+    void *buf;
+    size_t len;
+    struct sockaddr *addr;
+    socklen_t addrlen;
+    ssize_t n;
+};
+
+/* Never blocks, returns the number of datagrams received or -1 on error.
+ * When the tunnel is active at most one datagram is returned per call. */
+int codatunnel_recvmmsg(int sockfd, struct codatunnel_mmsg *msgs,
+                        unsigned int vlen, int flags);
+
+/* Batched send, buf/len/addr/addrlen describe each datagram and n returns
+ * the number of bytes sent. Returns the number of datagrams that were sent or
+ * -1 when not even the first one could be sent. When the tunnel is active the
+ * datagrams are passed to codatunneld one at a time. */
+int codatunnel_sendmmsg(int sockfd, struct codatunnel_mmsg *msgs,
+                        unsigned int vlen, int flags);
+
+/* plain UDP socket implementations, used when the tunnel is not active */
+int codatunnel_udp_recvmmsg(int sockfd, struct codatunnel_mmsg *msgs,
+                            unsigned int vlen, int flags);
+int codatunnel_udp_sendmmsg(int sockfd, struct codatunnel_mmsg *msgs,
+                            unsigned int vlen, int flags);
+
 #endif /* _CODATUNNEL_WRAPPER_H_ */
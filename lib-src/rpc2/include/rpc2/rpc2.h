@@ -292,6 +292,26 @@ extern long RPC2_strict_ip_matching;
 extern size_t RPC2_Preferred_Keysize;
 extern int RPC2_secure_only;
 
+/* When set to a value larger than 1, the socket listener drains up to that
+ * many datagrams from a request socket with a single recvmmsg call before
+ * dispatching them, which saves system calls on busy servers. The value is
+ * capped at RPC2_MAXRECVBATCH. It can also be set with the environment
+ * variable 'RPC2_RECVBATCH', which is evaluated when RPC2_Init() is called.
+ */
+#define RPC2_MAXRECVBATCH 32
+extern long RPC2_RecvBatch;
+
+/* When set to a value larger than 1, packets that are sent while the socket
+ * listener works through the received packets, or while SFTP pushes out a
+ * window of data, are queued and sent in batches of up to that many with a
+ * single sendmmsg call. Equally sized packets for the same peer are handed to
+ * the kernel as one UDP segmentation offload super-packet where supported.
+ * A queued SFTP ack is replaced when a newer ack for the same transfer is
+ * sent before the queue is flushed. The value is capped at RPC2_MAXXMITBATCH
+ * and can also be set with the environment variable 'RPC2_XMITBATCH'. */
+#define RPC2_MAXXMITBATCH 32
+extern long RPC2_XmitBatch;
+
 /*
 ************************* Data Types known to RPGen ***********************
 */
@@ -536,6 +556,12 @@ typedef struct {
 
 #define RPC2_OPTION_IPV6 0x1
 #define RPC2_OPTION_VERBOSE_INIT 0x2
+/* Bind the request socket with SO_REUSEPORT so that several server processes
+ * can share the same port. The kernel hashes on the peer address, so all
+ * connections from a client endpoint keep arriving at the same process.
+ * Only for servers that keep no state shared between their clients, codasrv
+ * can not use it: its volumes, vnodes and callbacks live in one process. */
+#define RPC2_OPTION_REUSEPORT 0x4
 
 /* Structure for passing parameters to RPC2_NewBinding() and its multi clone */
 
@@ -838,10 +864,36 @@ struct RStats {
         Bytes; /* BytesReceived */
 };
 
+struct BStats {
+    unsigned long Wakeups, /* Listener wakeups with packets waiting */
+        Calls, /* Batched receive calls */
+        Packets, /* Packets received by batched receive calls */
+        Full, /* Calls that returned RPC2_RecvBatch packets */
+        Largest; /* Largest batch received */
+};
+
+struct TStats {
+    unsigned long Flushes, /* Transmit queue flushes */
+        Calls, /* Batched send calls */
+        Packets, /* Packets sent by batched send calls */
+        Coalesced, /* Queued acks replaced by a newer ack */
+        Largest; /* Largest batch sent */
+};
+
+struct PStats {
+    unsigned long Hits, /* Buffer allocations served from a freelist */
+        Misses, /* Buffer allocations that needed malloc */
+        Copied, /* Received packets copied into a smaller buffer */
+        InPlace; /* Received packets kept in their receive buffer */
+};
+
 extern struct SStats rpc2_Sent;
 extern struct RStats rpc2_Recvd;
 extern struct SStats rpc2_MSent;
 extern struct RStats rpc2_MRecvd;
+extern struct BStats rpc2_RecvBatched;
+extern struct TStats rpc2_XmitBatched;
+extern struct PStats rpc2_PBStats;
 
 extern int rpc2_43bsd; /* TRUE  on 4.3BSD, FALSE on 4.2BSD */
 
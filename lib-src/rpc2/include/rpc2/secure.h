@@ -184,6 +184,32 @@ ssize_t secure_recvfrom(int s, void *buf, size_t len, int flags,
                         struct security_association **sa,
                         struct security_association *(*GETSA)(uint32_t spi));
 
+/* batched version of secure_recvfrom, the caller fills in buf and len for each
+ * entry. On return n holds the length of the validated and decrypted payload,
+ * or -1 with the reason in err. Returns the number of received datagrams,
+ * never blocks and may be called with at most SECURE_MAXBATCH entries. */
+#define SECURE_MAXBATCH 32
+struct secure_mmsg {
+    void *buf;
+    size_t len;
+    ssize_t n;
+    int err;
+    struct sockaddr_storage peer; /* untrusted */
+    socklen_t peerlen;
+    struct security_association *sa;
+};
+
+int secure_recvmmsg(int s, struct secure_mmsg *msgs, unsigned int vlen,
+                    int flags,
+                    struct security_association *(*GETSA)(uint32_t spi));
+
+/* batched version of secure_sendto, the caller fills in buf, len, peer,
+ * peerlen and sa for each entry. On return n holds the number of payload
+ * bytes sent, or -1 with the reason in err. Returns the number of datagrams
+ * sent, or -1 if none could be sent. */
+int secure_sendmmsg(int s, struct secure_mmsg *msgs, unsigned int vlen,
+                    int flags);
+
 /* time-constant comparison */
 int secure_compare(const void *user_data, size_t user_len, const void *secret,
                    size_t secret_len);
@@ -121,6 +121,9 @@ The interpretation of header fields is similar to that in RPC:
                             greater than GotEmAll; Read left to right, bits
                             correspond to GotEmAll+1, GotEmAll+2 .... Leftmost
                             bit must be 0, by definition of GotEmAll
+                            When the negotiated window is larger than
+                            MAXOPACKETS the bit string continues in the body
+                            of the ack, as 32-bit words in network order.
     Lamport             #defined to BitMask1    (only sensible with SFTP_ACK)
     Uniquefier          #defined to ThisCall    (RPC call sequence number at
                             sending side of the RPC pertaining to this side
@@ -173,8 +176,10 @@ The interpretation of header fields is similar to that in RPC:
 /* Per-connection information: accessible via RPC2_GetSEPointer() and
  * RPC2_SetSEPointer() */
 #define SFTPMAGIC 4902057
-#define MAXOPACKETS 64 /* Maximum no of outstanding packets; multiple of 32 */
-#define BITMASKWIDTH (MAXOPACKETS / 32) /* No of elements in integer array */
+#define MAXOPACKETS 64 /* Packets covered by the bitmask in the packet header */
+#define SFTP_MAXWINDOWSIZE 1024 /* Largest window; power of 2 */
+/* No of elements in integer array */
+#define BITMASKWIDTH (SFTP_MAXWINDOWSIZE / 32)
 
 struct SFTP_Parms { /* sent in SFTP_START packets, and piggy-backed on very
                        first RPC call on a connection */
@@ -232,7 +237,10 @@ struct SFTP_Entry /* per-connection data structure */
     long RecvQueueLen;
     uint32_t PacketSize; /* Amount of  data in each packet */
     uint32_t WindowSize; /* Max Number of outstanding packets without
-                            acknowledgement <= MAXOPACKETS */
+                            acknowledgement <= MaxPackets. Windows larger
+                            than MAXOPACKETS are adaptive, the source only
+                            uses as much of the window as is needed to
+                            cover the bandwidth-delay product to the peer */
     uint32_t SendAhead; /* How many more packets to send after
                            demanding an ack. Equal to read-ahead  */
     uint32_t AckPoint; /* After how many send ahead packets should an
@@ -318,10 +326,11 @@ struct SFTP_Entry /* per-connection data structure */
     /* Packets in RecvLastContig+1..RecvMostRecent that I have received */
     unsigned int RecvTheseBits[BITMASKWIDTH];
 
-    RPC2_PacketBuffer *ThesePackets[MAXOPACKETS];
-    /* Packets being currently dealt with. There can be at most MAXOPACKETS
+    uint32_t MaxPackets; /* Size of ThesePackets, a power of 2 >= WindowSize */
+    RPC2_PacketBuffer **ThesePackets;
+    /* Packets being currently dealt with. There can be at most WindowSize
      * outstanding, in the range LastContig+1..LastContig+WindowSize. The
-     * index of the i'th packet is given by (i % MAXOPACKETS).
+     * index of the i'th packet is given by (i % MaxPackets).
      *
      * Some of these pointers, may be NULL for the following reasons:
      * Receiving side:  The packets have not been received, or have
@@ -362,7 +371,8 @@ void sftp_ExaminePacket(RPC2_PacketBuffer *pb);
 #define CLEARBIT(mask, pos) ((mask)[WORDOFFSET(pos)] &= (~PM(pos)))
 
 /* Packet buffer position */
-#define PBUFF(x) ((x) & (MAXOPACKETS - 1)) /* effectively modulo operator */
+#define PBUFF(sfe, x) \
+    ((x) & ((sfe)->MaxPackets - 1)) /* effectively modulo operator */
 
 /* The transmission parameters below are initial values; actual ones are
  * per-connection */
@@ -54,12 +54,81 @@ Pittsburgh, PA.
 
 #include "rpc2.private.h"
 
-/* HASHLENGTH should be a power of two, because we use modulo HASHLENGTH-1 to
- * find the appropriate hash bucket */
+/* The connection hash table starts out with HASHLENGTH buckets and doubles in
+ * size whenever the average chain grows longer than HASHLOAD entries. Bucket
+ * counts are always a power of two, so we can use the low bits of the handle
+ * to find the appropriate hash bucket.
+ *
+ * Servers may hold tens of thousands of connections, so the entries are not
+ * moved over all at once. While a resize is in progress the previous table
+ * is kept in OldTable and a couple of its buckets are moved over every time
+ * a connection is added. Buckets below OldNext have already been moved. */
 #define HASHLENGTH 512
+#define HASHLOAD 2
+#define HASHMIGRATE 4 /* old buckets moved per new connection */
 
-/* the hash table of size HASHLEN buckets */
-static struct dllist_head HashTable[HASHLENGTH];
+static struct dllist_head *HashTable, *OldTable;
+static uint32_t HashMask, OldMask, OldNext;
+
+static struct dllist_head *AllocTable(uint32_t buckets)
+{
+    struct dllist_head *table;
+    uint32_t i;
+
+    table = (struct dllist_head *)malloc(buckets * sizeof(*table));
+    assert(table || "failed to allocate connection hash table");
+
+    for (i = 0; i < buckets; i++)
+        list_head_init(&table[i]);
+
+    return table;
+}
+
+/* return the chain that should contain handle */
+static struct dllist_head *Bucket(RPC2_Handle handle)
+{
+    uint32_t i;
+
+    if (OldTable) {
+        i = handle & OldMask;
+        if (i >= OldNext)
+            return &OldTable[i];
+    }
+    return &HashTable[handle & HashMask];
+}
+
+/* move a few buckets from the old table, and start a new resize when the
+ * chains are getting long */
+static void MigrateTable(void)
+{
+    struct dllist_head *ptr, *next;
+    struct CEntry *ce;
+    int n;
+
+    for (n = 0; OldTable && n < HASHMIGRATE; n++) {
+        for (ptr = OldTable[OldNext].next; ptr != &OldTable[OldNext];
+             ptr = next) {
+            next = ptr->next;
+            ce   = list_entry(ptr, struct CEntry, Chain);
+            list_del(&ce->Chain);
+            list_add(&ce->Chain, &HashTable[ce->UniqueCID & HashMask]);
+        }
+        if (++OldNext > OldMask) {
+            free(OldTable);
+            OldTable = NULL;
+        }
+    }
+
+    if (!OldTable && (uint32_t)rpc2_ConnCount > HASHLOAD * (HashMask + 1)) {
+        say(1, RPC2_DebugLevel, "Growing connection hash to %u buckets\n",
+            2 * (HashMask + 1));
+        OldTable  = HashTable;
+        OldMask   = HashMask;
+        OldNext   = 0;
+        HashMask  = 2 * HashMask + 1;
+        HashTable = AllocTable(HashMask + 1);
+    }
+}
 
 /* The basic connection abstraction */
 DLLIST_HEAD(rpc2_ConnList); /* active connections  */
@@ -67,15 +136,12 @@ DLLIST_HEAD(rpc2_ConnFreeList); /* free connection blocks */
 
 int rpc2_InitConn(void)
 {
-    int i;
-
     /* safety check, never initialize twice */
     if (rpc2_ConnCount != -1)
         return 0;
 
-    for (i = 0; i < HASHLENGTH; i++) {
-        list_head_init(&HashTable[i]);
-    }
+    HashTable = AllocTable(HASHLENGTH);
+    HashMask  = HASHLENGTH - 1;
 
     rpc2_ConnCount = rpc2_ConnFreeCount = rpc2_ConnCreationCount = 0;
 
@@ -87,18 +153,16 @@ int rpc2_InitConn(void)
    existing connection.  */
 struct CEntry *__rpc2_GetConn(RPC2_Handle handle)
 {
-    uint32_t i;
-    struct dllist_head *ptr;
+    struct dllist_head *bucket, *ptr;
     struct CEntry *ceaddr;
 
     if (handle == 0)
         return (NULL);
 
-    /* bucket is handle modulo HASHLENGTH */
-    i = handle & (HASHLENGTH - 1);
+    bucket = Bucket(handle);
 
     /* and walk the chain */
-    for (ptr = HashTable[i].next; ptr != &HashTable[i]; ptr = ptr->next) {
+    for (ptr = bucket->next; ptr != bucket; ptr = ptr->next) {
         /* compare the entry to our handle */
         ceaddr = list_entry(ptr, struct CEntry, Chain);
         assert(ceaddr->MagicNumber == OBJ_CENTRY);
@@ -111,9 +175,8 @@ struct CEntry *__rpc2_GetConn(RPC2_Handle handle)
 
 static void __rehash_ce(struct CEntry *ce)
 {
-    uint32_t i = ce->UniqueCID & (HASHLENGTH - 1);
     list_del(&ce->Chain);
-    list_add(&ce->Chain, &HashTable[i]);
+    list_add(&ce->Chain, Bucket(ce->UniqueCID));
 
     /* keep the grim reaper out */
     ce->LastRef = time(NULL);
@@ -136,7 +199,6 @@ struct CEntry *rpc2_GetConn(RPC2_Handle handle)
 static void Uniquefy(IN struct CEntry *ceaddr)
 {
     RPC2_Integer handle;
-    uint32_t index;
 
     /* secure_random_bytes will return int's up to 2^32 and effectively we will
      * have broken down before we use this many entries on either the time it
@@ -146,8 +208,8 @@ static void Uniquefy(IN struct CEntry *ceaddr)
 
     /* this might take some time once we get a lot of used handles. But even
      * with a `full' table (within the constraint above), we should, on
-     * average, find a free handle after walking two chains. Advice for those
-     * who are afraid of long bucket chain lookups: increase HASHLENGTH */
+     * average, find a free handle after walking two chains. The table grows
+     * along with the number of connections, so chains stay short. */
     while (1) {
         secure_random_bytes(&handle, sizeof(handle));
 
@@ -164,8 +226,10 @@ static void Uniquefy(IN struct CEntry *ceaddr)
     ceaddr->UniqueCID = handle;
 
     /* add to the bucket */
-    index = handle & (HASHLENGTH - 1);
-    list_add(&ceaddr->Chain, &HashTable[index]);
+    list_add(&ceaddr->Chain, Bucket(handle));
+
+    /* make some progress on resizing the hash table */
+    MigrateTable();
 }
 
 struct CEntry *rpc2_getFreeConn()
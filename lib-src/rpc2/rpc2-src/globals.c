@@ -51,9 +51,12 @@ Pittsburgh, PA.
    rpc2.private.h for descriptions */
 
 long RPC2_Perror = 1, RPC2_DebugLevel = 0, RPC2_Trace = 0; /* see rpc2.h */
+long RPC2_RecvBatch = 0; /* see rpc2.h */
+long RPC2_XmitBatch = 0; /* see rpc2.h */
 
 /* whether the client can handle RPC2_HOSTBYADDRINFO and IPv6 connections */
 int rpc2_ipv6ready;
+int rpc2_reuseport;
 
 int rpc2_v4RequestSocket = -1;
 int rpc2_v6RequestSocket = -1;
@@ -92,6 +95,9 @@ struct SStats rpc2_Sent;
 struct RStats rpc2_Recvd;
 struct SStats rpc2_MSent;
 struct RStats rpc2_MRecvd;
+struct BStats rpc2_RecvBatched;
+struct TStats rpc2_XmitBatched;
+struct PStats rpc2_PBStats;
 
 unsigned long rpc2_LamportClock;
 
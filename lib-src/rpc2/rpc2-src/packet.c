@@ -114,8 +114,183 @@ static long FailPacket(int (*predicate)(), RPC2_PacketBuffer *pb,
     return drop;
 }
 
+/* Transmit queue, see rpc2_XmitCork. The queue and the copies of the queued
+ * packets are static, like the rest of the RPC2 state they are only used by
+ * LWPs on the main thread and XmitFlush is never entered recursively. */
+struct XmitEntry {
+    int sock;
+    int flags;
+    RPC2_Handle key;
+    RPC2_PacketBuffer *pb; /* queued without a copy, see rpc2_XmitInPlace */
+};
+static struct XmitEntry XmitQueue[RPC2_MAXXMITBATCH];
+static struct secure_mmsg XmitMsgs[RPC2_MAXXMITBATCH];
+static char XmitData[RPC2_MAXXMITBATCH][RPC2_MAXPACKETSIZE];
+static int XmitQueued, XmitCorked;
+
+/* Checks the outcome of sending a packet, n is the number of bytes that were
+ * sent and errno is expected to be set when that is -1 */
+static void XmitResult(int whichSocket, long n, long len)
+{
+    if (n == -1 && errno == EAGAIN) {
+        /* operation failed probably because the send buffer was full. we could
+         * try to select for write and retry, or we could just consider this
+         * packet lost on the network.
+         */
+    } else
+
+        if (n == -1 && errno == EINVAL && msg_confirm) {
+        /* maybe the kernel didn't like the MSG_CONFIRM flag. */
+        msg_confirm = 0;
+    } else
+
+        if (RPC2_Perror && n != len) {
+        char msg[100];
+        sprintf(msg, "Xmit_Packet socket %d", whichSocket);
+        perror(msg);
+    }
+}
+
+static void XmitFlush(void)
+{
+    struct secure_mmsg *msgs;
+    int i, j, k, n;
+
+    rpc2_XmitBatched.Flushes++;
+
+    for (i = 0; i < XmitQueued; i = j) {
+        /* packets for the same socket with the same flags go out together */
+        for (j = i + 1; j < XmitQueued; j++)
+            if (XmitQueue[j].sock != XmitQueue[i].sock ||
+                XmitQueue[j].flags != XmitQueue[i].flags)
+                break;
+
+        msgs = &XmitMsgs[i];
+        n    = secure_sendmmsg(XmitQueue[i].sock, msgs, j - i,
+                            XmitQueue[i].flags);
+
+        rpc2_XmitBatched.Calls++;
+        if (n > 0) {
+            rpc2_XmitBatched.Packets += n;
+            if ((unsigned long)n > rpc2_XmitBatched.Largest)
+                rpc2_XmitBatched.Largest = n;
+        }
+
+        for (k = 0; k < j - i; k++) {
+            errno = msgs[k].err;
+            XmitResult(XmitQueue[i].sock, msgs[k].n, msgs[k].len);
+        }
+    }
+    XmitQueued = 0;
+}
+
+/* Adds the packet to the transmit queue, returns 0 if the packet could not
+ * be queued and has to be sent right away. Unless inplace is set the packet
+ * is copied so that the caller is free to reuse pb. */
+static int XmitEnqueue(int whichSocket, RPC2_PacketBuffer *pb, int flags,
+                       struct RPC2_addrinfo *addr, RPC2_Handle key,
+                       int inplace)
+{
+    struct secure_mmsg *msg;
+    int i;
+
+    if (pb->Prefix.LengthOfPacket > RPC2_MAXPACKETSIZE ||
+        addr->ai_addrlen > sizeof(msg->peer))
+        return 0;
+
+    /* a newer ack supersedes the queued one, so we replace it in place */
+    for (i = 0; key && i < XmitQueued; i++)
+        if (XmitQueue[i].key == key && XmitQueue[i].sock == whichSocket)
+            break;
+
+    if (key && i < XmitQueued)
+        rpc2_XmitBatched.Coalesced++;
+    else {
+        if (XmitQueued >= RPC2_XmitBatch || XmitQueued >= RPC2_MAXXMITBATCH)
+            XmitFlush();
+        i = XmitQueued++;
+    }
+
+    XmitQueue[i].sock  = whichSocket;
+    XmitQueue[i].flags = flags;
+    XmitQueue[i].key   = key;
+    XmitQueue[i].pb    = inplace ? pb : NULL;
+
+    msg = &XmitMsgs[i];
+    if (inplace)
+        msg->buf = &pb->Header;
+    else {
+        memcpy(XmitData[i], &pb->Header, pb->Prefix.LengthOfPacket);
+        msg->buf = XmitData[i];
+    }
+    memcpy(&msg->peer, addr->ai_addr, addr->ai_addrlen);
+    msg->len     = pb->Prefix.LengthOfPacket;
+    msg->peerlen = addr->ai_addrlen;
+    msg->sa      = pb->Prefix.sa;
+    return 1;
+}
+
+/* Packets sent between rpc2_XmitCork and the matching rpc2_XmitUncork are
+ * collected in the transmit queue and sent in batches when RPC2_XmitBatch is
+ * larger than 1. Calls may be nested, the queue is flushed when the outermost
+ * rpc2_XmitUncork is called or when it fills up. */
+void rpc2_XmitCork(void)
+{
+    if (RPC2_XmitBatch > 1)
+        XmitCorked++;
+}
+
+void rpc2_XmitUncork(void)
+{
+    if (!XmitCorked)
+        return;
+
+    if (--XmitCorked == 0 && XmitQueued)
+        XmitFlush();
+}
+
+/* Called before pb is released or reused, sends out the transmit queue if it
+ * still refers to the contents of pb */
+void rpc2_XmitRelease(RPC2_PacketBuffer *pb)
+{
+    int i;
+
+    for (i = 0; i < XmitQueued; i++) {
+        if (XmitQueue[i].pb == pb) {
+            XmitFlush();
+            return;
+        }
+    }
+}
+
+static void Xmit(RPC2_PacketBuffer *pb, struct RPC2_addrinfo *addr,
+                 int confirm, RPC2_Handle key, int inplace);
+
 void rpc2_XmitPacket(RPC2_PacketBuffer *pb, struct RPC2_addrinfo *addr,
                      int confirm)
+{
+    Xmit(pb, addr, confirm, 0, 0);
+}
+
+/* Like rpc2_XmitPacket, but while the transmit queue is corked a packet with
+ * the same non-zero key that is still queued will be replaced by this one. */
+void rpc2_XmitCoalesce(RPC2_PacketBuffer *pb, struct RPC2_addrinfo *addr,
+                       int confirm, RPC2_Handle key)
+{
+    Xmit(pb, addr, confirm, key, 0);
+}
+
+/* Like rpc2_XmitPacket, but the transmit queue refers to pb instead of taking
+ * a copy. Used for packets that are kept around for retransmission anyway,
+ * RPC2_FreeBuffer makes sure the queue is sent before pb is released. */
+void rpc2_XmitInPlace(RPC2_PacketBuffer *pb, struct RPC2_addrinfo *addr,
+                      int confirm)
+{
+    Xmit(pb, addr, confirm, 0, 1);
+}
+
+static void Xmit(RPC2_PacketBuffer *pb, struct RPC2_addrinfo *addr,
+                 int confirm, RPC2_Handle key, int inplace)
 {
     static int log_limit = 0;
     int whichSocket, n, flags = 0;
@@ -184,26 +359,13 @@ void rpc2_XmitPacket(RPC2_PacketBuffer *pb, struct RPC2_addrinfo *addr,
             flags |= CODATUNNEL_ISRETRY_HINT;
     }
 
-    n = secure_sendto(whichSocket, &pb->Header, pb->Prefix.LengthOfPacket,
-                      flags, addr->ai_addr, addr->ai_addrlen, pb->Prefix.sa);
-
-    if (n == -1 && errno == EAGAIN) {
-        /* operation failed probably because the send buffer was full. we could
-         * try to select for write and retry, or we could just consider this
-         * packet lost on the network.
-         */
-    } else
-
-        if (n == -1 && errno == EINVAL && msg_confirm) {
-        /* maybe the kernel didn't like the MSG_CONFIRM flag. */
-        msg_confirm = 0;
-    } else
-
-        if (RPC2_Perror && n != pb->Prefix.LengthOfPacket) {
-        char msg[100];
-        sprintf(msg, "Xmit_Packet socket %d", whichSocket);
-        perror(msg);
-    }
+    if (XmitCorked && XmitEnqueue(whichSocket, pb, flags, addr, key, inplace))
+        n = pb->Prefix.LengthOfPacket; /* checked when the queue is flushed */
+    else
+        n = secure_sendto(whichSocket, &pb->Header, pb->Prefix.LengthOfPacket,
+                          flags, addr->ai_addr, addr->ai_addrlen,
+                          pb->Prefix.sa);
+    XmitResult(whichSocket, n, pb->Prefix.LengthOfPacket);
 
     /* Log outgoing packets that are larger than the IPv6 MTU
      * (- ipv6 hdr, ipv6 fragment hdr, udp hdr, secure spi/seq/iv/icv)
@@ -227,32 +389,12 @@ struct security_association *rpc2_GetSA(uint32_t spi)
     return ce ? &ce->sa : NULL;
 }
 
-/* Reads the next packet from whichSocket into whichBuff, sets its
-   LengthOfPacket field, fills in whichHost and whichPort, and
-   returns 0; Returns -3 iff a too-long packet arrived.  Returns -1 on
-   any other system call error.
-
-   Note that whichBuff should at least be able to accommodate 1 byte
-   more than the longest receivable packet.  Only Internet packets are
-   dealt with currently.  */
-long rpc2_RecvPacket(IN long whichSocket, OUT RPC2_PacketBuffer *whichBuff)
+/* Finishes up a packet that was received into whichBuff, rc is the return
+   value of secure_recvfrom and len the available space in whichBuff. */
+static long RecvComplete(long whichSocket, RPC2_PacketBuffer *whichBuff,
+                         long rc, long len, struct sockaddr *from,
+                         socklen_t fromlen)
 {
-    long rc, len;
-    socklen_t fromlen;
-    struct sockaddr_storage ss;
-
-    say(1, RPC2_DebugLevel, "rpc2_RecvPacket()\n");
-    assert(whichBuff->Prefix.LE.MagicNumber == OBJ_PACKETBUFFER);
-
-    len = whichBuff->Prefix.BufferSize - (long)(&whichBuff->Header) +
-          (long)(whichBuff);
-    assert(len > 0);
-
-    /* WARNING: only Internet works; no warnings */
-    fromlen = sizeof(ss);
-    rc      = secure_recvfrom(whichSocket, &whichBuff->Header, len, 0,
-                         (struct sockaddr *)&ss, &fromlen,
-                         &whichBuff->Prefix.sa, rpc2_GetSA);
     if (rc > len) {
         errno = ENOMEM;
         rc    = -1;
@@ -276,8 +418,8 @@ long rpc2_RecvPacket(IN long whichSocket, OUT RPC2_PacketBuffer *whichBuff)
         return -1;
     }
 
-    whichBuff->Prefix.PeerAddr = RPC2_allocaddrinfo(
-        (struct sockaddr *)&ss, fromlen, SOCK_DGRAM, IPPROTO_UDP);
+    whichBuff->Prefix.PeerAddr =
+        RPC2_allocaddrinfo(from, fromlen, SOCK_DGRAM, IPPROTO_UDP);
 
     TR_RECV();
 
@@ -311,6 +453,81 @@ long rpc2_RecvPacket(IN long whichSocket, OUT RPC2_PacketBuffer *whichBuff)
     return (0);
 }
 
+static long RecvSpace(RPC2_PacketBuffer *whichBuff)
+{
+    return whichBuff->Prefix.BufferSize - (long)(&whichBuff->Header) +
+           (long)(whichBuff);
+}
+
+/* Reads the next packet from whichSocket into whichBuff, sets its
+   LengthOfPacket field, fills in whichHost and whichPort, and
+   returns 0; Returns -3 iff a too-long packet arrived.  Returns -1 on
+   any other system call error.
+
+   Note that whichBuff should at least be able to accommodate 1 byte
+   more than the longest receivable packet.  Only Internet packets are
+   dealt with currently.  */
+long rpc2_RecvPacket(IN long whichSocket, OUT RPC2_PacketBuffer *whichBuff)
+{
+    long rc, len;
+    socklen_t fromlen;
+    struct sockaddr_storage ss;
+
+    say(1, RPC2_DebugLevel, "rpc2_RecvPacket()\n");
+    assert(whichBuff->Prefix.LE.MagicNumber == OBJ_PACKETBUFFER);
+
+    len = RecvSpace(whichBuff);
+    assert(len > 0);
+
+    /* WARNING: only Internet works; no warnings */
+    fromlen = sizeof(ss);
+    rc      = secure_recvfrom(whichSocket, &whichBuff->Header, len, 0,
+                         (struct sockaddr *)&ss, &fromlen,
+                         &whichBuff->Prefix.sa, rpc2_GetSA);
+
+    return RecvComplete(whichSocket, whichBuff, rc, len, (struct sockaddr *)&ss,
+                        fromlen);
+}
+
+/* Batched version of rpc2_RecvPacket, reads up to count packets from
+   whichSocket without blocking. The return value of rpc2_RecvPacket for
+   each received packet is placed in results. Returns the number of
+   packets read, or -1 when no packets were waiting. */
+long rpc2_RecvPackets(IN long whichSocket, OUT RPC2_PacketBuffer **whichBuffs,
+                      IN long count, OUT long *results)
+{
+    struct secure_mmsg msgs[RPC2_MAXRECVBATCH];
+    long i, n;
+
+    say(1, RPC2_DebugLevel, "rpc2_RecvPackets()\n");
+
+    if (count > RPC2_MAXRECVBATCH)
+        count = RPC2_MAXRECVBATCH;
+
+    for (i = 0; i < count; i++) {
+        assert(whichBuffs[i]->Prefix.LE.MagicNumber == OBJ_PACKETBUFFER);
+        msgs[i].buf = &whichBuffs[i]->Header;
+        msgs[i].len = RecvSpace(whichBuffs[i]);
+        assert(msgs[i].len > 0);
+    }
+
+    n = secure_recvmmsg(whichSocket, msgs, count, 0, rpc2_GetSA);
+    if (n < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+            RecvComplete(whichSocket, whichBuffs[0], -1, msgs[0].len, NULL, 0);
+        return -1;
+    }
+
+    for (i = 0; i < n; i++) {
+        whichBuffs[i]->Prefix.sa = msgs[i].sa;
+        errno                    = msgs[i].err;
+        results[i] = RecvComplete(whichSocket, whichBuffs[i], msgs[i].n,
+                                  msgs[i].len, (struct sockaddr *)&msgs[i].peer,
+                                  msgs[i].peerlen);
+    }
+    return n;
+}
+
 /*
   Initializes default retry intervals given the number of
   retries desired and the keepalive interval.
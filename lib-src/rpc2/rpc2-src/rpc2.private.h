@@ -448,6 +448,7 @@ extern long rpc2_HostFreeCount, rpc2_HostCount, rpc2_HostCreationCount;
 
 /*------------- Miscellaneous  global data  ------------*/
 extern int rpc2_ipv6ready; /* can userspace handle IPv6 addresses */
+extern int rpc2_reuseport; /* share our port with other processes */
 extern int rpc2_v4RequestSocket; /* fd of RPC socket  */
 extern int rpc2_v6RequestSocket; /* fd of RPC socket  */
 /* we may need more when we deal with many domains */
@@ -501,9 +502,18 @@ long rpc2_CreateIPSocket(int af, int *svar, struct RPC2_addrinfo *addr,
 long rpc2_SendReliably(), rpc2_MSendPacketsReliably();
 void rpc2_XmitPacket(RPC2_PacketBuffer *pb, struct RPC2_addrinfo *addr,
                      int confirm);
+void rpc2_XmitCoalesce(RPC2_PacketBuffer *pb, struct RPC2_addrinfo *addr,
+                       int confirm, RPC2_Handle key);
+void rpc2_XmitInPlace(RPC2_PacketBuffer *pb, struct RPC2_addrinfo *addr,
+                      int confirm);
+void rpc2_XmitRelease(RPC2_PacketBuffer *pb);
+void rpc2_XmitCork(void);
+void rpc2_XmitUncork(void);
 void rpc2_InitPacket();
 int rpc2_MorePackets(void);
 long rpc2_RecvPacket(long whichSocket, RPC2_PacketBuffer *whichBuff);
+long rpc2_RecvPackets(long whichSocket, RPC2_PacketBuffer **whichBuffs,
+                      long count, long *results);
 void rpc2_htonp(RPC2_PacketBuffer *p);
 void rpc2_ntohp(RPC2_PacketBuffer *p);
 long rpc2_CancelRetry(struct CEntry *Conn, struct SL_Entry *Sle);
@@ -111,12 +111,27 @@ long RPC2_Init(
     if (Options && (Options->Flags & RPC2_OPTION_IPV6))
         rpc2_ipv6ready = 1;
 
+    if (Options && (Options->Flags & RPC2_OPTION_REUSEPORT))
+        rpc2_reuseport = 1;
+
     env = getenv("RPC2SEC_KEYSIZE");
     if (env)
         RPC2_Preferred_Keysize = atoi(env);
     if (RPC2_Preferred_Keysize > 64)
         RPC2_Preferred_Keysize /= 8;
 
+    env = getenv("RPC2_RECVBATCH");
+    if (env)
+        RPC2_RecvBatch = atoi(env);
+    if (RPC2_RecvBatch > RPC2_MAXRECVBATCH)
+        RPC2_RecvBatch = RPC2_MAXRECVBATCH;
+
+    env = getenv("RPC2_XMITBATCH");
+    if (env)
+        RPC2_XmitBatch = atoi(env);
+    if (RPC2_XmitBatch > RPC2_MAXXMITBATCH)
+        RPC2_XmitBatch = RPC2_MAXXMITBATCH;
+
     /* Do we accept only secure connections, default is yes. This can be
      * disabled by setting the RPC2SEC_ONLY to 0, false, no, (nada, forgetit) */
     env              = getenv("RPC2SEC_ONLY");
@@ -314,6 +329,9 @@ static RPC2_PacketBuffer *Gimme(long size, struct rpc2_LinkEntry **flist,
         rpc2_Replenish(flist, count, size, creacount, OBJ_PACKETBUFFER);
         assert(*flist);
         rpc2_LE2PB(*flist)->Prefix.BufferSize = size;
+        rpc2_PBStats.Misses++;
+    } else {
+        rpc2_PBStats.Hits++;
     }
 
     pb = rpc2_LE2PB(
@@ -379,6 +397,7 @@ long RPC2_FreeBuffer(INOUT RPC2_PacketBuffer **BuffPtr)
         return (RPC2_SUCCESS);
 
     assert((*BuffPtr)->Prefix.LE.MagicNumber == OBJ_PACKETBUFFER);
+    rpc2_XmitRelease(*BuffPtr);
 
     if ((*BuffPtr)->Prefix.PeerAddr) {
         RPC2_freeaddrinfo((*BuffPtr)->Prefix.PeerAddr);
@@ -628,6 +647,11 @@ long RPC2_DumpState(FILE *DumpFile, long Verbosity /* > 0 ==> full dump */)
     fprintf(DumpFile,
             "rpc2_PBLargeFreeCount = %ld  rpc2_PBLargeCreationCount = %ld\n",
             rpc2_PBLargeFreeCount, rpc2_PBLargeCreationCount);
+    fprintf(DumpFile,
+            "rpc2_PBStats: Hits = %lu  Misses = %lu  Copied = %lu  "
+            "InPlace = %lu\n",
+            rpc2_PBStats.Hits, rpc2_PBStats.Misses, rpc2_PBStats.Copied,
+            rpc2_PBStats.InPlace);
 
     fprintf(DumpFile,
             "rpc2_SLCreationCount = %ld rpc2_SLFreeCount = %ld  "
@@ -959,6 +983,19 @@ long rpc2_CreateIPSocket(int af, int *svar, struct RPC2_addrinfo *addr,
         flags = fcntl(*svar, F_GETFL, 0);
         fcntl(*svar, F_SETFL, flags | O_NONBLOCK);
 
+#ifdef SO_REUSEPORT
+        /* allow other instances of this server to bind to the same port,
+         * the kernel spreads incoming peers over the bound sockets */
+        if (rpc2_reuseport) {
+            int one = 1;
+            if (setsockopt(*svar, SOL_SOCKET, SO_REUSEPORT, &one,
+                           sizeof(one)) < 0)
+                say(-1, RPC2_DebugLevel,
+                    "rpc2_CreateIPSocket: SO_REUSEPORT failed: %s\n",
+                    strerror(errno));
+        }
+#endif
+
         /* Now bind the socket */
         if (bind(*svar, addr->ai_addr, addr->ai_addrlen) < 0) {
             err = (errno == EADDRINUSE) ? RPC2_DUPLICATESERVER : RPC2_BADSERVER;
@@ -150,6 +150,8 @@ void SFTP_Activate(SFTP_Initializer *initPtr)
         SFTP_MaxPackets   = initPtr->MaxPackets;
     }
     assert(SFTP_SendAhead <= 16); /* 'cause of readv() bogosity */
+    if (SFTP_WindowSize > SFTP_MAXWINDOWSIZE)
+        SFTP_WindowSize = SFTP_MAXWINDOWSIZE;
 
     /* Enlarge table by one */
     SE_DefCount++;
@@ -279,12 +281,12 @@ long SFTP_MakeRPC1(IN RPC2_Handle ConnHandle, INOUT SE_Descriptor *SDesc,
         se->SendMostRecent   = se->SendLastContig;
         se->SendWorriedLimit = se->SendLastContig;
         se->SendAckLimit     = se->SendLastContig;
-        memset(se->SendTheseBits, 0, BITMASKWIDTH * sizeof(long));
+        memset(se->SendTheseBits, 0, sizeof(int) * BITMASKWIDTH);
         se->ReadAheadCount = 0;
         rc                 = sftp_InitIO(se);
     } else {
         se->RecvMostRecent = se->RecvLastContig;
-        memset(se->RecvTheseBits, 0, BITMASKWIDTH * sizeof(long));
+        memset(se->RecvTheseBits, 0, sizeof(int) * BITMASKWIDTH);
         rc = sftp_InitIO(se);
     }
     if (rc < 0) {
@@ -346,7 +348,7 @@ long SFTP_MakeRPC2(IN RPC2_Handle ConnHandle, INOUT SE_Descriptor *SDesc,
     }
 
     /* Clean up local state */
-    for (i = 0; i < MAXOPACKETS; i++)
+    for (i = 0; i < se->MaxPackets; i++)
         if (se->ThesePackets[i] != NULL)
             SFTP_FreeBuffer(&se->ThesePackets[i]);
     sftp_vfclose(se);
@@ -911,6 +913,7 @@ int sftp_AddPiggy(RPC2_PacketBuffer **whichP, char *dPtr, off_t dSize,
  * maxSize	- how large whichP can grow to */
 /* If specified data can be piggy backed within a packet no larger than maxSize,
    adds the data and sets SEFlags and SEDataOffset. Enlarges packet if needed.
+   When dPtr is NULL the data has already been placed at the end of the body.
    Returns 0 if data has been piggybacked, -1 if maxSize would be exceeded
 */
 {
@@ -928,7 +931,8 @@ int sftp_AddPiggy(RPC2_PacketBuffer **whichP, char *dPtr, off_t dSize,
         (*whichP)->Header.SEFlags |= SFTP_PIGGY;
     }
 
-    memcpy((*whichP)->Body + (*whichP)->Header.BodyLength, dPtr, dSize);
+    if (dPtr)
+        memcpy((*whichP)->Body + (*whichP)->Header.BodyLength, dPtr, dSize);
     (*whichP)->Header.BodyLength += dSize;
     (*whichP)->Prefix.LengthOfPacket =
         sizeof(struct RPC2_PacketHeader) + (*whichP)->Header.BodyLength;
@@ -947,8 +951,6 @@ off_t sftp_AppendFileToPacket(struct SFTP_Entry *sEntry,
     long rc, maxbytes;
     off_t filelen;
     struct CEntry *ce;
-    /* buffer for read(); avoids huge local on my stack */
-    static char GlobalJunk[SFTP_MAXBODYSIZE];
 
     filelen = sftp_piggybackfilesize(sEntry);
     if (filelen < 0)
@@ -966,11 +968,14 @@ off_t sftp_AppendFileToPacket(struct SFTP_Entry *sEntry,
     if (filelen > (off_t)maxbytes)
         return (-2);
 
-    /* enough space: append the file! */
-    rc = sftp_piggybackfileread(sEntry, GlobalJunk);
+    /* enough space: read the file straight into the end of the packet */
+    if (MakeBigEnough(whichP, filelen, SFTP_MAXPACKETSIZE) < 0)
+        return (-2);
+    rc = sftp_piggybackfileread(
+        sEntry, (char *)&(*whichP)->Body[(*whichP)->Header.BodyLength]);
     if (rc < 0)
         return (-1);
-    assert(!sftp_AddPiggy(whichP, GlobalJunk, filelen, SFTP_MAXPACKETSIZE));
+    assert(!sftp_AddPiggy(whichP, NULL, filelen, SFTP_MAXPACKETSIZE));
     sEntry->HitEOF = TRUE;
     ce             = rpc2_GetConn(sEntry->LocalHandle);
     if (ce)
@@ -1085,6 +1090,9 @@ int sftp_ExtractParmsFromPacket(struct SFTP_Entry *sEntry,
 
     if (sEntry->WindowSize < SFTP_MINWINDOWSIZE)
         sEntry->WindowSize = SFTP_MINWINDOWSIZE;
+    /* we can't track more outstanding packets than we have buffers for */
+    if (sEntry->WindowSize > sEntry->MaxPackets)
+        sEntry->WindowSize = sEntry->MaxPackets;
     if (sEntry->SendAhead < SFTP_MINSENDAHEAD)
         sEntry->SendAhead = SFTP_MINSENDAHEAD;
     if (sEntry->PacketSize < SFTP_MINPACKETSIZE)
@@ -1120,6 +1128,14 @@ struct SFTP_Entry *sftp_AllocSEntry(void)
     sfp->RecvQueue      = NULL;
     sfp->RecvQueueLen   = 0;
     CLRTIME(&sfp->LastWord);
+
+    /* size the packet ring so that PBUFF() can use a mask, windows that fit
+     * in the header bitmask always get the full MAXOPACKETS */
+    sfp->MaxPackets = MAXOPACKETS;
+    while (sfp->MaxPackets < sfp->WindowSize)
+        sfp->MaxPackets <<= 1;
+    assert((sfp->ThesePackets = (RPC2_PacketBuffer **)calloc(
+                sfp->MaxPackets, sizeof(RPC2_PacketBuffer *))) != NULL);
     return (sfp);
 }
 
@@ -1140,9 +1156,10 @@ void sftp_FreeSEntry(struct SFTP_Entry *se)
     sftp_vfclose(se);
     if (se->PiggySDesc)
         sftp_FreePiggySDesc(se);
-    for (i = 0; i < MAXOPACKETS; i++)
+    for (i = 0; i < se->MaxPackets; i++)
         if (se->ThesePackets[i] != NULL)
             SFTP_FreeBuffer(&se->ThesePackets[i]);
+    free(se->ThesePackets);
     if (se->HostInfo)
         rpc2_FreeHost(&se->HostInfo);
     free(se);
@@ -88,7 +88,9 @@ static int CheckWorried(struct SFTP_Entry *sEntry);
 static int ResendWorried(struct SFTP_Entry *sEntry);
 static int SendSendAhead(struct SFTP_Entry *sEntry);
 static int SendFirstUnacked(struct SFTP_Entry *sEntry, int winopen);
+static uint32_t SendWindow(struct SFTP_Entry *sEntry);
 static int WinIsOpen(struct SFTP_Entry *sEntry);
+static int WriteContig(struct SFTP_Entry *sEntry);
 static void sftp_SendAck(struct SFTP_Entry *sEntry);
 static int sftp_vfwritev(struct SFTP_Entry *se, struct iovec *iovarray,
                          long howMany);
@@ -317,9 +319,12 @@ int sftp_DataArrived(RPC2_PacketBuffer *pBuff, struct SFTP_Entry *sEntry)
          * the sender may advance its window.
          * If we are the server we only want to respond with an ACK if we
          * were able to advance the window, we will timeout and retransmit
-         * an ACK if necessary. -JH */
-        if (sEntry->WhoAmI == SFSERVER &&
-            ((pBuff->Header.Flags & SFTP_ACKME) ||
+         * an ACK if necessary. -JH
+         * A retransmission that asks for an ACK means the source is stuck
+         * waiting for one we sent earlier, so always answer those, also on
+         * the client, otherwise a lost ACK with a closed window is fatal. */
+        if ((pBuff->Header.Flags & SFTP_ACKME) ||
+            (sEntry->WhoAmI == SFSERVER &&
              sEntry->DupsSinceAck > sEntry->DupThreshold)) {
             sftp_SendAck(sEntry);
             /* we need write here 'cause we may not flush buffers otherwise */
@@ -362,7 +367,7 @@ int sftp_DataArrived(RPC2_PacketBuffer *pBuff, struct SFTP_Entry *sEntry)
 
     if (pBuff->Header.SeqNumber > sEntry->RecvMostRecent)
         sEntry->RecvMostRecent = pBuff->Header.SeqNumber;
-    j                       = PBUFF(pBuff->Header.SeqNumber);
+    j                       = PBUFF(sEntry, pBuff->Header.SeqNumber);
     sEntry->ThesePackets[j] = pBuff;
 
     /* ackme flag is set? */
@@ -376,9 +381,8 @@ int sftp_DataArrived(RPC2_PacketBuffer *pBuff, struct SFTP_Entry *sEntry)
             for (i = 1; sEntry->RecvLastContig + i <= sEntry->RecvMostRecent;
                  i++)
                 if (TESTBIT(sEntry->RecvTheseBits, i)) {
-                    pb =
-                        sEntry
-                            ->ThesePackets[PBUFF((sEntry->RecvLastContig + i))];
+                    j  = PBUFF(sEntry, sEntry->RecvLastContig + i);
+                    pb = sEntry->ThesePackets[j];
                     if (pb->Header.TimeEcho >= pBuff->Header.TimeEcho &&
                         !(pb->Header.SEFlags & SFTP_COUNTED)) {
                         dataThisRound += pb->Prefix.LengthOfPacket;
@@ -420,7 +424,10 @@ int sftp_DataArrived(RPC2_PacketBuffer *pBuff, struct SFTP_Entry *sEntry)
         if (!TESTBIT(sEntry->RecvTheseBits, i))
             return (0);
 
-    /* Yes, we did receive every packet! */
+    /* Yes, we did receive every packet! Let the source know if the packet
+     * that completed the file didn't already trigger an ack. */
+    if (sEntry->RecvSinceAck)
+        sftp_SendAck(sEntry);
     if (sftp_WriteStrategy(sEntry) < 0)
         return (-1); /* one last time */
     sEntry->XferState = XferCompleted;
@@ -436,6 +443,19 @@ int sftp_WriteStrategy(struct SFTP_Entry *sEntry)
 
    Returns 0 if normal, -1 if fatal error of some kind occurred.
    Marks connection DISKERROR on failure.  */
+{
+    int rc;
+
+    /* with large windows there may be more contiguous packets than fit in
+     * a single writev */
+    while ((rc = WriteContig(sEntry)) > 0)
+        ;
+    return rc;
+}
+
+static int WriteContig(struct SFTP_Entry *sEntry)
+/* Write out at most MAXOPACKETS packets starting at RecvLastContig+1.
+   Returns the number of packets written, or -1 on failure. */
 {
     RPC2_PacketBuffer *pb;
     struct iovec iovarray[MAXOPACKETS];
@@ -449,7 +469,7 @@ int sftp_WriteStrategy(struct SFTP_Entry *sEntry)
         if (!TESTBIT(sEntry->RecvTheseBits, i))
             break;
 
-        pb = sEntry->ThesePackets[PBUFF((sEntry->RecvLastContig + i))];
+        pb = sEntry->ThesePackets[PBUFF(sEntry, sEntry->RecvLastContig + i)];
         iovarray[i - 1].iov_base = (caddr_t)pb->Body;
 
         x = sEntry->SDesc->Value.SmartFTPD.BytesTransferred + bytesnow;
@@ -478,14 +498,14 @@ int sftp_WriteStrategy(struct SFTP_Entry *sEntry)
 
     for (i = sEntry->RecvLastContig + 1;
          i < sEntry->RecvLastContig + iovlen + 1; i++)
-        SFTP_FreeBuffer(&sEntry->ThesePackets[PBUFF(i)]);
+        SFTP_FreeBuffer(&sEntry->ThesePackets[PBUFF(sEntry, i)]);
     sEntry->RecvLastContig += iovlen;
     B_ShiftLeft(sEntry->RecvTheseBits, iovlen);
 
     sftp_Progress(sEntry->SDesc,
                   sEntry->SDesc->Value.SmartFTPD.BytesTransferred + bytesnow);
 
-    return (0);
+    return (iovlen);
 }
 
 static void sftp_SendAck(struct SFTP_Entry *sEntry)
@@ -495,15 +515,20 @@ static void sftp_SendAck(struct SFTP_Entry *sEntry)
    Returns 0 if normal, -1 if fatal error of some kind occurred.  */
 {
     RPC2_PacketBuffer *pb;
-    long i, shiftlen;
+    long i, shiftlen, extra = 0;
     unsigned int btemp[BITMASKWIDTH], now;
     int confirm = 1;
 
     sftp_acks++;
     sftp_Sent.Acks++;
 
-    SFTP_AllocBuffer(0, &pb);
-    sftp_InitPacket(pb, sEntry, 0);
+    /* windows larger than the header bitmask need the rest of the
+     * bitmask in the body of the ack */
+    if (sEntry->WindowSize > MAXOPACKETS)
+        extra = ((sEntry->WindowSize + 31) / 32 - 2) * sizeof(uint32_t);
+
+    SFTP_AllocBuffer(extra, &pb);
+    sftp_InitPacket(pb, sEntry, extra);
     pb->Header.SeqNumber = ++(sEntry->CtrlSeqNumber);
     pb->Header.Opcode    = SFTP_ACK;
     pb->Header.GotEmAll  = sEntry->RecvLastContig;
@@ -563,6 +588,7 @@ int sftp_AckArrived(RPC2_PacketBuffer *pBuff, struct SFTP_Entry *sEntry)
 {
     long prun, i;
     unsigned long dataThisRound = 0;
+    unsigned int acked[BITMASKWIDTH];
     RPC2_PacketBuffer *pb;
 
     sftp_ackr++;
@@ -618,14 +644,16 @@ int sftp_AckArrived(RPC2_PacketBuffer *pBuff, struct SFTP_Entry *sEntry)
          * look at packets represented in the bitmask.  Note these,
          * unlike the received packets, are in network order!!  */
         for (i = sEntry->SendLastContig + 1; i <= pBuff->Header.GotEmAll; i++) {
-            pb = sEntry->ThesePackets[PBUFF(i)];
+            pb = sEntry->ThesePackets[PBUFF(sEntry, i)];
             if (!(ntohl(pb->Header.SEFlags) & SFTP_COUNTED))
                 dataThisRound += pb->Prefix.LengthOfPacket;
         }
 
-        for (i = 1; i <= sizeof(int) * BITMASKWIDTH; i++)
-            if (TESTBIT(&pBuff->Header.BitMask0, i)) {
-                pb = sEntry->ThesePackets[PBUFF(pBuff->Header.GotEmAll + i)];
+        B_CopyFromPacket(pBuff, acked);
+        for (i = 1; pBuff->Header.GotEmAll + i <= sEntry->SendMostRecent; i++)
+            if (TESTBIT(acked, i)) {
+                pb = sEntry->ThesePackets[PBUFF(sEntry,
+                                                pBuff->Header.GotEmAll + i)];
                 if (!(ntohl(pb->Header.SEFlags) & SFTP_COUNTED) &&
                     (pBuff->Header.TimeEcho <= ntohl(pb->Header.TimeStamp))) {
                     dataThisRound += pb->Prefix.LengthOfPacket;
@@ -652,7 +680,7 @@ int sftp_AckArrived(RPC2_PacketBuffer *pBuff, struct SFTP_Entry *sEntry)
     /* acked non-prefix packets are still kept, even though not needed */
     for (i = 0; i < prun; i++)
         SFTP_FreeBuffer(
-            &sEntry->ThesePackets[PBUFF((sEntry->SendLastContig - i))]);
+            &sEntry->ThesePackets[PBUFF(sEntry, sEntry->SendLastContig - i)]);
 
     /* Do we have more work to do? */
     if (sEntry->HitEOF && sEntry->ReadAheadCount == 0 &&
@@ -783,7 +811,21 @@ int sftp_SendStrategy(struct SFTP_Entry *sEntry)
         if (worried && SendFirstUnacked(sEntry, 1) < 0)
             return (-1);
 
-        return SendSendAhead(sEntry); /* may close window */
+        if (SendSendAhead(sEntry) < 0) /* may close window */
+            return (-1);
+
+        /* Adaptive windows are much larger than a single SendAhead set,
+         * keep reading and sending until we've filled the window. */
+        while (sEntry->WindowSize > MAXOPACKETS && !sEntry->HitEOF &&
+               WinIsOpen(sEntry)) {
+            if (sftp_ReadStrategy(sEntry) < 0)
+                return (-1);
+            if (sEntry->ReadAheadCount == 0)
+                break;
+            if (SendSendAhead(sEntry) < 0)
+                return (-1);
+        }
+        return (0);
     }
 
     /* Hit EOF, try to flush the last packets to the other side. We should be
@@ -828,7 +870,7 @@ static int CheckWorried(struct SFTP_Entry *sEntry)
         /* check the timestamp and see if a timeout interval has
            occurred, if so let's start thinking about retransmitting
            the packet */
-        thePacket = sEntry->ThesePackets[PBUFF(i)];
+        thePacket = sEntry->ThesePackets[PBUFF(sEntry, i)];
         if (!thePacket)
             continue;
 
@@ -860,9 +902,10 @@ static int ResendWorried(struct SFTP_Entry *sEntry)
     int acked = 0;
 
     /* Now send them out */
+    rpc2_XmitCork();
     for (i = sEntry->SendLastContig + 1; i <= sEntry->SendWorriedLimit; i++) {
         if (!TESTBIT(sEntry->SendTheseBits, i - sEntry->SendLastContig)) {
-            pb               = sEntry->ThesePackets[PBUFF(i)];
+            pb               = sEntry->ThesePackets[PBUFF(sEntry, i)];
             pb->Header.Flags = ntohl(pb->Header.Flags);
             if (pb->Header.Flags & SFTP_ACKME)
                 sftp_ackslost++;
@@ -907,6 +950,7 @@ static int ResendWorried(struct SFTP_Entry *sEntry)
             sftp_XmitPacket(sEntry, pb, 0);
         }
     }
+    rpc2_XmitUncork();
 
     return (0);
 }
@@ -921,7 +965,7 @@ static int SendFirstUnacked(struct SFTP_Entry *sEntry, int winopen)
     unsigned long now;
 
     /* By definition, SendLastContig+1 is first unacked pkt */
-    pb = sEntry->ThesePackets[PBUFF(sEntry->SendLastContig + 1)];
+    pb = sEntry->ThesePackets[PBUFF(sEntry, sEntry->SendLastContig + 1)];
 
     /* Resend it */
     pb->Header.Flags = ntohl(pb->Header.Flags);
@@ -994,9 +1038,11 @@ static int SendSendAhead(struct SFTP_Entry *sEntry)
     else
         j = sEntry->SendMostRecent + sEntry->AckPoint;
 
+    /* send the whole SendAhead set in as few system calls as possible */
+    rpc2_XmitCork();
     for (i = 0; i < sEntry->ReadAheadCount; i++) {
         sEntry->SendMostRecent++;
-        pb = sEntry->ThesePackets[PBUFF((sEntry->SendMostRecent))];
+        pb = sEntry->ThesePackets[PBUFF(sEntry, sEntry->SendMostRecent)];
         if (!dont_ackme &&
             sEntry->SendMostRecent == j) { /* Middle packet: demand ack */
             sEntry->SendAckLimit = sEntry->SendMostRecent;
@@ -1034,6 +1080,13 @@ static int SendSendAhead(struct SFTP_Entry *sEntry)
             (unsigned long)ntohl(pb->Header.TimeStamp),
             (unsigned long)ntohl(pb->Header.TimeEcho));
     }
+    rpc2_XmitUncork();
+
+    /* The last packet of the file always demands an ack, even when we
+     * skipped the ackme above, make sure it is covered when we start to
+     * worry about retransmissions. */
+    if (sEntry->HitEOF)
+        sEntry->SendAckLimit = sEntry->SendMostRecent;
 
     sEntry->ReadAheadCount = 0; /* we have eaten all of them */
     return (0);
@@ -1070,7 +1123,7 @@ int sftp_ReadStrategy(struct SFTP_Entry *sEntry)
         pb->Header.SeqNumber = sEntry->SendMostRecent + i;
         rpc2_htonp(pb);
 
-        j                        = PBUFF((sEntry->SendMostRecent + i));
+        j                        = PBUFF(sEntry, sEntry->SendMostRecent + i);
         sEntry->ThesePackets[j]  = pb;
         iovarray[i - 1].iov_base = (caddr_t)pb->Body;
         iovarray[i - 1].iov_len  = bodylength;
@@ -1104,7 +1157,7 @@ int sftp_ReadStrategy(struct SFTP_Entry *sEntry)
             sEntry->PInfo.SecurityLevel == RPC2_SECURE) {
             /* Encrypt all packets here */
             for (i = 1; i < 1 + sEntry->SendAhead; i++) {
-                j  = PBUFF((sEntry->SendMostRecent + i));
+                j  = PBUFF(sEntry, sEntry->SendMostRecent + i);
                 pb = sEntry->ThesePackets[j];
                 sftp_Encrypt(pb, sEntry);
                 pb->Header.Flags =
@@ -1122,7 +1175,7 @@ int sftp_ReadStrategy(struct SFTP_Entry *sEntry)
             if (!sEntry->sa->encrypt &&
                 sEntry->PInfo.SecurityLevel == RPC2_SECURE) {
                 /* encrypt packet */
-                j  = PBUFF((sEntry->SendMostRecent + i));
+                j  = PBUFF(sEntry, sEntry->SendMostRecent + i);
                 pb = sEntry->ThesePackets[j];
                 sftp_Encrypt(pb, sEntry);
                 pb->Header.Flags |= RPC2_ENCRYPTED;
@@ -1131,7 +1184,7 @@ int sftp_ReadStrategy(struct SFTP_Entry *sEntry)
         }
 
         /* this is the packet with the last data byte */
-        pb = sEntry->ThesePackets[PBUFF((sEntry->SendMostRecent + i))];
+        pb = sEntry->ThesePackets[PBUFF(sEntry, sEntry->SendMostRecent + i)];
         rpc2_ntohp(pb);
         pb->Header.BodyLength = bytesread;
         pb->Header.SEFlags    = 0; /* turn off MOREDATA */
@@ -1152,7 +1205,7 @@ int sftp_ReadStrategy(struct SFTP_Entry *sEntry)
     /* release excess packets */
     for (i++; i < sEntry->SendAhead + 1; i++)
         SFTP_FreeBuffer(
-            &sEntry->ThesePackets[PBUFF((sEntry->SendMostRecent + i))]);
+            &sEntry->ThesePackets[PBUFF(sEntry, sEntry->SendMostRecent + i)]);
 
     return (0);
 }
@@ -1272,10 +1325,35 @@ int sftp_SendTrigger(struct SFTP_Entry *sEntry)
     return (0);
 }
 
+static uint32_t SendWindow(struct SFTP_Entry *sEntry)
+/* Number of packets we allow to be outstanding. Windows that fit in the
+   header bitmask are used as is. Larger windows are adaptive, we only
+   fill as much of the window as is needed to cover twice the estimated
+   bandwidth-delay product to the peer, but never less than MAXOPACKETS. */
+{
+    struct HEntry *he = sEntry->HostInfo;
+    uint64_t bdp;
+
+    if (sEntry->WindowSize <= MAXOPACKETS)
+        return sEntry->WindowSize;
+    if (!he || !sEntry->PacketSize)
+        return MAXOPACKETS;
+
+    /* RTT is in us << RPC2_RTT_SHIFT, BWhi_out in bytes/s */
+    bdp = (uint64_t)he->BWhi_out * (he->RTT >> RPC2_RTT_SHIFT) / 1000000;
+    bdp = 2 * bdp / sEntry->PacketSize;
+
+    if (bdp < MAXOPACKETS)
+        return MAXOPACKETS;
+    if (bdp > sEntry->WindowSize)
+        return sEntry->WindowSize;
+    return (uint32_t)bdp;
+}
+
 static int WinIsOpen(struct SFTP_Entry *sEntry)
 {
     if ((sEntry->SendAhead + sEntry->SendMostRecent - sEntry->SendLastContig) >
-        sEntry->WindowSize)
+        SendWindow(sEntry))
         return (FALSE);
     if ((SFTP_MaxPackets > 0) &&
         (sftp_PacketsInUse + sEntry->SendAhead > SFTP_MaxPackets)) {
@@ -1387,11 +1465,8 @@ int sftp_piggybackfileread(struct SFTP_Entry *se, char *buf)
         p = &se->SDesc->Value.SmartFTPD.FileInfo.ByAddr;
         memcpy(buf, p->vmfile.SeqBody, sftp_piggybackfilesize(se));
     } else {
-        if (BYFDFILE(se->SDesc))
-            (void)lseek(se->openfd, se->fd_offset, SEEK_SET);
-
         len = sftp_piggybackfilesize(se);
-        n   = read(se->openfd, buf, len);
+        n   = pread(se->openfd, buf, len, se->fd_offset);
         if (n < len)
             return (RPC2_SEFAIL4);
     }
@@ -1414,10 +1489,7 @@ int sftp_vfwritefile(struct SFTP_Entry *se, char *buf, int nbytes)
         memcpy(p->vmfile.SeqBody, buf, nbytes);
         p->vmfile.SeqLen = nbytes;
     } else {
-        if (BYFDFILE(se->SDesc))
-            (void)lseek(se->openfd, se->fd_offset, SEEK_SET);
-
-        n = write(se->openfd, buf, nbytes);
+        n = pwrite(se->openfd, buf, nbytes, se->fd_offset);
         if (n < nbytes) {
             if (errno == ENOSPC)
                 return (RPC2_SEFAIL3);
@@ -1437,6 +1509,10 @@ void sftp_vfclose(struct SFTP_Entry *se)
         say(10, SFTP_DebugLevel, "sftp_vfclose: fd was already closed.\n");
         return;
     }
+    /* file data is read and written at explicit offsets, leave the offset of
+     * a descriptor we share with the caller where the transfer ended */
+    if (BYFDFILE(se->SDesc))
+        (void)lseek(se->openfd, se->fd_offset, SEEK_SET);
     close(se->openfd); /* ignoring errors */
     se->openfd    = -1;
     se->fd_offset = 0;
@@ -1452,12 +1528,15 @@ static int sftp_vfreadv(struct SFTP_Entry *se, struct iovec iovarray[],
     struct FileInfoByAddr *x;
     int n;
 
-    /* Go to the disk if we must */
+    /* Go to the disk if we must, the data is read straight into the packet
+     * buffers that are handed to the transmit queue */
     if (!MEMFILE(se->SDesc)) {
-        if (BYFDFILE(se->SDesc))
-            (void)lseek(se->openfd, se->fd_offset, SEEK_SET);
-
+#ifdef HAVE_PREADV
+        n = preadv(se->openfd, iovarray, howMany, se->fd_offset);
+#else
+        (void)lseek(se->openfd, se->fd_offset, SEEK_SET);
         n = readv(se->openfd, iovarray, howMany);
+#endif
 
         if (n > 0)
             se->fd_offset += n;
@@ -1502,16 +1581,25 @@ static int sftp_vfwritev(struct SFTP_Entry *se, struct iovec *iovarray,
     result = 0;
     left   = howMany;
 
+#ifndef HAVE_PWRITEV
     /* let's hope we won't have to share a non-seekable fd because the lseek
      * will fail */
-    if (BYFDFILE(se->SDesc))
+    if (!MEMFILE(se->SDesc))
         (void)lseek(se->openfd, se->fd_offset, SEEK_SET);
+#endif
 
     while (left > 0) {
         thistime = (left > 16) ? 16 : left;
 
         if (!MEMFILE(se->SDesc)) {
+            /* received data goes from the packet buffers straight to its
+             * offset in the file */
+#ifdef HAVE_PWRITEV
+            rc = pwritev(se->openfd, &iovarray[howMany - left], thistime,
+                         se->fd_offset);
+#else
             rc = writev(se->openfd, &iovarray[howMany - left], thistime);
+#endif
             if (rc > 0)
                 se->fd_offset += rc;
         } else { /* in-memory file; copy it to the user's buffer */
@@ -85,7 +85,17 @@ int sftp_XmitPacket(struct SFTP_Entry *sEntry, RPC2_PacketBuffer *pb,
     te->ph    = pb->Header; /* structure assignment */
 #endif
 
-    rpc2_XmitPacket(pb, sEntry->HostInfo->Addr, confirm);
+    /* the latest ack for a transfer supersedes any earlier ones, so an ack
+     * that is still sitting in the transmit queue can simply be replaced.
+     * Data packets are kept in ThesePackets until they are acked and do not
+     * have to be copied into the transmit queue. */
+    if (ntohl(pb->Header.Opcode) == SFTP_ACK)
+        rpc2_XmitCoalesce(pb, sEntry->HostInfo->Addr, confirm,
+                          sEntry->LocalHandle);
+    else if (ntohl(pb->Header.Opcode) == SFTP_DATA)
+        rpc2_XmitInPlace(pb, sEntry->HostInfo->Addr, confirm);
+    else
+        rpc2_XmitPacket(pb, sEntry->HostInfo->Addr, confirm);
 
     rpc2_Sent.Total--;
     rpc2_Sent.Bytes -= pb->Prefix.LengthOfPacket;
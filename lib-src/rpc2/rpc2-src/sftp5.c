@@ -141,16 +141,40 @@ void B_Assign(unsigned int *dest, unsigned int *src)
     memcpy(dest, src, sizeof(int) * BITMASKWIDTH);
 }
 
+/* Bits beyond the first MAXOPACKETS do not fit in the header, they are
+ * carried in the body of the ack as 32-bit words in network order. The caller
+ * sizes the body to match the window, older peers never send or expect more
+ * than the header bits. */
 void B_CopyToPacket(unsigned int *bMask, RPC2_PacketBuffer *whichPacket)
 {
-    assert(BITMASKWIDTH <= 2); /* for now */
+    uint32_t *extra = (uint32_t *)whichPacket->Body;
+    unsigned int i, n;
+
     whichPacket->Header.BitMask0 = (unsigned)bMask[0];
     whichPacket->Header.BitMask1 = (unsigned)bMask[1];
+
+    n = whichPacket->Header.BodyLength / sizeof(uint32_t);
+    for (i = 0; i < n && i + 2 < BITMASKWIDTH; i++)
+        extra[i] = htonl(bMask[i + 2]);
 }
 
 void B_CopyFromPacket(RPC2_PacketBuffer *whichPacket, unsigned int *bMask)
 {
-    assert(BITMASKWIDTH <= 2); /* for now */
+    uint32_t *extra = (uint32_t *)whichPacket->Body;
+    unsigned int i, n;
+    long len;
+
     bMask[0] = (unsigned)whichPacket->Header.BitMask0;
     bMask[1] = (unsigned)whichPacket->Header.BitMask1;
+
+    /* don't trust BodyLength beyond what actually arrived */
+    len = whichPacket->Header.BodyLength;
+    if (len > whichPacket->Prefix.LengthOfPacket -
+                  sizeof(struct RPC2_PacketHeader))
+        len = whichPacket->Prefix.LengthOfPacket -
+              sizeof(struct RPC2_PacketHeader);
+
+    n = len / sizeof(uint32_t);
+    for (i = 2; i < BITMASKWIDTH; i++)
+        bMask[i] = (i - 2 < n) ? ntohl(extra[i - 2]) : 0;
 }
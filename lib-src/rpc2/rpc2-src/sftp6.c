@@ -217,9 +217,10 @@ long SFTP_DeleteMgrp(RPC2_Handle MgroupHandle, struct RPC2_addrinfo *ClientAddr,
         sftp_vfclose(mse);
         if (mse->PiggySDesc != NULL)
             sftp_FreePiggySDesc(mse);
-        for (i = 0; i < MAXOPACKETS; i++)
+        for (i = 0; i < mse->MaxPackets; i++)
             if (mse->ThesePackets[i] != NULL)
                 SFTP_FreeBuffer(&mse->ThesePackets[i]);
+        free(mse->ThesePackets);
         free(mse);
         me->SideEffectPtr = NULL;
     }
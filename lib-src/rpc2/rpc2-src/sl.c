@@ -59,6 +59,9 @@ Pittsburgh, PA.
 #include <sys/time.h>
 #include <assert.h>
 #include "rpc2.private.h"
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
 #include <rpc2/secure.h>
 #include <rpc2/se.h>
 #include "trace.h"
@@ -178,6 +181,63 @@ int rpc2_MorePackets(void)
     return rpc2_CheckFDs(select, &tv);
 }
 
+#ifdef HAVE_SYS_EPOLL_H
+/* In batched receive mode the request sockets are registered with an epoll
+ * descriptor, IOMGR only has to watch that single fd and epoll tells us which
+ * socket is ready without building and scanning fd_sets. */
+static int rpc2_EpollFD = -1;
+
+static int rpc2_EpollInit(void)
+{
+    struct epoll_event ev;
+
+    rpc2_EpollFD = epoll_create(2);
+    if (rpc2_EpollFD == -1)
+        return -1;
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+
+    ev.data.fd = rpc2_v4RequestSocket;
+    if (rpc2_v4RequestSocket != -1 &&
+        epoll_ctl(rpc2_EpollFD, EPOLL_CTL_ADD, rpc2_v4RequestSocket, &ev) == -1)
+        goto err_out;
+
+    ev.data.fd = rpc2_v6RequestSocket;
+    if (rpc2_v6RequestSocket != -1 &&
+        epoll_ctl(rpc2_EpollFD, EPOLL_CTL_ADD, rpc2_v6RequestSocket, &ev) == -1)
+        goto err_out;
+
+    return 0;
+
+err_out:
+    close(rpc2_EpollFD);
+    rpc2_EpollFD = -1;
+    return -1;
+}
+
+/* Returns a request socket with pending packets, or -1. Only blocks (through
+ * IOMGR_Select) when tvp is not a zero timeout. */
+static int rpc2_CheckEpoll(struct timeval *tvp)
+{
+    struct epoll_event ev;
+    fd_set rmask;
+
+    if (!tvp || tvp->tv_sec || tvp->tv_usec) {
+        FD_ZERO(&rmask);
+        FD_SET(rpc2_EpollFD, &rmask);
+
+        if (IOMGR_Select(rpc2_EpollFD + 1, &rmask, NULL, NULL, tvp) <= 0)
+            return -1;
+    }
+
+    if (epoll_wait(rpc2_EpollFD, &ev, 1, 0) != 1)
+        return -1;
+
+    return ev.data.fd;
+}
+#endif
+
 /* Await the earliest future event or a packet.
    Returns active fd if packet came, -1 if earliest event expired */
 static int PacketCame(void)
@@ -190,9 +250,26 @@ static int PacketCame(void)
     /* Yield control */
     say(999, RPC2_DebugLevel, "About to enter IOMGR_Select()\n");
 
+#ifdef HAVE_SYS_EPOLL_H
+    if (RPC2_RecvBatch > 1 && (rpc2_EpollFD != -1 || rpc2_EpollInit() == 0))
+        return rpc2_CheckEpoll(t ? &t->TimeLeft : NULL);
+#endif
+
     return rpc2_CheckFDs(IOMGR_Select, t ? &t->TimeLeft : NULL);
 }
 
+/* Returns a request socket with pending packets, or -1 */
+static int PacketsPending(void)
+{
+#ifdef HAVE_SYS_EPOLL_H
+    struct timeval tv = { 0, 0 };
+
+    if (rpc2_EpollFD != -1)
+        return rpc2_CheckEpoll(&tv);
+#endif
+    return rpc2_MorePackets();
+}
+
 static void DispatchPacket(RPC2_PacketBuffer *pb)
 {
     unsigned int i, ProtoVersion = ntohl(pb->Header.ProtoVersion);
@@ -208,24 +285,11 @@ static void DispatchPacket(RPC2_PacketBuffer *pb)
     BOGUS(pb, "Wrong version\n");
 }
 
-static void rpc2_ProcessPacket(int fd)
+static void rpc2_DeliverPacket(RPC2_PacketBuffer *pb)
 {
-    RPC2_PacketBuffer *pb = NULL;
     struct timeval tv;
     int rc;
 
-    /* We are guaranteed that there is a packet in the socket
-       buffer at this point */
-    RPC2_AllocBuffer(RPC2_MAXPACKETSIZE - sizeof(RPC2_PacketBuffer), &pb);
-    assert(pb != NULL);
-    assert(pb->Prefix.LE.Queue == &rpc2_PBList);
-
-    if (rpc2_RecvPacket(fd, pb) < 0) {
-        say(9, RPC2_DebugLevel, "Recv error, ignoring.\n");
-        RPC2_FreeBuffer(&pb);
-        return;
-    }
-
 #ifdef RPC2DEBUG
     if (RPC2_DebugLevel > 9) {
         fprintf(rpc2_tracefile, "Packet received from ");
@@ -255,6 +319,86 @@ static void rpc2_ProcessPacket(int fd)
     DispatchPacket(pb);
 }
 
+static void rpc2_ProcessPacket(int fd)
+{
+    RPC2_PacketBuffer *pb = NULL;
+
+    /* We are guaranteed that there is a packet in the socket
+       buffer at this point */
+    RPC2_AllocBuffer(RPC2_MAXPACKETSIZE - sizeof(RPC2_PacketBuffer), &pb);
+    assert(pb != NULL);
+    assert(pb->Prefix.LE.Queue == &rpc2_PBList);
+
+    if (rpc2_RecvPacket(fd, pb) < 0) {
+        say(9, RPC2_DebugLevel, "Recv error, ignoring.\n");
+        RPC2_FreeBuffer(&pb);
+        return;
+    }
+
+    rpc2_DeliverPacket(pb);
+}
+
+/* Pull in up to RPC2_RecvBatch packets with a single system call and
+ * dispatch them in arrival order. Returns non-zero when all buffers were
+ * filled, in which case there may be more packets waiting on fd. */
+static int rpc2_ProcessPackets(int fd)
+{
+    RPC2_PacketBuffer *bufs[RPC2_MAXRECVBATCH];
+    long results[RPC2_MAXRECVBATCH];
+    RPC2_PacketBuffer *pb;
+    long i, n, batch = RPC2_RecvBatch;
+
+    if (batch > RPC2_MAXRECVBATCH)
+        batch = RPC2_MAXRECVBATCH;
+
+    for (i = 0; i < batch; i++) {
+        RPC2_AllocBuffer(RPC2_MAXPACKETSIZE - sizeof(RPC2_PacketBuffer),
+                         &bufs[i]);
+        assert(bufs[i] != NULL);
+    }
+
+    n = rpc2_RecvPackets(fd, bufs, batch, results);
+    rpc2_RecvBatched.Calls++;
+
+    /* buffers that were not filled go back to the free list */
+    for (i = (n > 0) ? n : 0; i < batch; i++)
+        RPC2_FreeBuffer(&bufs[i]);
+    if (n <= 0)
+        return 0;
+
+    rpc2_RecvBatched.Packets += n;
+    if (n == batch)
+        rpc2_RecvBatched.Full++;
+    if ((unsigned long)n > rpc2_RecvBatched.Largest)
+        rpc2_RecvBatched.Largest = n;
+
+    for (i = 0; i < n; i++) {
+        pb = bufs[i];
+        assert(pb->Prefix.LE.Queue == &rpc2_PBList);
+
+        if (results[i] < 0) {
+            say(9, RPC2_DebugLevel, "Recv error, ignoring.\n");
+            RPC2_FreeBuffer(&pb);
+            continue;
+        }
+        rpc2_DeliverPacket(pb);
+    }
+    return (n == batch);
+}
+
+/* Process all packets that have been queued on fd */
+static void rpc2_DrainSocket(int fd)
+{
+    if (RPC2_RecvBatch <= 1) {
+        rpc2_ProcessPacket(fd);
+        return;
+    }
+
+    /* a partially filled batch means that the socket queue is empty */
+    while (rpc2_ProcessPackets(fd))
+        ;
+}
+
 void rpc2_SocketListener(void *dummy)
 {
     int fd;
@@ -275,12 +419,16 @@ void rpc2_SocketListener(void *dummy)
             rpc2_ExpireEvents();
             continue;
         }
+        rpc2_RecvBatched.Wakeups++;
+
         /* we received a packet, process any packets that have been queued
-         * in the socket buffers */
+         * in the socket buffers, replies and acks are sent in batches */
+        rpc2_XmitCork();
         do {
-            rpc2_ProcessPacket(fd);
-            fd = rpc2_MorePackets();
+            rpc2_DrainSocket(fd);
+            fd = PacketsPending();
         } while (fd != -1);
+        rpc2_XmitUncork();
     }
 }
 
@@ -289,8 +437,10 @@ void RPC2_DispatchProcess()
     struct timeval tv;
     int fd;
 
-    while ((fd = rpc2_MorePackets()) != -1)
-        rpc2_ProcessPacket(fd);
+    rpc2_XmitCork();
+    while ((fd = PacketsPending()) != -1)
+        rpc2_DrainSocket(fd);
+    rpc2_XmitUncork();
 
     /* keep current time from being too inaccurate */
     (void)FT_GetTimeOfDay(&tv, (struct timezone *)0);
@@ -598,13 +748,22 @@ static void DecodePacket(RPC2_PacketBuffer *pb, struct CEntry *ce)
     }
 }
 
+/* Packets are received into RPC2_MAXPACKETSIZE buffers and are copied into
+ * a right-sized buffer before they are queued so that held requests and
+ * replies do not pin large buffers. As long as there are enough idle large
+ * buffers to refill the receive batch, the copy is skipped and the packet
+ * is passed on in the buffer it was received in. */
 static RPC2_PacketBuffer *ShrinkPacket(RPC2_PacketBuffer *pb)
 {
     RPC2_PacketBuffer *pb2 = NULL;
     size_t len = pb->Prefix.LengthOfPacket - sizeof(struct RPC2_PacketHeader);
 
-    if (pb->Prefix.LengthOfPacket > MEDIUMPACKET)
+    if (pb->Prefix.LengthOfPacket > MEDIUMPACKET ||
+        pb->Prefix.BufferSize != LARGEPACKET ||
+        rpc2_PBLargeFreeCount > RPC2_RecvBatch) {
+        rpc2_PBStats.InPlace++;
         return pb;
+    }
 
     RPC2_AllocBuffer(len, &pb2);
     if (!pb2)
@@ -617,6 +776,7 @@ static RPC2_PacketBuffer *ShrinkPacket(RPC2_PacketBuffer *pb)
     pb2->Prefix.LengthOfPacket = pb->Prefix.LengthOfPacket;
     memcpy(&pb2->Header, &pb->Header, pb->Prefix.LengthOfPacket);
     RPC2_FreeBuffer(&pb);
+    rpc2_PBStats.Copied++;
     return (pb2);
 }
 
@@ -153,38 +153,17 @@ static ssize_t packet_decryption(struct security_association *sa, uint8_t *out,
     return len;
 }
 
-ssize_t secure_recvfrom(int s, void *buf, size_t len, int flags,
-                        struct sockaddr *peer, socklen_t *peerlen,
-                        struct security_association **ret_sa,
-                        struct security_association *(*GETSA)(uint32_t spi))
+/* Validate and decrypt a packet that was received from the network */
+static ssize_t secure_decode(uint8_t *packet, ssize_t n, void *buf, size_t len,
+                             const struct sockaddr *peer, socklen_t peerlen,
+                             struct security_association **ret_sa,
+                             struct security_association *(*GETSA)(uint32_t))
 {
-    uint8_t packet[MAXPACKETSIZE];
-    struct sockaddr_storage from;
-    socklen_t fromlen               = sizeof(from);
     struct security_association *sa = NULL;
     uint32_t spi                    = 0, seq;
-    ssize_t n, estimated_payload;
+    ssize_t estimated_payload;
     int err;
 
-    if (ret_sa)
-        *ret_sa = NULL;
-
-    /* validate arguments */
-    if (peer && !peerlen) {
-        errno = EINVAL;
-        return -1;
-    }
-
-    if (!peer) {
-        peer    = (struct sockaddr *)&from;
-        peerlen = &fromlen;
-    }
-
-    n = codatunnel_recvfrom(s, packet, MAXPACKETSIZE, flags | MSG_TRUNC, peer,
-                            peerlen);
-    if (n < 0)
-        return n;
-
     /* If we truncated packets because the packet buffer is too small */
     err = ENOMEM;
 
@@ -276,7 +255,7 @@ ssize_t secure_recvfrom(int s, void *buf, size_t len, int flags,
             goto drop;
         }
 
-        if (integrity_check_passed(sa, seq, peer, *peerlen) == -1)
+        if (integrity_check_passed(sa, seq, peer, peerlen) == -1)
             goto drop; /* drop duplicate packets */
     }
 
@@ -289,7 +268,7 @@ ssize_t secure_recvfrom(int s, void *buf, size_t len, int flags,
     /* we passed integrity check for combined mode decryption/validation
      * algorithms such as AES-CCM */
     if (!sa->validate->icv_len && sa->decrypt && sa->decrypt->icv_len)
-        if (integrity_check_passed(sa, seq, peer, *peerlen) == -1)
+        if (integrity_check_passed(sa, seq, peer, peerlen) == -1)
             goto drop; /* drop duplicate packets */
 
     goto done;
@@ -309,3 +288,68 @@ drop:
     errno = err;
     return -1;
 }
+
+ssize_t secure_recvfrom(int s, void *buf, size_t len, int flags,
+                        struct sockaddr *peer, socklen_t *peerlen,
+                        struct security_association **ret_sa,
+                        struct security_association *(*GETSA)(uint32_t spi))
+{
+    uint8_t packet[MAXPACKETSIZE];
+    struct sockaddr_storage from;
+    socklen_t fromlen = sizeof(from);
+    ssize_t n;
+
+    if (ret_sa)
+        *ret_sa = NULL;
+
+    /* validate arguments */
+    if (peer && !peerlen) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (!peer) {
+        peer    = (struct sockaddr *)&from;
+        peerlen = &fromlen;
+    }
+
+    n = codatunnel_recvfrom(s, packet, MAXPACKETSIZE, flags | MSG_TRUNC, peer,
+                            peerlen);
+    if (n < 0)
+        return n;
+
+    return secure_decode(packet, n, buf, len, peer, *peerlen, ret_sa, GETSA);
+}
+
+int secure_recvmmsg(int s, struct secure_mmsg *msgs, unsigned int vlen,
+                    int flags,
+                    struct security_association *(*GETSA)(uint32_t spi))
+{
+    /* not reentrant, but the caller is the (single) socket listener */
+    static uint8_t packets[SECURE_MAXBATCH][MAXPACKETSIZE];
+    struct codatunnel_mmsg raw[SECURE_MAXBATCH];
+    unsigned int i;
+    int n;
+
+    if (vlen > SECURE_MAXBATCH)
+        vlen = SECURE_MAXBATCH;
+
+    for (i = 0; i < vlen; i++) {
+        raw[i].buf     = packets[i];
+        raw[i].len     = MAXPACKETSIZE;
+        raw[i].addr    = (struct sockaddr *)&msgs[i].peer;
+        raw[i].addrlen = sizeof(msgs[i].peer);
+    }
+
+    n = codatunnel_recvmmsg(s, raw, vlen, flags | MSG_TRUNC);
+
+    for (i = 0; n > 0 && i < (unsigned int)n; i++) {
+        msgs[i].peerlen = raw[i].addrlen;
+        msgs[i].sa      = NULL;
+        msgs[i].n = secure_decode(packets[i], raw[i].n, msgs[i].buf,
+                                  msgs[i].len, raw[i].addr, raw[i].addrlen,
+                                  &msgs[i].sa, GETSA);
+        msgs[i].err = (msgs[i].n < 0) ? errno : 0;
+    }
+    return n;
+}
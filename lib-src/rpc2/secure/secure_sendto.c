@@ -27,11 +27,15 @@ Coda are listed in the file CREDITS.
 #include "codatunnel/wrapper.h"
 #include "grunt.h"
 
-ssize_t secure_sendto(int s, const void *buf, size_t len, int flags,
-                      const struct sockaddr *to, socklen_t tolen,
-                      struct security_association *sa)
+/* Builds the datagram for buf. Protected packets are encrypted into out, in
+ * which case buf, to and tolen are updated to refer to the encrypted packet
+ * and the peer address of the security association. Returns the length of
+ * the datagram or -1 on error. */
+static ssize_t secure_encode(const void **bufp, size_t len, uint8_t *out,
+                             const struct sockaddr **to, socklen_t *tolen,
+                             struct security_association *sa)
 {
-    uint8_t out[MAXPACKETSIZE];
+    const void *buf = *bufp;
     size_t padded_size;
     ssize_t n;
     int i, pad_align, padding;
@@ -43,8 +47,7 @@ ssize_t secure_sendto(int s, const void *buf, size_t len, int flags,
             errno = EINVAL;
             return -1;
         }
-        n = len;
-        goto send_packet;
+        return len;
     }
 
     /* check for sequence number overflow */
@@ -67,7 +70,7 @@ ssize_t secure_sendto(int s, const void *buf, size_t len, int flags,
 
     /* check if there is enough room */
     if ((2 * sizeof(uint32_t) + sa->encrypt->iv_len + padded_size +
-         sa->authenticate->icv_len) > sizeof(out)) {
+         sa->authenticate->icv_len) > MAXPACKETSIZE) {
         errno = EMSGSIZE;
         return -1;
     }
@@ -116,13 +119,24 @@ ssize_t secure_sendto(int s, const void *buf, size_t len, int flags,
         n += sa->authenticate->icv_len;
     }
 
-    buf   = out;
-    to    = (struct sockaddr *)&sa->peer;
-    tolen = sa->peerlen;
+    *bufp  = out;
+    *to    = (struct sockaddr *)&sa->peer;
+    *tolen = sa->peerlen;
+    return n;
+}
 
-send_packet:
-    padding = n - len;
-    n       = codatunnel_sendto(s, buf, n, flags, to, tolen);
+ssize_t secure_sendto(int s, const void *buf, size_t len, int flags,
+                      const struct sockaddr *to, socklen_t tolen,
+                      struct security_association *sa)
+{
+    uint8_t out[MAXPACKETSIZE];
+    ssize_t n, size;
+
+    size = secure_encode(&buf, len, out, &to, &tolen, sa);
+    if (size < 0)
+        return -1;
+
+    n = codatunnel_sendto(s, buf, size, flags, to, tolen);
 #ifdef __linux__
     if (n == -1 && errno == ECONNREFUSED) {
         /* On linux ECONNREFUSED is a result of a previous sendto
@@ -132,11 +146,66 @@ send_packet:
          * We retry the send, because the failing host was possibly
          * not the one we tried to send to this time. --JH
          */
-        n = codatunnel_sendto(s, buf, n, 0, to, tolen);
+        n = codatunnel_sendto(s, buf, size, 0, to, tolen);
     }
 #endif
-    n -= padding;
+    n -= size - len;
     if (n < -1)
         n = -1;
     return n;
 }
+
+int secure_sendmmsg(int s, struct secure_mmsg *msgs, unsigned int vlen,
+                    int flags)
+{
+    /* not reentrant, but the caller is the (single) transmit queue */
+    static uint8_t packets[SECURE_MAXBATCH][MAXPACKETSIZE];
+    struct codatunnel_mmsg raw[SECURE_MAXBATCH];
+    unsigned int idx[SECURE_MAXBATCH];
+    const struct sockaddr *to;
+    const void *buf;
+    socklen_t tolen;
+    unsigned int i, j, nraw = 0;
+    ssize_t size;
+    int n;
+
+    if (vlen > SECURE_MAXBATCH)
+        vlen = SECURE_MAXBATCH;
+
+    for (i = 0; i < vlen; i++) {
+        buf   = msgs[i].buf;
+        to    = (struct sockaddr *)&msgs[i].peer;
+        tolen = msgs[i].peerlen;
+
+        size = secure_encode(&buf, msgs[i].len, packets[nraw], &to, &tolen,
+                             msgs[i].sa);
+        msgs[i].n = -1;
+        if (size < 0) {
+            msgs[i].err = errno;
+            continue;
+        }
+
+        raw[nraw].buf     = (void *)buf;
+        raw[nraw].len     = size;
+        raw[nraw].addr    = (struct sockaddr *)to;
+        raw[nraw].addrlen = tolen;
+        idx[nraw++]       = i;
+    }
+
+    n = codatunnel_sendmmsg(s, raw, nraw, flags);
+#ifdef __linux__
+    /* see the comment about ECONNREFUSED in secure_sendto */
+    if (n == -1 && errno == ECONNREFUSED)
+        n = codatunnel_sendmmsg(s, raw, nraw, 0);
+#endif
+
+    for (j = 0; j < nraw; j++) {
+        i = idx[j];
+        if (n > 0 && j < (unsigned int)n) {
+            msgs[i].n   = msgs[i].len;
+            msgs[i].err = 0;
+        } else
+            msgs[i].err = (n == -1) ? errno : EAGAIN;
+    }
+    return (n == -1 && nraw) ? -1 : n;
+}
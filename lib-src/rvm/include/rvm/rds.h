@@ -66,6 +66,8 @@ int rds_free(char *addr, rvm_tid_t *tid, int *err);
 
 int rds_maxblock(unsigned long size);
 
+int rds_coalesce_step(unsigned long nblocks, int *err);
+
 /*
  * Because a transaction may abort we don't actually want to free
  * objects until the end of the transaction. So fake_free records our intention
@@ -105,6 +107,7 @@ typedef struct {
 int rds_print_stats(void);
 int rds_clear_stats(int *err);
 int rds_get_stats(rds_stats_t *stats);
+int rds_fragmentation(unsigned long *nfree, unsigned long *largest);
 
 extern int rds_tracing;
 extern FILE *rds_tracing_file;
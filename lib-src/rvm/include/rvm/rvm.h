@@ -309,6 +309,9 @@ typedef struct {
 /* Other flags */
 
 #define RVM_MAP_PRIVATE 8 /* Use private mapping, if available */
+#define RVM_GROUP_COMMIT 16 /* share log syncs between concurrent commits */
+#define RVM_ASYNC_IO 32 /* file i/o does not block other threads (LWP only) */
+#define RVM_COMPRESS_LOG 64 /* compress new values, log must be created with it */
 
 /* rvm_options_t initializer, copier & finalizer */
 
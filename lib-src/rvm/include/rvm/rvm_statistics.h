@@ -26,7 +26,7 @@ Coda are listed in the file CREDITS.
 /* permit multiple includes */
 #ifndef RVM_STATISTICS_VERSION
 
-#define RVM_STATISTICS_VERSION "RVM Statistics Version 1.1 8 Dec 1992"
+#define RVM_STATISTICS_VERSION "RVM Statistics Version 1.2 18 Oct 2026"
 
 #include <stdio.h>
 
@@ -171,6 +171,16 @@ typedef struct {
     rvm_length_t tot_trans_overlaps[range_overlaps_len];
     /* transactions coalesced per flush  */
     rvm_length_t tot_trans_coalesces[trans_coalesces_len];
+
+    /* group commit stats -- since rvm_initialize */
+    /* flushes that made more than one flush commit durable */
+    rvm_length_t n_group_flush;
+    /* flush commits made durable by a flush of another thread */
+    rvm_length_t n_group_commit;
+    /* largest number of flush commits made durable by one flush */
+    rvm_length_t group_commit_max;
+    /* time flush commits waited for their log records to be synced */
+    struct timeval group_commit_wait;
 } rvm_statistics_t;
 
 /* get RVM statistics */
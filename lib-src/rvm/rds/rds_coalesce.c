@@ -82,6 +82,9 @@ int merge_with_next_free(free_block_t *fbp, rvm_tid_t *tid, int *err)
     return merged;
 }
 
+/* Position of the incremental coalescer, see rds_coalesce_step() below */
+static free_block_t *coalesce_cursor = NULL;
+
 void coalesce(rvm_tid_t *tid, int *err)
 {
     free_block_t *fbp, *save;
@@ -97,6 +100,9 @@ void coalesce(rvm_tid_t *tid, int *err)
     /* Update stats - don't need setrange, assume caller already has done that. */
     RDS_STATS.coalesce++;
 
+    /* Merging may swallow the block the incremental coalescer stopped at */
+    coalesce_cursor = NULL;
+
     *err = SUCCESS; /* Initialize the error value */
 
     /* Go through the lists, examing objects. For each free object, merge it
@@ -201,3 +207,130 @@ void coalesce(rvm_tid_t *tid, int *err)
 
     *err = SUCCESS;
 }
+
+/*
+ * Incremental coalescing. Coalesce() above merges the whole heap in a single
+ * transaction, which stalls everything else for a long time on a large and
+ * fragmented heap. rds_coalesce_step instead walks the heap in address order,
+ * looks at no more than nblocks blocks and commits what it merged in its own
+ * transaction. The next call continues where this one stopped, so when called
+ * regularly from a background thread the free space is merged long before a
+ * large allocation needs it.
+ *
+ * The cursor is volatile. Block boundaries only disappear when blocks are
+ * merged, which happens here, in coalesce() and when rds_free or
+ * rds_do_free merge a freed block with the free blocks that follow it.
+ * coalesce() resets the cursor, the frees do not. They can swallow the block
+ * the cursor points at, so the valid_block check is required: it fails on
+ * a swallowed block because merge_with_next_free zeroes its header, and we
+ * start over from the first block.
+ */
+
+/* The first block in the heap follows the free list headers, see
+ * rds_init_heap */
+static free_block_t *first_block(void)
+{
+    unsigned long addr = (unsigned long)&RDS_FREE_LIST[RDS_NLISTS + 1];
+
+    return (free_block_t *)(((addr + RDS_CHUNK_SIZE - 1) / RDS_CHUNK_SIZE) *
+                            RDS_CHUNK_SIZE);
+}
+
+static int valid_block(free_block_t *bp)
+{
+    if (bp == NULL || bp >= RDS_HIGH_ADDR)
+        return 0;
+    if (bp->type != FREE_GUARD && bp->type != ALLOC_GUARD)
+        return 0;
+    if (bp->size == 0 || NEXT_CONSECUTIVE_BLOCK(bp) > RDS_HIGH_ADDR)
+        return 0;
+    return (*BLOCK_END(bp) == END_GUARD);
+}
+
+/* Returns 1 when a pass over the whole heap was completed, 0 when there is
+ * more work left and -1 on error. */
+int rds_coalesce_step(unsigned long nblocks, int *err)
+{
+    free_block_t *bp;
+    rvm_tid_t *atid;
+    rvm_return_t rvmret;
+    unsigned long i, oldlist, newlist;
+    int wrapped = 0;
+
+    /* Make sure the heap has been initialized */
+    if (!HEAP_INIT) {
+        (*err) = EHEAP_INIT;
+        return -1;
+    }
+
+    atid   = rvm_malloc_tid();
+    rvmret = rvm_begin_transaction(atid, restore);
+    if (rvmret != RVM_SUCCESS) {
+        (*err) = (int)rvmret;
+        rvm_free_tid(atid);
+        return -1;
+    }
+
+    *err = SUCCESS; /* Initialize the error value */
+    START_CRITICAL;
+    {
+        rvmret = rds_update_stats(atid, rvm_false);
+        if (rvmret != RVM_SUCCESS) {
+            (*err) = (int)rvmret;
+            LEAVE_CRITICAL_SECTION;
+        }
+
+        bp = coalesce_cursor;
+        if (!valid_block(bp))
+            bp = first_block();
+
+        for (i = 0; i < nblocks; i++) {
+            /* Past the last block, the next call starts a new pass */
+            if (!valid_block(bp)) {
+                RDS_STATS.coalesce++;
+                bp      = NULL;
+                wrapped = 1;
+                break;
+            }
+
+            if (bp->type == FREE_GUARD) {
+                oldlist = (bp->size >= RDS_MAXLIST) ? RDS_MAXLIST : bp->size;
+
+                if (!merge_with_next_free(bp, atid, err)) {
+                    if (*err != SUCCESS)
+                        break;
+                    RDS_STATS.unmerged++;
+                }
+
+                /* Move the merged block to the list for its new size */
+                newlist = (bp->size >= RDS_MAXLIST) ? RDS_MAXLIST : bp->size;
+                if (newlist != oldlist) {
+                    rm_from_list(&RDS_FREE_LIST[oldlist], bp, atid, err);
+                    if (*err != SUCCESS)
+                        break;
+
+                    put_block(bp, atid, err);
+                    if (*err != SUCCESS)
+                        break;
+                }
+            }
+            bp = NEXT_CONSECUTIVE_BLOCK(bp);
+        }
+        coalesce_cursor = bp;
+    }
+    END_CRITICAL;
+
+    if (*err != SUCCESS) {
+        rvm_abort_transaction(atid);
+        rvm_free_tid(atid);
+        return -1;
+    }
+
+    rvmret = rvm_end_transaction(atid, no_flush);
+    rvm_free_tid(atid);
+    if (rvmret != RVM_SUCCESS) {
+        (*err) = (int)rvmret;
+        return -1;
+    }
+    return wrapped;
+}
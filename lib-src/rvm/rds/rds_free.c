@@ -95,7 +95,7 @@ int rds_free(char *addr, rvm_tid_t *tid, int *err)
     START_CRITICAL;
     {
         /* Update statistics */
-        rvmret = rvm_set_range(atid, &RDS_STATS, sizeof(rds_stats_t));
+        rvmret = rds_update_stats(atid, rvm_false);
         if (rvmret != RVM_SUCCESS) {
             (*err) = (int)rvmret;
         } else {
@@ -202,8 +202,8 @@ int rds_do_free(intentionList_t *list, rvm_mode_t mode)
     err = SUCCESS; /* Initialize the error value */
     START_CRITICAL;
     {
-        /* Only need to set the range once. To be safe, doing in critical...*/
-        rvmret = rvm_set_range(tid, &RDS_STATS, sizeof(rds_stats_t));
+        /* Update statistics */
+        rvmret = rds_update_stats(tid, rvm_false);
         if (rvmret != RVM_SUCCESS) {
             err = (int)rvmret;
         } else
@@ -70,7 +70,7 @@ char *rds_malloc(unsigned long size, rvm_tid_t *tid, int *err)
     START_CRITICAL;
     {
         /* Update stats */
-        rvmret = rvm_set_range(atid, &RDS_STATS, sizeof(rds_stats_t));
+        rvmret = rds_update_stats(atid, rvm_false);
         if (rvmret != RVM_SUCCESS) {
             (*err) = (int)rvmret;
             if (tid == NULL) {
@@ -74,15 +74,19 @@ int rds_prealloc(unsigned long size, unsigned long nblocks, rvm_tid_t *tid,
     } else
         atid = tid;
 
-    /* Update statistics */
-    rvmerr = rvm_set_range(atid, &RDS_STATS, sizeof(rds_stats_t));
+    /* Update statistics, END_CRITICAL can only be used once per function. */
+    mutex_lock(&heap_lock);
+    rvmerr = rds_update_stats(atid, rvm_false);
+    if (rvmerr == RVM_SUCCESS)
+        RDS_STATS.prealloc++;
+    mutex_unlock(&heap_lock);
+
     if ((rvmerr != RVM_SUCCESS) && (tid == NULL)) {
         rvm_abort_transaction(atid);
         (*err) = (int)rvmerr;
         rvm_free_tid(atid);
         return -1;
     }
-    RDS_STATS.prealloc++; /* Update statistics. */
 
     *err = SUCCESS; /* Initialize the error value */
 
@@ -140,6 +140,7 @@ typedef struct {
 extern heap_header_t *RecoverableHeapStartAddress;
 extern free_block_t *RecoverableHeapHighAddress;
 extern RVM_MUTEX heap_lock;
+extern rds_stats_t rds_stats;
 
 extern int rds_tracing;
 extern FILE *rds_tracing_file;
@@ -151,9 +152,16 @@ extern FILE *rds_tracing_file;
 #define RDS_FREE_LIST (RecoverableHeapStartAddress->lists)
 #define RDS_NLISTS (RecoverableHeapStartAddress->nlists)
 #define RDS_MAXLIST (RecoverableHeapStartAddress->maxlist)
-#define RDS_STATS (RecoverableHeapStartAddress->stats)
+#define RDS_HEAP_STATS (RecoverableHeapStartAddress->stats)
 #define RDS_HIGH_ADDR (RecoverableHeapHighAddress)
 
+/* The statistics are updated in a volatile copy that is only written back to
+ * the heap header every RDS_STATS_INTERVAL allocator calls, instead of adding
+ * the header to every transaction. After a crash the counters may lag behind
+ * by at most that many calls. */
+#define RDS_STATS (rds_stats)
+#define RDS_STATS_INTERVAL 256
+
 /*******************
  * byte <-> string
  */
@@ -184,4 +192,9 @@ int rm_from_list();
 int merge_with_next_free(free_block_t *fbp, rvm_tid_t *tid, int *err);
 void coalesce(rvm_tid_t *tid, int *err);
 
+/***********************
+ * Statistics
+ */
+rvm_return_t rds_update_stats(rvm_tid_t *tid, rvm_bool_t force);
+
 #endif /* _RDS_PRIVATE_H_ */
@@ -47,6 +47,10 @@ free_block_t *RecoverableHeapHighAddress;
 rvm_region_def_t *RegionDefs = NULL;
 unsigned long NRegionDefs;
 rvm_bool_t rds_testsw = rvm_false; /* switch to allow special test modes */
+
+/* Volatile copy of the heap statistics, see RDS_STATS in rds_private.h. */
+rds_stats_t rds_stats;
+
 /*
  * Global lock for the heap. See comment in rds_private.h.
  */
@@ -137,6 +141,8 @@ int rds_start_heap(char *startAddr, int *err)
                              RDS_CHUNK_SIZE +
                          heap_hdr_len);
 
+    BCOPY(&RDS_HEAP_STATS, &RDS_STATS, sizeof(rds_stats_t));
+
     *err = SUCCESS;
     return -1;
 }
@@ -49,6 +49,7 @@ int rds_print_stats()
     printf(" Not Merged: \t %d\n", RDS_STATS.unmerged);
     printf(" Times the Large List pointer has changed: %d\n",
            RDS_STATS.large_list);
+    printf(" Fragmentation:\t %d%%\n", rds_fragmentation(NULL, NULL));
 
     return 0;
 }
@@ -68,9 +69,8 @@ int rds_clear_stats(int *err)
 
     START_CRITICAL;
     {
-        rvmret = rvm_set_range(atid, &RDS_STATS, sizeof(rds_stats_t));
-        if (rvmret == RVM_SUCCESS)
-            BZERO(&RDS_STATS, sizeof(rds_stats_t));
+        BZERO(&RDS_STATS, sizeof(rds_stats_t));
+        rvmret = rds_update_stats(atid, rvm_true);
     }
     END_CRITICAL;
 
@@ -94,7 +94,30 @@ int rds_clear_stats(int *err)
 }
 
 /*
- * Return a structure initialized from the statistics in the heap header.
+ * Write the volatile statistics back to the heap header as part of tid, but
+ * only once every RDS_STATS_INTERVAL calls unless force is set. Must be called
+ * with the heap lock held. If the transaction aborts the header simply keeps
+ * the older counters until the next write back.
+ */
+rvm_return_t rds_update_stats(rvm_tid_t *tid, rvm_bool_t force)
+{
+    static unsigned long updates = 0;
+    rvm_return_t rvmret;
+
+    if (!force && ++updates < RDS_STATS_INTERVAL)
+        return RVM_SUCCESS;
+
+    rvmret = rvm_set_range(tid, &RDS_HEAP_STATS, sizeof(rds_stats_t));
+    if (rvmret != RVM_SUCCESS)
+        return rvmret;
+
+    BCOPY(&RDS_STATS, &RDS_HEAP_STATS, sizeof(rds_stats_t));
+    updates = 0;
+    return RVM_SUCCESS;
+}
+
+/*
+ * Return a structure initialized from the current heap statistics.
  * Like print_stats, this really doesn't need to be critical -- dcs 1/29
  */
 
@@ -107,6 +130,41 @@ int rds_get_stats(rds_stats_t *stats)
     return 0;
 }
 
+/*
+ * Return how fragmented the free space is, as the percentage of free bytes
+ * that are not part of the largest free block. Optionally also returns the
+ * number of free blocks and the size of the largest one. This has to walk
+ * all free lists, so it is meant for occasional reporting.
+ */
+int rds_fragmentation(unsigned long *nfree, unsigned long *largest)
+{
+    free_block_t *fbp;
+    unsigned long i, blocks = 0, chunks = 0, maxchunks = 0;
+
+    if (!HEAP_INIT)
+        return -1;
+
+    START_CRITICAL;
+    {
+        for (i = 1; i <= RDS_NLISTS; i++) {
+            for (fbp = RDS_FREE_LIST[i].head; fbp != NULL; fbp = fbp->next) {
+                blocks++;
+                chunks += fbp->size;
+                if (fbp->size > maxchunks)
+                    maxchunks = fbp->size;
+            }
+        }
+    }
+    END_CRITICAL;
+
+    if (nfree)
+        *nfree = blocks;
+    if (largest)
+        *largest = maxchunks * RDS_CHUNK_SIZE;
+
+    return chunks ? (int)(100 - (maxchunks * 100) / chunks) : 0;
+}
+
 int rds_trace_on(FILE *file)
 {
     assert(HEAP_INIT);
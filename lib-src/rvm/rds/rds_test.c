@@ -376,7 +376,7 @@ int main(int argc, char *argv[])
             if (ret != RVM_SUCCESS)
                 printf("begin_trans code %s\n", rvm_return(ret));
 
-            ret = rvm_set_range(tid, &RDS_STATS, sizeof(rds_stats_t));
+            ret = rvm_set_range(tid, &RDS_HEAP_STATS, sizeof(rds_stats_t));
             if (ret != RVM_SUCCESS) {
                 printf("Couldn't setrange for stats %s.", rvm_return(ret));
                 break;
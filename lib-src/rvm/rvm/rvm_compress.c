@@ -0,0 +1,339 @@
+/* BLURB lgpl
+
+                           Coda File System
+                              Release 8
+
+          Copyright (c) 2026 Carnegie Mellon University
+                  Additional copyrights listed below
+
+This  code  is  distributed "AS IS" without warranty of any kind under
+the  terms of the  GNU  Library General Public Licence  Version 2,  as
+shown in the file LICENSE. The technical and financial contributors to
+Coda are listed in the file CREDITS.
+
+                        Additional copyrights
+                           none currently
+
+#*/
+
+/*
+*
+*                RVM log record compression and checksums
+*
+*/
+
+/*
+ * New values are compressed with a small LZ77 coder in the style of the LZ4
+ * block format. It is fast enough to run while committing and does well on
+ * the zero filled and repetitive structures that dominate RVM updates.
+ *
+ * A compressed block is a series of sequences, each one consisting of
+ *
+ *   token         high nibble: literal count, low nibble: match length - 4
+ *   [count]       255 valued bytes and a final byte < 255 extend a nibble
+ *                 of 15, for the literal count and the match length
+ *   literals      copied as is
+ *   offset        2 bytes little endian, distance back to the match
+ *   [length]      extension of the match length
+ *
+ * The last sequence ends after its literals when the input is exhausted.
+ *
+ * Log records are protected with CRC32C, which is computed with the SSE4.2
+ * or ARMv8 crc32c instructions when the processor has them.
+ */
+
+#include <sys/types.h>
+#include <stdint.h>
+#include "rvm_private.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define CRC32C_X86 1
+#elif defined(__GNUC__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define CRC32C_ARM 1
+#endif
+
+/* compressor parameters */
+#define LZ_MIN_MATCH 4 /* shortest match encoded */
+#define LZ_MAX_INPUT 0xffff /* positions are kept in 16 bits */
+#define LZ_HASH_BITS 12
+#define LZ_HASH_SIZE (1 << LZ_HASH_BITS)
+#define LZ_RUN_MASK 15 /* nibble value that is extended */
+
+/* Match candidates, indexed by a hash of the next 4 input bytes. An entry
+   holds the generation of the compression call in the upper 16 bits and
+   the input position in the lower 16 bits, so stale entries never need to
+   be cleared. Callers serialize through the log's dev_lock. */
+static uint32_t lz_hash[LZ_HASH_SIZE];
+static uint32_t lz_gen;
+
+static inline uint32_t lz_read32(const unsigned char *p)
+{
+    uint32_t v;
+
+    BCOPY(p, &v, sizeof(v));
+    return v;
+}
+
+static inline uint32_t lz_hash4(uint32_t v)
+{
+    return (v * 2654435761U) >> (32 - LZ_HASH_BITS);
+}
+
+/* append an extended length, returns NULL if the output is full */
+static unsigned char *lz_put_len(unsigned char *op, unsigned char *oend,
+                                 rvm_length_t len)
+{
+    for (; len >= 255; len -= 255) {
+        if (op >= oend)
+            return NULL;
+        *op++ = 255;
+    }
+    if (op >= oend)
+        return NULL;
+    *op++ = (unsigned char)len;
+    return op;
+}
+
+/* append a sequence of literals and an optional match */
+static unsigned char *lz_put_seq(unsigned char *op, unsigned char *oend,
+                                 const unsigned char *lit, rvm_length_t lit_len,
+                                 rvm_length_t offset, rvm_length_t match_len)
+{
+    rvm_length_t mlen = match_len ? match_len - LZ_MIN_MATCH : 0;
+    unsigned char *token;
+
+    if (op >= oend)
+        return NULL;
+    token  = op++;
+    *token = (lit_len < LZ_RUN_MASK ? lit_len : LZ_RUN_MASK) << 4;
+    if (lit_len >= LZ_RUN_MASK &&
+        (op = lz_put_len(op, oend, lit_len - LZ_RUN_MASK)) == NULL)
+        return NULL;
+
+    if ((rvm_length_t)(oend - op) < lit_len)
+        return NULL;
+    BCOPY(lit, op, lit_len);
+    op += lit_len;
+
+    if (match_len == 0)
+        return op;
+
+    *token |= (mlen < LZ_RUN_MASK ? mlen : LZ_RUN_MASK);
+    if (oend - op < 2)
+        return NULL;
+    *op++ = offset & 0xff;
+    *op++ = offset >> 8;
+    if (mlen >= LZ_RUN_MASK)
+        op = lz_put_len(op, oend, mlen - LZ_RUN_MASK);
+    return op;
+}
+
+/* compress len bytes at src into dest; returns the compressed length, or 0
+   if the result does not fit in dest_len bytes */
+rvm_length_t nv_compress(char *src, rvm_length_t len, char *dest,
+                         rvm_length_t dest_len)
+{
+    const unsigned char *base   = (const unsigned char *)src;
+    const unsigned char *ip     = base;
+    const unsigned char *anchor = base;
+    const unsigned char *iend   = base + len;
+    const unsigned char *ref;
+    unsigned char *op   = (unsigned char *)dest;
+    unsigned char *oend = op + dest_len;
+    rvm_length_t match_len;
+    uint32_t h, cand, gen;
+
+    if (len > LZ_MAX_INPUT || len < LZ_MIN_MATCH)
+        return 0;
+
+    /* start a new generation of hash entries */
+    gen = ++lz_gen & 0xffff;
+    if (gen == 0) {
+        BZERO(lz_hash, sizeof(lz_hash));
+        gen = ++lz_gen & 0xffff;
+    }
+    gen <<= 16;
+
+    while (ip + LZ_MIN_MATCH <= iend) {
+        h          = lz_hash4(lz_read32(ip));
+        cand       = lz_hash[h];
+        lz_hash[h] = gen | (uint32_t)(ip - base);
+
+        ref = base + (cand & 0xffff);
+        if ((cand & 0xffff0000) != gen || lz_read32(ref) != lz_read32(ip)) {
+            ip++;
+            continue;
+        }
+
+        /* extend the match as far as possible */
+        match_len = LZ_MIN_MATCH;
+        while (ip + match_len < iend && ref[match_len] == ip[match_len])
+            match_len++;
+
+        op = lz_put_seq(op, oend, anchor, ip - anchor, ip - ref, match_len);
+        if (op == NULL)
+            return 0;
+        ip += match_len;
+        anchor = ip;
+    }
+
+    /* trailing literals */
+    if (anchor < iend) {
+        op = lz_put_seq(op, oend, anchor, iend - anchor, 0, 0);
+        if (op == NULL)
+            return 0;
+    }
+    return (rvm_length_t)(op - (unsigned char *)dest);
+}
+
+/* get an extended length, returns NULL if the input is exhausted */
+static const unsigned char *lz_get_len(const unsigned char *ip,
+                                       const unsigned char *iend,
+                                       rvm_length_t *len)
+{
+    unsigned char c;
+
+    do {
+        if (ip >= iend)
+            return NULL;
+        c = *ip++;
+        *len += c;
+    } while (c == 255);
+    return ip;
+}
+
+/* expand len bytes at src into dest; returns the expanded length, or -1 if
+   the input is damaged or does not fit in dest_len bytes */
+long nv_decompress(char *src, rvm_length_t len, char *dest,
+                   rvm_length_t dest_len)
+{
+    const unsigned char *ip   = (const unsigned char *)src;
+    const unsigned char *iend = ip + len;
+    unsigned char *op         = (unsigned char *)dest;
+    unsigned char *oend       = op + dest_len;
+    const unsigned char *ref;
+    rvm_length_t lit_len, match_len, offset;
+    unsigned char token;
+
+    while (ip < iend) {
+        token = *ip++;
+
+        lit_len = token >> 4;
+        if (lit_len == LZ_RUN_MASK &&
+            (ip = lz_get_len(ip, iend, &lit_len)) == NULL)
+            return -1;
+        if ((rvm_length_t)(iend - ip) < lit_len ||
+            (rvm_length_t)(oend - op) < lit_len)
+            return -1;
+        BCOPY(ip, op, lit_len);
+        ip += lit_len;
+        op += lit_len;
+
+        if (ip == iend)
+            break; /* last sequence */
+
+        if (iend - ip < 2)
+            return -1;
+        offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        match_len = token & LZ_RUN_MASK;
+        if (match_len == LZ_RUN_MASK &&
+            (ip = lz_get_len(ip, iend, &match_len)) == NULL)
+            return -1;
+        match_len += LZ_MIN_MATCH;
+
+        if (offset == 0 || offset > (rvm_length_t)(op - (unsigned char *)dest))
+            return -1;
+        if ((rvm_length_t)(oend - op) < match_len)
+            return -1;
+
+        /* matches may overlap their own output, copy bytewise */
+        for (ref = op - offset; match_len > 0; match_len--)
+            *op++ = *ref++;
+    }
+    return (long)(op - (unsigned char *)dest);
+}
+
+/* CRC32C (Castagnoli), reflected polynomial */
+#define CRC32C_POLY 0x82f63b78
+
+static uint32_t crc32c_table[256];
+static int crc32c_hw = -1; /* hardware support, -1 if not yet known */
+
+static uint32_t crc32c_sw(uint32_t crc, const unsigned char *p,
+                          rvm_length_t len)
+{
+    while (len--)
+        crc = crc32c_table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    return crc;
+}
+
+#ifdef CRC32C_X86
+__attribute__((target("sse4.2"))) static uint32_t
+crc32c_accel(uint32_t crc, const unsigned char *p, rvm_length_t len)
+{
+    uint64_t crc64 = crc, v;
+
+    for (; len >= sizeof(v); len -= sizeof(v), p += sizeof(v)) {
+        BCOPY(p, &v, sizeof(v));
+        crc64 = __builtin_ia32_crc32di(crc64, v);
+    }
+    crc = (uint32_t)crc64;
+    while (len--)
+        crc = __builtin_ia32_crc32qi(crc, *p++);
+    return crc;
+}
+#elif defined(CRC32C_ARM)
+static uint32_t crc32c_accel(uint32_t crc, const unsigned char *p,
+                             rvm_length_t len)
+{
+    uint64_t v;
+
+    for (; len >= sizeof(v); len -= sizeof(v), p += sizeof(v)) {
+        BCOPY(p, &v, sizeof(v));
+        crc = __crc32cd(crc, v);
+    }
+    while (len--)
+        crc = __crc32cb(crc, *p++);
+    return crc;
+}
+#endif
+
+static void crc32c_init(void)
+{
+    uint32_t crc;
+    int i, j;
+
+    for (i = 0; i < 256; i++) {
+        crc = i;
+        for (j = 0; j < 8; j++)
+            crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLY : 0);
+        crc32c_table[i] = crc;
+    }
+
+#if defined(CRC32C_X86)
+    __builtin_cpu_init();
+    crc32c_hw = __builtin_cpu_supports("sse4.2");
+#elif defined(CRC32C_ARM)
+    crc32c_hw = 1;
+#else
+    crc32c_hw = 0;
+#endif
+}
+
+/* checksum len bytes at buf; crc is 0 or the result of the checksum of
+   the preceding bytes */
+rvm_length_t crc32c(rvm_length_t crc, char *buf, rvm_length_t len)
+{
+    uint32_t c = ~(uint32_t)crc;
+
+    if (crc32c_hw < 0)
+        crc32c_init();
+
+#if defined(CRC32C_X86) || defined(CRC32C_ARM)
+    if (crc32c_hw)
+        return ~crc32c_accel(c, (const unsigned char *)buf, len);
+#endif
+    return ~crc32c_sw(c, (const unsigned char *)buf, len);
+}
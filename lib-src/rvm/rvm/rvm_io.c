@@ -56,6 +56,7 @@ extern rvm_bool_t rvm_no_update; /* no segment or log update if true */
 /* static prototypes */
 static rvm_bool_t in_wrt_buf(char *addr, rvm_length_t len);
 static long chk_seek(device_t *dev, rvm_offset_t *offset);
+static long fsync_dev(device_t *dev);
 
 #ifndef ZERO
 #define ZERO 0
@@ -114,6 +115,22 @@ static long chk_seek(device_t *dev, rvm_offset_t *offset)
     return retval;
 }
 
+/* sync file data, asynchronously if possible */
+static long fsync_dev(device_t *dev)
+{
+    long retval;
+
+    if (uring_dev(dev))
+        retval = uring_rw(dev, uring_sync, NULL, NULL, 0);
+    else
+        retval = FSYNC((int)dev->handle);
+    if (retval < 0) {
+        rvm_errdev  = dev;
+        rvm_ioerrno = errno;
+    }
+    return retval;
+}
+
 /* set device characteristics for device
    device descriptor mandatory, length optional */
 long set_dev_char(device_t *dev, rvm_offset_t *dev_length)
@@ -229,6 +246,7 @@ long read_dev(device_t *dev /* device descriptor */,
               rvm_length_t length /* length of transfer */)
 {
     rvm_offset_t last_position;
+    struct iovec iov;
     long nbytes;
     long read_len;
     long retval;
@@ -240,8 +258,23 @@ long read_dev(device_t *dev /* device descriptor */,
                (!LOCK_FREE(default_log->dev_lock)) :
                1);
 
-    /* seek if necessary */
+    /* asynchronous read, the file position is left alone */
     errno = 0;
+    if (offset != NULL && uring_dev(dev)) {
+        last_position = RVM_ADD_LENGTH_TO_OFFSET(*offset, length);
+        assert(RVM_OFFSET_EQL_ZERO(*offset) ?
+                   1 :
+                   RVM_OFFSET_LEQ(last_position, dev->num_bytes));
+        iov.iov_base = dest;
+        iov.iov_len  = length;
+        if ((retval = uring_rw(dev, uring_read, offset, &iov, 1)) < 0) {
+            rvm_errdev  = dev;
+            rvm_ioerrno = errno;
+        }
+        return retval;
+    }
+
+    /* seek if necessary */
     if ((retval = chk_seek(dev, offset)) < 0)
         return retval;
     last_position = RVM_ADD_LENGTH_TO_OFFSET(dev->last_position, length);
@@ -289,6 +322,7 @@ long write_dev(device_t *dev /* device descriptor */,
                rvm_bool_t sync /* fsync if true */)
 {
     rvm_offset_t last_position;
+    struct iovec iov;
     long retval;
     long wrt_len = length; /* for no_update mode */
 
@@ -299,8 +333,24 @@ long write_dev(device_t *dev /* device descriptor */,
                (!LOCK_FREE(default_log->dev_lock)) :
                1);
 
-    /* seek if necessary */
+    /* asynchronous write, the file position is left alone */
     errno = 0;
+    if (offset != NULL && !(rvm_utlsw && rvm_no_update) && uring_dev(dev)) {
+        last_position = RVM_ADD_LENGTH_TO_OFFSET(*offset, length);
+        assert(RVM_OFFSET_LEQ(last_position, dev->num_bytes));
+        iov.iov_base = src;
+        iov.iov_len  = length;
+        if ((wrt_len = uring_rw(dev, uring_write, offset, &iov, 1)) < 0) {
+            rvm_errdev  = dev;
+            rvm_ioerrno = errno;
+            return wrt_len;
+        }
+        if (sync == SYNCH && (retval = fsync_dev(dev)) < 0)
+            return retval;
+        return wrt_len;
+    }
+
+    /* seek if necessary */
     if ((retval = chk_seek(dev, offset)) < 0)
         return retval;
     last_position = RVM_ADD_LENGTH_TO_OFFSET(dev->last_position, length);
@@ -317,11 +367,8 @@ long write_dev(device_t *dev /* device descriptor */,
         /* fsync if doing file i/o */
         if (((!dev->raw_io && sync == SYNCH) ||
              (dev->raw_io && dev->type == S_IFBLK))) {
-            if ((retval = FSYNC((int)dev->handle)) < 0) {
-                rvm_errdev  = dev;
-                rvm_ioerrno = errno;
+            if ((retval = fsync_dev(dev)) < 0)
                 return retval;
-            }
         }
     }
 
@@ -340,11 +387,37 @@ gather_write_file(device_t *dev /* device descriptor */,
     long retval; /* kernel return value */
     long iov_index = 0; /* index of current iov entry */
     int count; /* iov count for Unix i/o */
+    rvm_offset_t position; /* asynchronous write position */
 
     assert(((dev == &default_log->dev) && (!rvm_utlsw)) ?
                (!LOCK_FREE(default_log->dev_lock)) :
                1);
 
+    /* asynchronous gather write, the file position is left alone */
+    if (!(rvm_utlsw && rvm_no_update) && uring_dev(dev)) {
+        while (dev->iov_cnt > 0) {
+            if (dev->iov_cnt > UIO_MAXIOV)
+                count = UIO_MAXIOV;
+            else
+                count = dev->iov_cnt;
+
+            position = RVM_ADD_LENGTH_TO_OFFSET(*offset, *wrt_len);
+            retval   = uring_rw(dev, uring_write, &position,
+                                &dev->iov[iov_index], count);
+            if (retval < 0) {
+                rvm_errdev  = dev;
+                rvm_ioerrno = errno;
+                return retval;
+            }
+
+            *wrt_len += (rvm_length_t)retval;
+            dev->iov_cnt -= count;
+            iov_index += count;
+        }
+        assert(*wrt_len == dev->io_length);
+        return 0;
+    }
+
     /* seek if necessary */
     if ((retval = chk_seek(dev, offset)) < 0)
         return retval;
@@ -516,14 +589,8 @@ long sync_dev(device_t *dev /* device descriptor */)
     errno = 0;
 
     /* use kernel call for file sync */
-    if (!dev->raw_io) {
-        retval = FSYNC((int)dev->handle);
-        if (retval < 0) {
-            rvm_errdev  = dev;
-            rvm_ioerrno = errno;
-        }
-        return retval;
-    }
+    if (!dev->raw_io)
+        return fsync_dev(dev);
 
     /* raw i/o flushes buffer */
     retval =
@@ -533,3 +600,19 @@ long sync_dev(device_t *dev /* device descriptor */)
 
     return retval;
 }
+
+/* sync segment device after a series of unsynchronized writes
+   -- partitions need no sync: block devices are synced by write_dev
+   and character devices are not buffered */
+long sync_seg_dev(device_t *dev /* device descriptor */)
+{
+    long retval = 0;
+
+    assert(dev->handle != 0);
+    errno = 0;
+
+    if (!dev->raw_io && !(rvm_utlsw && rvm_no_update))
+        retval = fsync_dev(dev);
+
+    return retval;
+}
@@ -32,6 +32,8 @@ extern log_t *default_log; /* default log descriptor ptr */
 extern char *rvm_errmsg; /* internal error message buffer */
 extern rvm_bool_t rvm_utlsw; /* running under rvmutl */
 extern rvm_length_t rvm_optimizations; /* optimization switches */
+extern rvm_bool_t rvm_group_commit; /* flush commits share log syncs */
+extern rvm_bool_t rvm_compress_log; /* compress new values in the log */
 
 rvm_length_t flush_times_vec[flush_times_len]         = { flush_times_dist };
 rvm_length_t range_lengths_vec[range_lengths_len]     = { range_lengths_dist };
@@ -94,6 +96,40 @@ static void make_pad_buf(device_t *dev, long length)
     }
 }
 
+/* allocate buffer for the compressed new values of a transaction */
+static void make_comp_buf(log_t *log, int_tid_t *tid)
+{
+    device_t *dev = &log->dev;
+    range_t *range; /* range ptr */
+    rvm_length_t length = 0;
+
+    /* only logs created for it can hold compressed new values */
+    dev->comp_ptr = NULL;
+    if (!rvm_compress_log || !log->comp_log)
+        return;
+
+    /* the compressed data of a range is never larger than its new values */
+    FOR_NODES_OF(tid->range_tree, range_t, range)
+    {
+        if (range->nv.length >= NV_COMPRESS_MIN &&
+            range->nv.length <= NV_LOCAL_MAX)
+            length += RANGE_LEN(range);
+    }
+    if (length == 0)
+        return;
+
+    /* see if must reallocate, if that fails just don't compress */
+    if (length > dev->comp_buf_len) {
+        if (dev->comp_buf != NULL)
+            free(dev->comp_buf);
+        dev->comp_buf_len = 0;
+        if ((dev->comp_buf = malloc(length)) == NULL)
+            return;
+        dev->comp_buf_len = length;
+    }
+    dev->comp_ptr = dev->comp_buf;
+}
+
 /* setup wrap marker i/o */
 static rvm_return_t write_log_wrap(log_t *log)
 {
@@ -199,10 +235,15 @@ build_rec_end(log_t *log /* log descriptor */,
 /* setup nv_range record */
 static void build_nv_range(log_t *log /* log descriptor */,
                            int_tid_t *tid /* transaction descriptor */,
-                           range_t *range /* range descriptor */)
+                           range_t *range /* range descriptor */,
+                           rvm_bool_t compress /* compression permitted */)
 {
     nv_range_t *nv_range; /* nv_range header */
     device_t *dev = &log->dev;
+    char *nv_data; /* first byte of new values */
+    char *data; /* new values as logged */
+    rvm_length_t data_len; /* length of logged new values */
+    rvm_length_t comp_len; /* length of compressed new values */
 
     /* setup header fields */
     nv_range = &range->nv;
@@ -211,8 +252,36 @@ static void build_nv_range(log_t *log /* log descriptor */,
     nv_range->range_num          = log->trans_hdr.num_ranges;
     nv_range->rec_hdr.rec_num    = log->trans_hdr.rec_hdr.rec_num;
     nv_range->rec_hdr.rec_length = RANGE_SIZE(range);
-    nv_range->chk_sum =
-        chk_sum(range->nvaddr + BYTE_SKEW(nv_range->vmaddr), range->nv.length);
+
+    /* new values are logged from the word containing their first byte */
+    nv_data  = range->nvaddr + BYTE_SKEW(nv_range->vmaddr);
+    data     = range->nvaddr;
+    data_len = RANGE_LEN(range);
+
+    /* compress small new values if it saves at least a word in the log;
+       large ones are read directly from the log by truncation */
+    comp_len = 0;
+    if (compress && dev->comp_ptr != NULL &&
+        nv_range->length >= NV_COMPRESS_MIN &&
+        nv_range->length <= NV_LOCAL_MAX &&
+        dev->comp_ptr + data_len <= dev->comp_buf + dev->comp_buf_len)
+        comp_len = nv_compress(nv_data, nv_range->length,
+                               dev->comp_ptr + sizeof(rvm_length_t),
+                               data_len - 2 * sizeof(rvm_length_t));
+
+    if (comp_len != 0) { /* log length word & compressed data */
+        data                  = dev->comp_ptr;
+        data_len              = ROUND_TO_LENGTH(comp_len);
+        *(rvm_length_t *)data = comp_len;
+        BZERO(data + sizeof(rvm_length_t) + comp_len, data_len - comp_len);
+        data_len += sizeof(rvm_length_t);
+        dev->comp_ptr += data_len;
+        nv_range->rec_hdr.rec_length = NV_RANGE_OVERHEAD + data_len;
+        nv_range->chk_sum            = crc32c(0, data, data_len);
+    } else if (log->comp_log)
+        nv_range->chk_sum = crc32c(0, nv_data, nv_range->length);
+    else /* old log format */
+        nv_range->chk_sum = chk_sum(nv_data, nv_range->length);
     dev->io_length += nv_range->rec_hdr.rec_length; /* accumulate lengths */
     nv_range->sub_rec_len = tid->back_link;
     tid->back_link        = nv_range->rec_hdr.rec_length;
@@ -223,8 +292,8 @@ static void build_nv_range(log_t *log /* log descriptor */,
     assert(dev->iov_cnt <= dev->iov_length);
 
     /* setup io for new values */
-    dev->iov[dev->iov_cnt].iov_base  = range->nvaddr;
-    dev->iov[dev->iov_cnt++].iov_len = RANGE_LEN(range);
+    dev->iov[dev->iov_cnt].iov_base  = data;
+    dev->iov[dev->iov_cnt++].iov_len = data_len;
 
     assert(dev->iov_cnt <= dev->iov_length);
     enter_histogram(nv_range->length, log->status.range_lengths,
@@ -284,15 +353,16 @@ static rvm_bool_t write_range(int_tid_t *tid, range_t *range,
         if (RVM_OFFSET_TO_LENGTH(avail) < MIN_NV_RANGE_SIZE)
             return rvm_true; /* no, wrap around first */
 
-        /* yes, build new descriptor for as much as fits */
+        /* yes, build new descriptor for as much as fits; it must fill
+           the log up to the wrap marker so it is not compressed */
         split_range(range, &tid->split_range,
                     RVM_OFFSET_TO_LENGTH(avail) - NV_RANGE_OVERHEAD);
-        build_nv_range(log, tid, &tid->split_range);
+        build_nv_range(log, tid, &tid->split_range, rvm_false);
         return rvm_true; /* now wrap around */
     }
 
     /* enter nv_range header & new values */
-    build_nv_range(log, tid, range);
+    build_nv_range(log, tid, range, rvm_true);
 
     /* do region's uncommitted transaction accounting */
     if (TID(FLUSH_FLAG))
@@ -317,6 +387,7 @@ static rvm_return_t write_tid(int_tid_t *tid)
     if ((retval = make_iov(log, 2 * (tid->range_tree.n_nodes + 1) + 6)) !=
         RVM_SUCCESS)
         return retval;
+    make_comp_buf(log, tid);
 
     /* see if must wrap before logging tid */
     log_tail_sngl_w(log, &log_free);
@@ -565,13 +636,22 @@ static rvm_return_t flush_log_special(log_t *log)
     return retval;
 }
 
-/* internal log flush */
-rvm_return_t flush_log(log_t *log, rvm_length_t *count /* statistics counter */)
+/* flush queued tid's and sync the log device; if commit_stamp is given
+   and a concurrent flush already synced the tid committed with that stamp
+   the log is left alone, if wait_start is given the time since then is
+   accounted as group commit wait time */
+static rvm_return_t do_flush(log_t *log, rvm_length_t *count,
+                             struct timeval *commit_stamp,
+                             struct timeval *wait_start)
 {
     int_tid_t *tid; /* tid to log */
     rvm_bool_t break_sw; /* break switch for loop termination */
+    rvm_bool_t synced = rvm_false; /* true if tid synced by other flush */
     struct timeval start_time;
     struct timeval end_time;
+    struct timeval last_commit; /* commit stamp of last tid logged */
+    rvm_length_t n_logged  = 0; /* tid's logged by this flush */
+    rvm_length_t n_commits = 0; /* flush mode commits logged */
     long kretval;
     rvm_return_t retval = RVM_SUCCESS;
 
@@ -579,6 +659,14 @@ rvm_return_t flush_log(log_t *log, rvm_length_t *count /* statistics counter */)
     RW_CRITICAL(
         log->flush_lock, w, /* begin flush_lock crit sec */
         {
+            /* see if committing tid was part of an earlier group */
+            if ((commit_stamp != NULL) &&
+                TIME_GEQ(log->synced_commit, *commit_stamp)) {
+                log->n_group_commit++;
+                synced = rvm_true;
+                goto err_exit;
+            }
+
             /* process statistics */
             if (count != NULL)
                 (*count)++;
@@ -613,9 +701,15 @@ rvm_return_t flush_log(log_t *log, rvm_length_t *count /* statistics counter */)
                     break;
 
                 /* flush this tid */
-                break_sw = (rvm_bool_t)TID(FLUSH_MARK);
-                retval   = log_tid(log, tid);
-                if ((retval != RVM_SUCCESS) || break_sw)
+                break_sw    = (rvm_bool_t)TID(FLUSH_MARK);
+                last_commit = tid->commit_stamp;
+                if (TID(FLUSH_FLAG))
+                    n_commits++;
+                retval = log_tid(log, tid);
+                if (retval != RVM_SUCCESS)
+                    break;
+                n_logged++;
+                if (break_sw)
                     break;
             }
 
@@ -624,11 +718,26 @@ rvm_return_t flush_log(log_t *log, rvm_length_t *count /* statistics counter */)
                 if (sync_dev(&log->dev) < 0)
                     retval = RVM_EIO;
             });
-        err_exit:;
+
+            /* all tid's logged so far are now on disk */
+            if ((retval == RVM_SUCCESS) && (n_logged != 0)) {
+                log->synced_commit = last_commit;
+                if (n_commits > 1)
+                    log->n_group_flush++;
+                if (n_commits > log->group_commit_max)
+                    log->group_commit_max = n_commits;
+            }
+        err_exit:
+            if ((wait_start != NULL) &&
+                (gettimeofday(&end_time, (struct timezone *)NULL) == 0)) {
+                end_time = sub_times(&end_time, wait_start);
+                log->group_commit_wait =
+                    add_times(&log->group_commit_wait, &end_time);
+            }
         }); /* end flush_lock crit sec */
 
     /* terminate timing */
-    if (retval == RVM_SUCCESS) {
+    if ((retval == RVM_SUCCESS) && !synced) {
         kretval = gettimeofday(&end_time, (struct timezone *)NULL);
         if (kretval != 0)
             return RVM_EIO;
@@ -643,6 +752,30 @@ rvm_return_t flush_log(log_t *log, rvm_length_t *count /* statistics counter */)
     return retval;
 }
 
+/* internal log flush */
+rvm_return_t flush_log(log_t *log, rvm_length_t *count /* statistics counter */)
+{
+    return do_flush(log, count, NULL, NULL);
+}
+
+/* log flush for a flush mode commit, with group commit the committer
+   first lets other threads reach their commit so that a single log sync
+   covers all of them, and returns right away if its tid was already synced
+   by the flush of another committer */
+rvm_return_t flush_commit(log_t *log, struct timeval *commit_stamp)
+{
+    struct timeval wait_start;
+
+    if (!rvm_group_commit)
+        return flush_log(log, &log->status.n_flush);
+
+    if (gettimeofday(&wait_start, (struct timezone *)NULL) != 0)
+        return RVM_EIO;
+    cthread_yield(); /* allow other commits to queue */
+
+    return do_flush(log, &log->status.n_flush, commit_stamp, &wait_start);
+}
+
 /* exported flush routine */
 rvm_return_t rvm_flush()
 {
@@ -1085,8 +1085,13 @@ range_chk_sum(log_t *log /* log descriptor */,
 
     (*chk_val) = rvm_false;
     nv_chk_sum = nv->chk_sum;
-    nv_length  = nv->length;
-    align_skew = BYTE_SKEW(RVM_OFFSET_TO_LENGTH(nv->offset));
+    if (NV_COMPRESSED(nv)) { /* sum covers length word & padding */
+        nv_length  = nv->rec_hdr.rec_length - NV_RANGE_OVERHEAD;
+        align_skew = 0;
+    } else {
+        nv_length  = nv->length;
+        align_skew = BYTE_SKEW(RVM_OFFSET_TO_LENGTH(nv->offset));
+    }
     log_buf->ptr += sizeof(nv_range_t);
 
     /* do checksum over as many buffer loads as needed */
@@ -1095,8 +1100,13 @@ range_chk_sum(log_t *log /* log descriptor */,
         chk_length = log_buf->r_length - log_buf->ptr - align_skew;
         if (chk_length > nv_length)
             chk_length = nv_length;
-        chk_sum_temp +=
-            chk_sum(&log_buf->buf[log_buf->ptr + align_skew], chk_length);
+        if (log->comp_log)
+            chk_sum_temp =
+                crc32c(chk_sum_temp, &log_buf->buf[log_buf->ptr + align_skew],
+                       chk_length);
+        else
+            chk_sum_temp +=
+                chk_sum(&log_buf->buf[log_buf->ptr + align_skew], chk_length);
         nv_length -= chk_length;
         log_buf->ptr += (chk_length + align_skew);
         if (nv_length == 0)
@@ -1610,6 +1620,9 @@ static rvm_return_t do_nv(log_t *log, nv_range_t *nv)
     seg_dict_t *seg_dict; /* seg_dict for this nv */
     dev_region_t *node; /* change tree node for this nv */
     rvm_length_t aligned_len; /* allocation temp */
+    char *nv_ptr; /* first byte of expanded nv's */
+    char *comp_ptr; /* first byte of compressed nv's */
+    rvm_length_t comp_len; /* length of compressed nv's */
     rvm_offset_t offset; /* monitoring temp */
     rvm_bool_t chk_val; /* checksum result */
     rvm_return_t retval; /* return value */
@@ -1619,7 +1632,7 @@ static rvm_return_t do_nv(log_t *log, nv_range_t *nv)
     assert(nv->rec_hdr.struct_id == nv_range_id); /* not a nv range header */
     assert(TIME_EQL(log_buf->timestamp, nv->rec_hdr.timestamp));
 
-    if (rvm_chk_len != 0) /* do monitoring */
+    if (rvm_chk_len != 0 && !NV_COMPRESSED(nv)) /* do monitoring */
     {
         offset = RVM_ADD_LENGTH_TO_OFFSET(log_buf->offset,
                                           log_buf->ptr + sizeof(nv_range_t));
@@ -1660,9 +1673,33 @@ static rvm_return_t do_nv(log_t *log, nv_range_t *nv)
                ((rvm_length_t)default_log->log_buf.buf +
                 default_log->log_buf.r_length));
 
-        /* basic BCOPY will not change alignment since buffer padded */
-        (void)BCOPY(RVM_ADD_LENGTH_TO_ADDR(nv, sizeof(nv_range_t)),
-                    node->nv_ptr, aligned_len);
+        if (NV_COMPRESSED(nv)) {
+            /* expand compressed data, it is always entirely in buffer */
+            assert(((rvm_length_t)nv + nv->rec_hdr.rec_length) <=
+                   ((rvm_length_t)default_log->log_buf.buf +
+                    default_log->log_buf.r_length));
+            comp_len = *(rvm_length_t *)RVM_ADD_LENGTH_TO_ADDR(
+                nv, NV_RANGE_OVERHEAD);
+            if (comp_len > nv->rec_hdr.rec_length - NV_RANGE_OVERHEAD -
+                               sizeof(rvm_length_t)) {
+                free_dev_region(node);
+                return RVM_ELOG; /* damaged compressed data */
+            }
+            comp_ptr = RVM_ADD_LENGTH_TO_ADDR(nv, NV_RANGE_OVERHEAD +
+                                                      sizeof(rvm_length_t));
+            nv_ptr = node->nv_ptr + BYTE_SKEW(RVM_OFFSET_TO_LENGTH(nv->offset));
+            if (nv_decompress(comp_ptr, comp_len, nv_ptr, nv->length) !=
+                (long)nv->length) {
+                free_dev_region(node);
+                return RVM_ELOG; /* damaged compressed data */
+            }
+            if (rvm_chk_len != 0) /* do monitoring */
+                monitor_vmaddr(nv->vmaddr, nv->length, node->nv_ptr, NULL,
+                               &nv->rec_hdr, "do_nv: data from log");
+        } else
+            /* basic BCOPY will not change alignment since buffer padded */
+            (void)BCOPY(RVM_ADD_LENGTH_TO_ADDR(nv, sizeof(nv_range_t)),
+                        node->nv_ptr, aligned_len);
     } else
         /* no, set offset in log for nv's */
         node->log_offset = RVM_ADD_LENGTH_TO_OFFSET(
@@ -2124,7 +2161,7 @@ disk_merge(log_t *log /* log descriptor */,
         /* write buffer to segment & monitor */
         assert(buf_ptr == log_buf->length);
         rw_length = write_dev(log->cur_seg_dev, &log_buf->offset, log_buf->buf,
-                              log_buf->length, SYNCH);
+                              log_buf->length, NO_SYNCH);
         if (rw_length < 0)
             return RVM_EIO;
         assert(log->trunc_thread == cthread_self());
@@ -2274,7 +2311,7 @@ update_seg(log_t *log /* log descriptor */,
 
         /* update the segment on disk */
         if ((r_length = write_dev(seg_dev, &log_buf->offset, log_buf->buf,
-                                  log_buf->r_length, rvm_true)) < 0) {
+                                  log_buf->r_length, NO_SYNCH)) < 0) {
             retval = RVM_EIO;
             goto err_exit;
         }
@@ -2298,6 +2335,11 @@ update_seg(log_t *log /* log descriptor */,
     assert(seg_dict->mod_tree.n_nodes == 0);
 
 err_exit:
+    /* the buffers were written without sync, force them to the segment
+       once before the log records can be released */
+    if ((retval == RVM_SUCCESS) && (sync_seg_dev(seg_dev) < 0))
+        retval = RVM_EIO;
+
     if (!(log->in_recovery || rvm_utlsw)) /* end segment dev_lock crit sec */
     {
         mutex_unlock(&seg_dict->seg->dev_lock);
@@ -2750,10 +2792,6 @@ void log_daemon(void *arg)
     daemon_state_t state; /* daemon state code */
     rvm_return_t retval __attribute__((unused));
 
-#ifdef RVM_USELWP
-    PRE_Concurrent(1);
-#endif
-
     DO_FOREVER
     {
         /* wait to be awakened by request */
@@ -689,9 +689,14 @@ rvm_return_t read_log_status(log_t *log /* log descriptor */,
         return RVM_ELOG; /* status area damaged */
     if (strcmp(dev_status->version, RVM_VERSION) != 0)
         return RVM_ELOG_VERSION_SKEW;
-    if (strcmp(dev_status->log_version, RVM_LOG_VERSION) != 0)
+    if (strcmp(dev_status->log_version, RVM_LOG_VERSION_COMP) == 0)
+        log->comp_log = rvm_true;
+    else if (strcmp(dev_status->log_version, RVM_LOG_VERSION) == 0)
+        log->comp_log = rvm_false;
+    else
         return RVM_ELOG_VERSION_SKEW;
-    if (strcmp(dev_status->statistics_version, RVM_STATISTICS_VERSION) != 0)
+    if (strcmp(dev_status->statistics_version, RVM_LOG_STATISTICS_VERSION) !=
+        0)
         return RVM_ESTAT_VERSION_SKEW;
 
     /* set log device length to log size at creation */
@@ -741,8 +746,10 @@ rvm_return_t write_log_status(log_t *log, device_t *dev /* optional device */)
     dev_status->struct_id = log_dev_status_id;
     (void)BCOPY((char *)status, &dev_status->status, sizeof(log_status_t));
     (void)strcpy(dev_status->version, RVM_VERSION);
-    (void)strcpy(dev_status->log_version, RVM_LOG_VERSION);
-    (void)strcpy(dev_status->statistics_version, RVM_STATISTICS_VERSION);
+    (void)strcpy(dev_status->log_version,
+                 log->comp_log ? RVM_LOG_VERSION_COMP : RVM_LOG_VERSION);
+    (void)strcpy(dev_status->statistics_version,
+                 RVM_LOG_STATISTICS_VERSION);
 
     /* compute checksum */
     dev_status->chk_sum = 0;
@@ -1055,8 +1062,10 @@ rvm_create_log(rvm_options_t *rvm_options /* ptr to options record */,
         goto err_exit;
     }
 
-    /* complete initialization */
-    retval = init_log_status(log);
+    /* complete initialization, choosing the log's record format */
+    log->comp_log = (rvm_options->flags & RVM_COMPRESS_LOG) ? rvm_true :
+                                                              rvm_false;
+    retval        = init_log_status(log);
 
 err_exit:
     if (log->dev.handle != 0) {
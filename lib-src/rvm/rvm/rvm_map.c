@@ -893,6 +893,41 @@ static rvm_return_t map_data(rvm_options_t *rvm_options, region_t *region)
     return retval;
 }
 
+/* map segment data on demand, the pages of a private file mapping are read
+   from the segment when they are first touched so the cost of mapping does
+   not grow with the size of the region. Truncation writes the committed
+   image to the segment, which is what untouched pages already reflect, and
+   modified pages are private copies that old/new value records are taken
+   from as usual. Devices that cannot be mmapped, such as raw partitions,
+   fall back to reading the whole region. */
+static rvm_return_t map_private(rvm_options_t *rvm_options, region_t *region)
+{
+    seg_t *seg = region->seg;
+    char *addr;
+
+    /* check for pager mapping */
+    if (rvm_options != NULL)
+        if (rvm_options->pager != NULL)
+            return RVM_EPAGER;
+
+    if (seg->dev.type != S_IFCHR) {
+        addr = mmap(region->vmaddr, region->length, PROT_READ | PROT_WRITE,
+                    MAP_FIXED | MAP_PRIVATE, (int)seg->dev.handle,
+                    (off_t)RVM_OFFSET_TO_LENGTH(region->offset));
+        if (addr == region->vmaddr)
+            return RVM_SUCCESS;
+        if (addr != (char *)MAP_FAILED)
+            return RVM_ENOT_MAPPED;
+    }
+
+    /* back the region with anonymous memory and read it in */
+    mmap_anon(addr, region->vmaddr, region->length, PROT_READ | PROT_WRITE);
+    if (addr != region->vmaddr)
+        return RVM_ENO_MEMORY;
+
+    return map_data(rvm_options, region);
+}
+
 /* error exit cleanup */
 static void clean_up(region_t *region, mem_region_t *mem_region)
 {
@@ -926,8 +961,6 @@ rvm_return_t rvm_map(rvm_region_t *rvm_region, rvm_options_t *rvm_options)
     mem_region_t *mem_region = NULL; /* new region's tree node */
     rvm_return_t retval;
     rvm_region_t save_rvm_region;
-    int fd; /* For private mappings */
-    void *addr;
 
     /* preliminary checks & saves */
     if (bad_init())
@@ -965,32 +998,13 @@ rvm_return_t rvm_map(rvm_region_t *rvm_region, rvm_options_t *rvm_options)
         goto err_exit;
 
     /* Do the private map or get the data from the segment */
-    if (rvm_map_private) {
-        fd = open(rvm_region->data_dev, O_RDONLY | O_BINARY);
-        if (fd < 0) {
-            retval = RVM_EIO;
-            goto err_exit;
-        }
-        addr = mmap(rvm_region->vmaddr, rvm_region->length,
-                    PROT_READ | PROT_WRITE, MAP_FIXED | MAP_PRIVATE, fd,
-                    region->offset.low);
-        if (!rvm_region->vmaddr)
-            rvm_region->vmaddr = addr;
-
-        if (addr != rvm_region->vmaddr) {
-            retval = RVM_ENOT_MAPPED;
-            goto err_exit;
-        }
-        if (close(fd)) {
-            retval = RVM_EIO;
-            goto err_exit;
-        }
-    } else {
-        /* get the data from the segment */
-        if ((retval = map_data(rvm_options, region)) != RVM_SUCCESS) {
-            rvm_region->length = 0;
-            goto err_exit;
-        }
+    if (rvm_map_private)
+        retval = map_private(rvm_options, region);
+    else
+        retval = map_data(rvm_options, region);
+    if (retval != RVM_SUCCESS) {
+        rvm_region->length = 0;
+        goto err_exit;
     }
 
     /* complete region tree node and exit*/
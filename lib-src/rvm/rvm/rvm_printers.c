@@ -269,6 +269,24 @@ pr_log_stats(rvm_statistics_t *stats /* ptr top statistics record */,
                   stats->last_flush_time);
     if (err == EOF)
         return RVM_EIO;
+    err = fprintf(out_stream, "  Group commit flushes:           %10ld\n",
+                  stats->n_group_flush);
+    if (err == EOF)
+        return RVM_EIO;
+    err = fprintf(out_stream, "  Commits synced by other flushes:%10ld\n",
+                  stats->n_group_commit);
+    if (err == EOF)
+        return RVM_EIO;
+    err = fprintf(out_stream, "  Largest group commit:           %10ld\n",
+                  stats->group_commit_max);
+    if (err == EOF)
+        return RVM_EIO;
+    len_temp1 = stats->group_commit_wait.tv_sec * 1000 +
+                stats->group_commit_wait.tv_usec / 1000;
+    err = fprintf(out_stream, "  Group commit wait (msec):       %10ld\n\n",
+                  len_temp1);
+    if (err == EOF)
+        return RVM_EIO;
     err = fprintf(out_stream,
                   "  rvm_truncate calls:                        %10ld\n",
                   stats->tot_rvm_truncate);
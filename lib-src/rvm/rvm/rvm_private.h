@@ -57,6 +57,15 @@ Coda are listed in the file CREDITS.
 /* note: Log Version must change if Statistics Version changed */
 #define RVM_LOG_VERSION "RVM Log Version  1.4 Oct 17, 1997 "
 
+/* version of logs created with RVM_COMPRESS_LOG, their new values are
+   CRC32C checked and may be compressed */
+#define RVM_LOG_VERSION_COMP "RVM Log Version  1.5 Oct 18, 2026 "
+
+/* statistics version of the log status area, the statistics kept there
+   have not changed since rvm_statistics_t was extended with counters that
+   are not saved in the log */
+#define RVM_LOG_STATISTICS_VERSION "RVM Statistics Version 1.1 8 Dec 1992"
+
 /* general purpose macros */
 
 /* make sure realloc knows what to do with null ptr */
@@ -590,7 +599,7 @@ typedef struct {
     rvm_length_t length; /* actual modification length */
     rvm_offset_t offset; /* offset of changes in segment */
     char *vmaddr; /* modification vm address */
-    rvm_length_t chk_sum; /* data checksum */
+    rvm_length_t chk_sum; /* data checksum, CRC32C in compressed logs */
     long seg_code; /* segment short name */
     rvm_bool_t is_split; /* is a range split for log wrap */
 } nv_range_t;
@@ -666,6 +675,10 @@ typedef struct {
 
     char *pad_buf; /* padding buffer */
     long pad_buf_len; /* length of current pad buf */
+
+    char *comp_buf; /* compressed new values buffer */
+    rvm_length_t comp_buf_len; /* allocated length of comp_buf */
+    char *comp_ptr; /* comp_buf fill ptr */
 } device_t;
 /* log structure macros */
 
@@ -679,6 +692,15 @@ typedef struct {
 
 #define MIN_NV_RANGE_SIZE (NV_RANGE_OVERHEAD + 64)
 
+/* new values shorter than this are not worth compressing */
+#define NV_COMPRESS_MIN 64
+
+/* compressed new values are logged as their length followed by the
+   compressed data, which always takes less space than the range */
+#define NV_COMPRESSED(nv)       \
+    ((nv)->rec_hdr.rec_length < \
+     NV_RANGE_OVERHEAD + ALIGNED_LEN((nv)->vmaddr, (nv)->length))
+
 #define MIN_TRANS_SIZE \
     (TRANS_SIZE + MIN_NV_RANGE_SIZE + ROUND_TO_LENGTH(sizeof(log_wrap_t)))
 
@@ -936,6 +958,7 @@ typedef struct {
     rec_end_t rec_end; /* i/o end marker for log entry */
     log_wrap_t log_wrap; /* i/o log wrap-around marker */
     log_buf_t log_buf; /* log recovery buffer */
+    rvm_bool_t comp_log; /* log is in compressed format */
     /* end of log_dev_lock protected fields */
 
     RVM_MUTEX tid_list_lock; /* lock for tid list header & links
@@ -950,7 +973,15 @@ typedef struct {
                                     used to add/delete a special entry */
     list_entry_t special_list; /* list of special log entries */
 
-    rw_lock_t flush_lock; /* log flush synchronization */
+    rw_lock_t flush_lock; /* log flush synchronization, protects
+                             following group commit fields: */
+    struct timeval synced_commit; /* commit stamp of last tid synced */
+    rvm_length_t n_group_flush; /* flushes of more than one flush commit */
+    rvm_length_t n_group_commit; /* flush commits synced by other flushes */
+    rvm_length_t group_commit_max; /* most flush commits in one flush */
+    struct timeval group_commit_wait; /* time waited by flush commits */
+    /* end of flush_lock protected fields */
+
     log_daemon_t daemon; /* truncation daemon control */
     RVM_MUTEX truncation_lock; /* truncation synchronization */
     cthread_t trunc_thread;
@@ -1034,6 +1065,7 @@ typedef struct {
     log_t *log; /* back link to log descriptor */
     rvm_offset_t log_size; /* log space required */
     tree_root_t range_tree; /* range tree root */
+    range_t *last_range; /* range last merged into, set_range hint */
     range_t **x_ranges; /* vector of overlapping ranges */
     long x_ranges_alloc; /* allocated length of x_ranges */
     long x_ranges_len; /* current length of x_ranges */
@@ -1128,6 +1160,7 @@ void cur_log_length(log_t *log, rvm_offset_t *length);
 /* [rvm_logflush.c] */
 rvm_return_t queue_special(log_t *log, log_special_t *special);
 rvm_return_t flush_log(log_t *log, rvm_length_t *count);
+rvm_return_t flush_commit(log_t *log, struct timeval *commit_stamp);
 
 /* [rvm_logrecovr.c] */
 rvm_return_t locate_tail(log_t *log);
@@ -1186,8 +1219,28 @@ long read_dev(device_t *dev, rvm_offset_t *offset, char *dest,
 long write_dev(device_t *dev, rvm_offset_t *offset, char *src,
                rvm_length_t length, rvm_bool_t no_sync);
 long sync_dev(device_t *dev);
+long sync_seg_dev(device_t *dev);
 long gather_write_dev(device_t *dev, rvm_offset_t *offset);
 
+/* asynchronous file i/o [rvm_uring.c] */
+typedef enum
+{
+    uring_read = 1100, /* read into the i/o vector */
+    uring_write, /* write the i/o vector */
+    uring_sync /* sync file data */
+} uring_op_t;
+
+rvm_bool_t uring_dev(device_t *dev);
+long uring_rw(device_t *dev, uring_op_t op, rvm_offset_t *offset,
+              struct iovec *iov, long iovcnt);
+
+/* log record compression and checksums [rvm_compress.c] */
+rvm_length_t nv_compress(char *src, rvm_length_t len, char *dest,
+                         rvm_length_t dest_len);
+long nv_decompress(char *src, rvm_length_t len, char *dest,
+                   rvm_length_t dest_len);
+rvm_length_t crc32c(rvm_length_t crc, char *buf, rvm_length_t len);
+
 /* length is optional */
 long set_dev_char(device_t *dev, rvm_offset_t *dev_length);
 
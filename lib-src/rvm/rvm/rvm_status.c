@@ -49,6 +49,12 @@ rvm_length_t rvm_optimizations = 0; /* optimizations switches */
 
 rvm_bool_t rvm_map_private = 0; /* Do we map private or not. */
 
+rvm_bool_t rvm_group_commit = 0; /* Do flush commits share log syncs */
+
+rvm_bool_t rvm_async_io = 0; /* Do file i/o through io_uring */
+
+rvm_bool_t rvm_compress_log = 0; /* Do we compress new values in the log */
+
 /* version strings */
 char rvm_version[RVM_VERSION_MAX]            = { RVM_VERSION };
 char rvm_log_version[RVM_VERSION_MAX]        = { RVM_LOG_VERSION };
@@ -127,6 +133,15 @@ rvm_return_t do_rvm_options(rvm_options_t *rvm_options)
 
         /* set mapping kind */
         rvm_map_private = rvm_options->flags & RVM_MAP_PRIVATE;
+
+        /* set commit kind */
+        rvm_group_commit = rvm_options->flags & RVM_GROUP_COMMIT;
+
+        /* set i/o kind */
+        rvm_async_io = rvm_options->flags & RVM_ASYNC_IO;
+
+        /* set log record kind */
+        rvm_compress_log = rvm_options->flags & RVM_COMPRESS_LOG;
     }
 
     return RVM_SUCCESS;
@@ -240,7 +255,8 @@ rvm_return_t rvm_query(rvm_options_t *rvm_options, rvm_region_t *rvm_region)
     }
 
     /* return non-log options */
-    rvm_options->flags        = rvm_optimizations | rvm_map_private;
+    rvm_options->flags = rvm_optimizations | rvm_map_private |
+                         rvm_group_commit | rvm_async_io | rvm_compress_log;
     rvm_options->max_read_len = rvm_max_read_len;
 
     return retval;
@@ -354,6 +370,12 @@ rvm_return_t rvm_statistics(const char *version,
                     status->tot_truncation_times[i];
             }
         }); /* end dev_lock crit sec */
+    RW_CRITICAL(log->flush_lock, r, { /* begin flush_lock crit sec */
+        rvm_statistics->n_group_flush     = log->n_group_flush;
+        rvm_statistics->n_group_commit    = log->n_group_commit;
+        rvm_statistics->group_commit_max  = log->group_commit_max;
+        rvm_statistics->group_commit_wait = log->group_commit_wait;
+    }); /* end flush_lock crit sec */
     /* get non-status area statistics */
     CRITICAL(log->tid_list_lock,
              rvm_statistics->n_uncommit = log->tid_list.list.length);
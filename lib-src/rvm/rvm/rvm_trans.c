@@ -309,6 +309,39 @@ find_overlap(int_tid_t *tid /* transaction descriptor to search */,
     return rvm_false;
 }
 
+/* grow an existing range at its end to cover the composite new_range;
+   the old value buffer is extended in place, doubling its size when
+   necessary, so a run of adjacent set_ranges does not copy all saved
+   old values to a new buffer each time */
+static rvm_return_t extend_range(range_t *range, range_t *new_range)
+{
+    char *vmaddr; /* first byte not yet covered */
+    char *data; /* reallocated old value buffer */
+    rvm_length_t len; /* length temp */
+
+    assert(RVM_OFFSET_EQL(range->nv.offset, new_range->nv.offset));
+    len = ALIGNED_LEN(range->nv.vmaddr, new_range->nv.length);
+    if (len > range->data_len) {
+        if (len < 2 * range->data_len)
+            len = 2 * range->data_len;
+        if ((data = realloc(range->data, len)) == NULL)
+            return RVM_ENO_MEMORY;
+        range->data     = data;
+        range->data_len = len;
+    }
+
+    /* save old values of the bytes the range grows by */
+    vmaddr = RVM_ADD_LENGTH_TO_ADDR(range->nv.vmaddr, range->nv.length);
+    len    = new_range->nv.length - range->nv.length;
+    BCOPY(vmaddr, range->data + range->nv.length, len);
+
+    range->nv.length  = new_range->nv.length;
+    range->end_offset = new_range->end_offset;
+    free_range(new_range);
+
+    return RVM_SUCCESS;
+}
+
 /* merge new range with existing range(s) */
 static rvm_return_t
 merge_range(int_tid_t *tid, region_t *region,
@@ -329,6 +362,8 @@ merge_range(int_tid_t *tid, region_t *region,
     if (find_overlap(tid, new_range, region_partial_include, &tid->range_elim,
                      &tid->range_overlap, &retval)) {
         /* totally optimized away or error */
+        if (retval == RVM_SUCCESS)
+            tid->last_range = tid->x_ranges[0];
         free_range(new_range);
         return retval;
     }
@@ -344,6 +379,16 @@ merge_range(int_tid_t *tid, region_t *region,
                 return RVM_ENO_MEMORY;
             }
         CRITICAL(region->count_lock, region->n_uncommit++);
+        tid->last_range = new_range;
+    } else if (TID(RESTORE_FLAG) && (tid->x_ranges_len == 1) &&
+               (tid->x_ranges[0]->nv.vmaddr <= new_range->nv.vmaddr)) {
+        /* only extends the end of a single existing range */
+        range = tid->x_ranges[0];
+        if ((retval = extend_range(range, new_range)) != RVM_SUCCESS) {
+            free_range(new_range);
+            return retval;
+        }
+        tid->last_range = range;
     } else {
         /* update vmaddr and allocate new old value buffer */
         range = tid->x_ranges[0];
@@ -352,7 +397,7 @@ merge_range(int_tid_t *tid, region_t *region,
         if (TID(RESTORE_FLAG)) {
             new_range->data_len = RANGE_LEN(new_range);
             new_range->data     = malloc(new_range->data_len);
-            if (range->data == NULL)
+            if (new_range->data == NULL)
                 return RVM_ENO_MEMORY;
         }
         /* otherwise, merge existing old values into new node and put
@@ -412,6 +457,7 @@ merge_range(int_tid_t *tid, region_t *region,
         range->nv.offset  = new_range->nv.offset;
         range->end_offset = new_range->end_offset;
         free_range(new_range);
+        tid->last_range = range;
 
         /* update region uncommitted reference count */
         CRITICAL(region->count_lock,
@@ -421,6 +467,30 @@ merge_range(int_tid_t *tid, region_t *region,
     return RVM_SUCCESS;
 }
 
+/* check if a range is completely covered by the range the previous
+   rvm_set_range merged into; this is common when a transaction keeps
+   modifying the same structure, and saves building a range descriptor
+   and searching the region and range trees */
+static rvm_bool_t in_last_range(int_tid_t *tid, char *dest,
+                                rvm_length_t length)
+{
+    range_t *range = tid->last_range;
+
+    if (!TID(RVM_COALESCE_RANGES) || (range == NULL))
+        return rvm_false;
+
+    assert(range->links.node.struct_id == range_id);
+    if ((dest < range->nv.vmaddr) ||
+        (RVM_ADD_LENGTH_TO_ADDR(dest, length) >
+         RVM_ADD_LENGTH_TO_ADDR(range->nv.vmaddr, range->nv.length)))
+        return rvm_false;
+
+    /* the region cannot be unmapped while it has uncommitted ranges */
+    tid->range_elim++;
+    tid->range_overlap = RVM_ADD_LENGTH_TO_OFFSET(tid->range_overlap, length);
+    return rvm_true;
+}
+
 /* rvm_set_range */
 rvm_return_t rvm_set_range(rvm_tid_t *rvm_tid /* transaction affected */,
                            void *dest /* base vm address of range */,
@@ -443,6 +513,11 @@ rvm_return_t rvm_set_range(rvm_tid_t *rvm_tid /* transaction affected */,
     if ((tid = get_tid(rvm_tid)) == NULL) /* begin tid_lock critical section */
         return RVM_ETID;
 
+    if (in_last_range(tid, dest, length)) {
+        rw_unlock(&tid->tid_lock, w); /* end tid_lock critical section */
+        return RVM_SUCCESS;
+    }
+
     /* lookup and lock region */
     region =
         find_whole_range(dest, length, r); /* begin region_lock crit sect */
@@ -785,6 +860,7 @@ static rvm_return_t queue_tid(int_tid_t *tid /* tid to log */)
     log_t *log = tid->log; /* log descriptor */
     int_tid_t *q_tid; /* ptr to last queued tid */
     rvm_bool_t flush_flag;
+    struct timeval commit_stamp; /* tid may be freed once queued */
     rvm_return_t retval;
 
     /* make sure transaction not too large for log */
@@ -800,6 +876,7 @@ static rvm_return_t queue_tid(int_tid_t *tid /* tid to log */)
         log->flush_list_lock,
         { /* begin flush_list_lock crit sec */
           make_uname(&tid->commit_stamp); /* record commit timestamp */
+          commit_stamp = tid->commit_stamp;
           /* test for transaction coalesce */
           if (TID(RVM_COALESCE_TRANS)) {
               /* see if must initialize coalescing */
@@ -843,7 +920,7 @@ static rvm_return_t queue_tid(int_tid_t *tid /* tid to log */)
 
     /* flush log if commit requires */
     if (flush_flag)
-        retval = flush_log(log, &log->status.n_flush);
+        retval = flush_commit(log, &commit_stamp);
 
     return retval;
 }
@@ -0,0 +1,292 @@
+/* BLURB lgpl
+
+                           Coda File System
+                              Release 8
+
+          Copyright (c) 2026 Carnegie Mellon University
+                  Additional copyrights listed below
+
+This  code  is  distributed "AS IS" without warranty of any kind under
+the  terms of the  GNU  Library General Public Licence  Version 2,  as
+shown in the file LICENSE. The technical and financial contributors to
+Coda are listed in the file CREDITS.
+
+                        Additional copyrights
+                           none currently
+
+#*/
+
+/*
+*
+*                     RVM asynchronous file I/O
+*
+*/
+
+/*
+ * With LWP all threads share a single kernel thread, so a log force or a
+ * segment write that blocks in write() or fsync() stalls every LWP in the
+ * process. When the RVM_ASYNC_IO option is set, file reads, writes and syncs
+ * are instead queued on an io_uring and the calling LWP waits for the
+ * completion in IOMGR_Select, which lets the other LWPs run in the meantime.
+ *
+ * All transfers use explicit offsets and leave the file position alone.
+ * Raw partitions keep using blocking i/o. Without LWP, or without io_uring
+ * support in the headers or the running kernel, uring_dev() always returns
+ * false and rvm_io.c falls back to the blocking system calls.
+ */
+
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <errno.h>
+#include "rvm_private.h"
+
+#if defined(RVM_USELWP) && defined(HAVE_LINUX_IO_URING_H)
+#include <sys/mman.h>
+#include <sys/select.h>
+#include <sys/syscall.h>
+#include <stdint.h>
+#include <linux/io_uring.h>
+#ifdef __NR_io_uring_setup
+#define RVM_URING 1
+#endif
+#endif
+
+extern rvm_bool_t rvm_async_io; /* do file i/o through io_uring */
+
+#ifdef RVM_URING
+
+#define URING_ENTRIES 64 /* submission queue size */
+
+/* a request in flight, completions find it through the user_data field */
+struct uring_req {
+    int done; /* completion has been reaped */
+    int res; /* completion result, bytes or -errno */
+    PROCESS waiter; /* lwp waiting in IOMGR_Select, if any */
+};
+
+static struct {
+    int fd; /* ring file descriptor */
+    int failed; /* setup failed, use blocking i/o */
+    unsigned int inflight; /* submitted but not yet reaped */
+    unsigned int entries; /* submission queue entries */
+
+    /* submission queue */
+    unsigned int *sq_tail;
+    unsigned int *sq_mask;
+    unsigned int *sq_array;
+    struct io_uring_sqe *sqes;
+
+    /* completion queue */
+    unsigned int *cq_head;
+    unsigned int *cq_tail;
+    unsigned int *cq_mask;
+    struct io_uring_cqe *cqes;
+} ring = { -1 };
+
+/* set up the ring on first use */
+static rvm_bool_t uring_init(void)
+{
+    struct io_uring_params p;
+    size_t sq_len, cq_len;
+    char *sq, *cq;
+    void *sqes;
+
+    if (ring.fd >= 0)
+        return rvm_true;
+    if (ring.failed)
+        return rvm_false;
+
+    BZERO(&p, sizeof(p));
+    ring.fd = syscall(__NR_io_uring_setup, URING_ENTRIES, &p);
+    if (ring.fd < 0)
+        goto err;
+
+    sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+    cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+
+    sq   = mmap(NULL, sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+              ring.fd, IORING_OFF_SQ_RING);
+    cq   = mmap(NULL, cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+              ring.fd, IORING_OFF_CQ_RING);
+    sqes = mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe),
+                PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd,
+                IORING_OFF_SQES);
+    if (sq == MAP_FAILED || cq == MAP_FAILED || sqes == MAP_FAILED) {
+        /* the ring is only set up once, leaking the mappings is harmless */
+        close(ring.fd);
+        ring.fd = -1;
+        goto err;
+    }
+
+    ring.entries  = p.sq_entries;
+    ring.sq_tail  = (unsigned int *)(sq + p.sq_off.tail);
+    ring.sq_mask  = (unsigned int *)(sq + p.sq_off.ring_mask);
+    ring.sq_array = (unsigned int *)(sq + p.sq_off.array);
+    ring.sqes     = sqes;
+    ring.cq_head  = (unsigned int *)(cq + p.cq_off.head);
+    ring.cq_tail  = (unsigned int *)(cq + p.cq_off.tail);
+    ring.cq_mask  = (unsigned int *)(cq + p.cq_off.ring_mask);
+    ring.cqes     = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    return rvm_true;
+
+err:
+    ring.failed = 1;
+    return rvm_false;
+}
+
+/* pick up all available completions and wake up their waiters */
+static void uring_reap(void)
+{
+    unsigned int head = *ring.cq_head;
+    struct io_uring_cqe *cqe;
+    struct uring_req *req;
+
+    while (head != __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE)) {
+        cqe       = &ring.cqes[head & *ring.cq_mask];
+        req       = (struct uring_req *)(uintptr_t)cqe->user_data;
+        req->res  = cqe->res;
+        req->done = 1;
+        ring.inflight--;
+        head++;
+
+        /* the waiter may be sleeping on an fd that is no longer readable */
+        if (req->waiter != NULL && req->waiter != LWP_ThisProcess())
+            IOMGR_Cancel(req->waiter);
+    }
+    __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+}
+
+/* submit a single request and wait for it, other lwps run meanwhile */
+static int uring_submit(struct io_uring_sqe *tmpl)
+{
+    struct uring_req req = { 0, 0, NULL };
+    struct io_uring_sqe *sqe;
+    unsigned int tail, idx;
+    fd_set rfds;
+    int ret;
+
+    tail               = *ring.sq_tail;
+    idx                = tail & *ring.sq_mask;
+    sqe                = &ring.sqes[idx];
+    *sqe               = *tmpl;
+    sqe->user_data     = (uintptr_t)&req;
+    ring.sq_array[idx] = idx;
+    __atomic_store_n(ring.sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring.inflight++;
+
+    do
+        ret = syscall(__NR_io_uring_enter, ring.fd, 1, 0, 0, NULL, 0);
+    while (ret < 0 && errno == EINTR);
+    if (ret < 0) {
+        /* not submitted, take the entry back */
+        __atomic_store_n(ring.sq_tail, tail, __ATOMIC_RELEASE);
+        ring.inflight--;
+        return -errno;
+    }
+
+    while (!req.done) {
+        uring_reap();
+        if (req.done)
+            break;
+
+        FD_ZERO(&rfds);
+        FD_SET(ring.fd, &rfds);
+        req.waiter = LWP_ThisProcess();
+        IOMGR_Select(ring.fd + 1, &rfds, NULL, NULL, NULL);
+        req.waiter = NULL;
+    }
+    return req.res;
+}
+
+rvm_bool_t uring_dev(device_t *dev)
+{
+    if (!rvm_async_io || dev->raw_io)
+        return rvm_false;
+
+    /* waiting for completions needs the IOMGR, servers initialize RVM
+       before RPC2 has started it */
+    if (!IOMGR_Running())
+        return rvm_false;
+    if (!uring_init())
+        return rvm_false;
+
+    /* a full ring is unlikely with lwp, just do this one synchronously */
+    return (ring.inflight < ring.entries) ? rvm_true : rvm_false;
+}
+
+long uring_rw(device_t *dev, uring_op_t op, rvm_offset_t *offset,
+              struct iovec *iov, long iovcnt)
+{
+    struct io_uring_sqe sqe;
+    off_t pos   = 0;
+    long retval = 0;
+    int res;
+
+    assert(ring.fd >= 0);
+
+    BZERO(&sqe, sizeof(sqe));
+    sqe.fd = (int)dev->handle;
+
+    if (op == uring_sync) {
+        sqe.opcode = IORING_OP_FSYNC;
+#ifdef HAVE_FDATASYNC
+        sqe.fsync_flags = IORING_FSYNC_DATASYNC;
+#endif
+        res = uring_submit(&sqe);
+        if (res < 0) {
+            errno = -res;
+            return -1;
+        }
+        return 0;
+    }
+
+    assert(offset != NULL);
+    pos        = (off_t)RVM_OFFSET_TO_LENGTH(*offset);
+    sqe.opcode = (op == uring_read) ? IORING_OP_READV : IORING_OP_WRITEV;
+
+    /* transfers may be short, continue where the last one stopped */
+    while (iovcnt > 0) {
+        sqe.off  = pos;
+        sqe.addr = (uintptr_t)iov;
+        sqe.len  = iovcnt;
+
+        res = uring_submit(&sqe);
+        if (res == -EINTR || res == -EAGAIN)
+            continue;
+        if (res < 0) {
+            errno = -res;
+            return -1;
+        }
+        if (res == 0) /* end of file */
+            break;
+
+        retval += res;
+        pos += res;
+        while (iovcnt > 0 && (size_t)res >= iov->iov_len) {
+            res -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char *)iov->iov_base + res;
+            iov->iov_len -= res;
+        }
+    }
+    return retval;
+}
+
+#else /* RVM_URING */
+
+rvm_bool_t uring_dev(device_t *dev)
+{
+    return rvm_false;
+}
+
+long uring_rw(device_t *dev, uring_op_t op, rvm_offset_t *offset,
+              struct iovec *iov, long iovcnt)
+{
+    errno = ENOSYS;
+    return -1;
+}
+
+#endif /* RVM_URING */
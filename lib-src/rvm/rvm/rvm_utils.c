@@ -449,8 +449,11 @@ rvm_return_t dev_init(device_t *dev /* device descriptor */,
     dev->buf_end    = NULL;
     dev->ptr        = NULL;
     RVM_ZERO_OFFSET(dev->sync_offset);
-    dev->pad_buf     = NULL;
-    dev->pad_buf_len = 0;
+    dev->pad_buf      = NULL;
+    dev->pad_buf_len  = 0;
+    dev->comp_buf     = NULL;
+    dev->comp_buf_len = 0;
+    dev->comp_ptr     = NULL;
 
     return RVM_SUCCESS;
 }
@@ -560,9 +563,13 @@ void free_log(log_t *log)
         free((char *)log->dev.iov); /* kill io vector */
     if (log->dev.wrt_buf != NULL) /* kill raw io gather write buffer */
         page_free(log->dev.wrt_buf, log->dev.wrt_buf_len);
-    log->dev.wrt_buf_len = 0;
-    log->dev.name        = NULL;
-    log->dev.iov         = NULL;
+    if (log->dev.comp_buf != NULL) /* kill compressed new values buffer */
+        free(log->dev.comp_buf);
+    log->dev.wrt_buf_len  = 0;
+    log->dev.comp_buf_len = 0;
+    log->dev.name         = NULL;
+    log->dev.iov          = NULL;
+    log->dev.comp_buf     = NULL;
     free_log_buf(log); /* kill recovery buffers */
 
     if (log->seg_dict_vec) {
@@ -612,8 +619,14 @@ log_t *make_log(char *log_dev_name /* device name */,
         log->seg_dict_vec   = NULL;
         log->seg_dict_len   = 0;
         log->in_recovery    = rvm_false;
+        log->comp_log       = rvm_false;
         mutex_init(&log->truncation_lock);
         init_rw_lock(&log->flush_lock);
+        ZERO_TIME(log->synced_commit);
+        log->n_group_flush    = 0;
+        log->n_group_commit   = 0;
+        log->group_commit_max = 0;
+        ZERO_TIME(log->group_commit_wait);
         log_buf->prev_rec_num = 0;
         ZERO_TIME(log_buf->prev_timestamp);
         log_buf->prev_direction = rvm_false;
@@ -735,6 +748,7 @@ int_tid_t *make_tid(rvm_mode_t mode /* transaction begin mode */)
         make_uname(&tid->uname);
         init_rw_lock(&tid->tid_lock);
         init_tree_root(&tid->range_tree);
+        tid->last_range     = NULL;
         tid->x_ranges       = NULL;
         tid->x_ranges_alloc = 0;
         tid->x_ranges_len   = 0;
@@ -97,6 +97,8 @@ static FILE *monitor_out          = NULL; /* output file for monitoring */
 static FILE *monitor_err          = NULL; /* monitor error stream */
 static rvm_length_t chk_alloc_len = 0; /* monitor range vector allocation len */
 static rvm_bool_t monitor_vm; /* true if monitor data is in vm  */
+static rvm_bool_t mods_vm; /* true if show_mods data is in vm */
+static char mods_buf[NV_LOCAL_MAX]; /* expanded compressed new values */
 
 /* peek & poke buffer */
 typedef struct {
@@ -2050,6 +2052,8 @@ static void print_range(FILE *out_stream /* output stream */,
     fprintf(out_stream,
             "    Record length:       %5.1lu   Back link:  %5.1lu\n",
             nv->rec_hdr.rec_length, nv->sub_rec_len);
+    fprintf(out_stream, "    Check sum:      %#10.1lx   Compressed: %5s\n",
+            nv->chk_sum, NV_COMPRESSED(nv) ? "yes" : "no");
 }
 
 /* transaction header printer */
@@ -3056,6 +3060,45 @@ static char *chk_aux_buf(rvm_offset_t *offset /* initial offset in file */,
     }
 }
 
+/* buffer manager for range data printing by show_mods */
+static char *chk_mods(rvm_offset_t *offset /* initial offset in file */,
+                      rvm_length_t length /* printed line width */,
+                      FILE *err_stream /* error output stream */)
+{
+    /* see if data was expanded in vm */
+    if (mods_vm)
+        return (char *)RVM_OFFSET_TO_LENGTH(*offset);
+
+    /* no, get from log */
+    return chk_aux_buf(offset, length, err_stream);
+}
+
+/* expand compressed new values of range into mods_buf */
+static rvm_bool_t expand_mods(nv_range_t *nv /* range header located */,
+                              FILE *err_stream /* error output stream */)
+{
+    rvm_offset_t offset; /* offset of compressed data in log */
+    rvm_length_t data_len; /* length of logged data */
+    rvm_length_t comp_len; /* length of compressed data */
+    char *data_ptr; /* ptr to data from log in aux_buf */
+
+    /* compressed data follows its length */
+    offset = RVM_ADD_LENGTH_TO_OFFSET(log_buf->offset,
+                                      sizeof(nv_range_t) + log_buf->ptr);
+    data_len = nv->rec_hdr.rec_length - NV_RANGE_OVERHEAD;
+    if ((data_ptr = chk_aux_buf(&offset, data_len, err_stream)) == NULL)
+        return rvm_false;
+    comp_len = *(rvm_length_t *)data_ptr;
+    if (comp_len > data_len - sizeof(rvm_length_t) ||
+        nv_decompress(data_ptr + sizeof(rvm_length_t), comp_len, mods_buf,
+                      sizeof(mods_buf)) != (long)nv->length) {
+        fprintf(err_stream, "\n? Compressed new values are damaged\n");
+        return rvm_false;
+    }
+
+    return rvm_true;
+}
+
 /* match modifications in range with command line values */
 static rvm_bool_t
 match_values(nv_range_t *nv /* range header located */,
@@ -3113,7 +3156,7 @@ match_values(nv_range_t *nv /* range header located */,
             scan_ptr = (char *)&temp;
 
         /* make data addressable and do comparison */
-        if ((data_ptr = chk_aux_buf(&cmp_offset, len, err_stream)) == NULL)
+        if ((data_ptr = chk_mods(&cmp_offset, len, err_stream)) == NULL)
             return *err_sw = rvm_true;
         if (memcmp(data_ptr, scan_ptr, len))
             return rvm_false;
@@ -3191,10 +3234,16 @@ static rvm_bool_t show_mods(FILE *out_stream /* output stream */,
             goto exit;
         }
 
-        /* set up offset of data in log */
-        offset = RVM_ADD_LENGTH_TO_OFFSET(log_buf->offset,
-                                          sizeof(nv_range_t) + log_buf->ptr +
-                                              BYTE_SKEW(nv->vmaddr));
+        /* set up offset of data in log, or in vm if compressed */
+        mods_vm = NV_COMPRESSED(nv);
+        if (mods_vm) {
+            if (!expand_mods(nv, err_stream))
+                return rvm_false;
+            offset = RVM_MK_OFFSET(0, (rvm_length_t)mods_buf);
+        } else
+            offset = RVM_ADD_LENGTH_TO_OFFSET(
+                log_buf->offset,
+                sizeof(nv_range_t) + log_buf->ptr + BYTE_SKEW(nv->vmaddr));
         if (!num_all)
             offset = RVM_ADD_LENGTH_TO_OFFSET(
                 offset,
@@ -3226,7 +3275,7 @@ static rvm_bool_t show_mods(FILE *out_stream /* output stream */,
         limit = RVM_ADD_LENGTH_TO_OFFSET(offset, nv->length);
         putc('\n', out_stream);
         return pr_data_range(out_stream, err_stream, 2, LINE_WIDTH, &offset,
-                             &temp, base, num_count, chk_aux_buf, &limit,
+                             &temp, base, num_count, chk_mods, &limit,
                              DATA_END_STR);
     next_sub_rec:;
     }
@@ -0,0 +1,423 @@
+/* BLURB gpl
+
+                           Coda File System
+                              Release 8
+
+          Copyright (c) 2026 Carnegie Mellon University
+                  Additional copyrights listed below
+
+This  code  is  distributed "AS IS" without warranty of any kind under
+the terms of the GNU General Public Licence Version 2, as shown in the
+file  LICENSE.  The  technical and financial  contributors to Coda are
+listed in the file CREDITS.
+
+                        Additional copyrights
+                           none currently
+
+#*/
+
+/*
+ * RVM performance benchmarks
+ *
+ *   rvm_bench [-c count] [-f flags] [dir]
+ *
+ * Measures
+ *
+ *   trans     begin/set_range/end throughput for flush and no_flush
+ *             transactions, for several range sizes and ranges per
+ *             transaction
+ *   truncate  truncation time for increasingly full logs
+ *   map       rvm_map and rvm_unmap time for several segment sizes
+ *   rds       rds_malloc and rds_free rates for several block sizes
+ *
+ * Scratch files are created in dir (default ".") and removed at exit.
+ * count (default 1000) is the number of no_flush transactions and rds
+ * operations per run, flush transactions run a tenth of that. flags are
+ * added to the RVM options, e.g. -f 64 for RVM_COMPRESS_LOG. Transactions
+ * with thousands of ranges are measured by rvm_rangebench.
+ *
+ * Every result is printed on a line of its own as key=value fields,
+ *
+ *   bench=trans mode=flush ranges=1 bytes=256 count=100 sec=0.1 rate=1000.0
+ *
+ * where rate is in operations per second for trans and rds, and in MB per
+ * second for truncate and map. Lines starting with '#' are comments.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/param.h>
+#include <sys/time.h>
+#include <rvm/rvm.h>
+#include <rvm/rvm_segment.h>
+#include <rvm/rds.h>
+
+#define MB (1024 * 1024)
+#define LOG_LEN (64 * MB)
+#define DATA_LEN (8 * MB) /* mapped region for the trans tests */
+#define TRANS_BUDGET (32 * MB) /* most new values logged per trans run */
+#define HEAP_LEN (32 * MB)
+#define STATIC_LEN (64 * 1024)
+
+static const long range_counts[] = { 1, 16 };
+static const long range_sizes[]  = { 16, 256, 4096, 65536 };
+static const long log_fills[]    = { 1, 4, 16, 48 }; /* MB */
+static const long seg_sizes[]    = { 1, 16, 64 }; /* MB */
+static const long block_sizes[]  = { 32, 256, 4096 };
+
+#define NELEM(a) (sizeof(a) / sizeof((a)[0]))
+
+static long count = 1000;
+static char log_file[MAXPATHLEN];
+static char data_file[MAXPATHLEN];
+static char map_file[MAXPATHLEN];
+static char heap_file[MAXPATHLEN];
+static rvm_options_t *options;
+static char *data; /* mapped region of the trans and truncate tests */
+
+static double elapsed(struct timeval *start)
+{
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+    return (now.tv_sec - start->tv_sec) +
+           (now.tv_usec - start->tv_usec) / 1000000.0;
+}
+
+static void check(rvm_return_t ret, const char *what)
+{
+    if (ret != RVM_SUCCESS) {
+        fprintf(stderr, "%s failed: %s\n", what, rvm_return(ret));
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void check_rds(int err, const char *what)
+{
+    if (err != SUCCESS) {
+        if (err > SUCCESS)
+            fprintf(stderr, "%s failed: %s\n", what,
+                    rvm_return((rvm_return_t)err));
+        else
+            fprintf(stderr, "%s failed: %d\n", what, err);
+        exit(EXIT_FAILURE);
+    }
+}
+
+/* create a zero filled file, written out so that mapping it does not
+   measure faults on holes */
+static void make_file(const char *name, long length)
+{
+    static char zeros[64 * 1024];
+    long len;
+    int fd;
+
+    fd = open(name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror(name);
+        exit(EXIT_FAILURE);
+    }
+    for (; length > 0; length -= len) {
+        len = length < sizeof(zeros) ? length : sizeof(zeros);
+        if (write(fd, zeros, len) != len) {
+            perror(name);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (fsync(fd) < 0) {
+        perror(name);
+        exit(EXIT_FAILURE);
+    }
+    close(fd);
+}
+
+static void cleanup(void)
+{
+    unlink(log_file);
+    unlink(data_file);
+    unlink(map_file);
+    unlink(heap_file);
+}
+
+/* commit n transactions of nranges non-adjacent ranges of len bytes */
+static void trans_run(rvm_mode_t mode, long nranges, long len, long n)
+{
+    struct timeval start;
+    rvm_tid_t *tid = rvm_malloc_tid();
+    long slots     = DATA_LEN / (2 * len);
+    long i, j, slot = 0;
+    double secs;
+
+    gettimeofday(&start, NULL);
+    for (i = 0; i < n; i++) {
+        check(rvm_begin_transaction(tid, restore), "rvm_begin_transaction");
+        for (j = 0; j < nranges; j++, slot = (slot + 1) % slots) {
+            check(rvm_set_range(tid, data + slot * 2 * len, len),
+                  "rvm_set_range");
+            memset(data + slot * 2 * len, (int)i, len);
+        }
+        check(rvm_end_transaction(tid, mode), "rvm_end_transaction");
+    }
+    if (mode == no_flush)
+        check(rvm_flush(), "rvm_flush");
+    secs = elapsed(&start);
+    rvm_free_tid(tid);
+
+    printf("bench=trans mode=%s ranges=%ld bytes=%ld count=%ld sec=%.6f "
+           "rate=%.1f\n",
+           mode == flush ? "flush" : "no_flush", nranges, len, n, secs,
+           secs > 0 ? n / secs : 0.0);
+    fflush(stdout);
+
+    /* start the next run with an empty log */
+    check(rvm_truncate(), "rvm_truncate");
+}
+
+static void trans_bench(void)
+{
+    long i, j, n;
+
+    for (i = 0; i < NELEM(range_counts); i++)
+        for (j = 0; j < NELEM(range_sizes); j++) {
+            /* keep the log from filling up */
+            n = TRANS_BUDGET / (range_counts[i] * range_sizes[j]);
+            if (n > count)
+                n = count;
+            trans_run(no_flush, range_counts[i], range_sizes[j], n);
+            trans_run(flush, range_counts[i], range_sizes[j],
+                      n / 10 ? n / 10 : 1);
+        }
+}
+
+/* log fill MB of new values, then truncate */
+static void truncate_bench(void)
+{
+    struct timeval start;
+    rvm_tid_t *tid = rvm_malloc_tid();
+    long len       = 4096;
+    long slots     = DATA_LEN / len;
+    long i, j, n;
+    double secs;
+
+    for (i = 0; i < NELEM(log_fills); i++) {
+        n = log_fills[i] * MB / len;
+        for (j = 0; j < n; j++) {
+            check(rvm_begin_transaction(tid, restore), "rvm_begin_transaction");
+            check(rvm_set_range(tid, data + (j % slots) * len, len),
+                  "rvm_set_range");
+            data[(j % slots) * len]++;
+            check(rvm_end_transaction(tid, no_flush), "rvm_end_transaction");
+
+            /* don't let the flush coalesce updates of the same block */
+            if (j % slots == slots - 1)
+                check(rvm_flush(), "rvm_flush");
+        }
+        check(rvm_flush(), "rvm_flush");
+
+        gettimeofday(&start, NULL);
+        check(rvm_truncate(), "rvm_truncate");
+        secs = elapsed(&start);
+
+        printf("bench=truncate bytes=%ld count=%ld sec=%.6f rate=%.1f\n",
+               log_fills[i] * MB, n, secs,
+               secs > 0 ? log_fills[i] / secs : 0.0);
+        fflush(stdout);
+    }
+    rvm_free_tid(tid);
+}
+
+/* map and unmap segments of increasing size, shared and private */
+static void map_bench(void)
+{
+    struct timeval start;
+    rvm_region_t *region;
+    rvm_length_t flags = options->flags;
+    double map_secs, unmap_secs;
+    int private;
+    long i;
+
+    for (private = 0; private <= 1; private++) {
+        options->flags = private ? flags | RVM_MAP_PRIVATE : flags;
+        check(rvm_set_options(options), "rvm_set_options");
+
+        for (i = 0; i < NELEM(seg_sizes); i++) {
+            make_file(map_file, seg_sizes[i] * MB);
+            region           = rvm_malloc_region();
+            region->data_dev = map_file;
+            region->length   = seg_sizes[i] * MB;
+
+            gettimeofday(&start, NULL);
+            check(rvm_map(region, NULL), "rvm_map");
+            map_secs = elapsed(&start);
+
+            gettimeofday(&start, NULL);
+            check(rvm_unmap(region), "rvm_unmap");
+            unmap_secs = elapsed(&start);
+
+            printf("bench=map private=%d bytes=%ld sec=%.6f rate=%.1f\n",
+                   private, seg_sizes[i] * MB, map_secs,
+                   map_secs > 0 ? seg_sizes[i] / map_secs : 0.0);
+            printf("bench=unmap private=%d bytes=%ld sec=%.6f rate=%.1f\n",
+                   private, seg_sizes[i] * MB, unmap_secs,
+                   unmap_secs > 0 ? seg_sizes[i] / unmap_secs : 0.0);
+            fflush(stdout);
+
+            /* rvm_unmap leaves the region's memory allocated */
+            munmap(region->vmaddr, region->length);
+            rvm_free_region(region);
+        }
+    }
+
+    options->flags = flags;
+    check(rvm_set_options(options), "rvm_set_options");
+}
+
+static void rds_report(const char *op, long size, long n, double secs)
+{
+    printf("bench=rds op=%s bytes=%ld count=%ld sec=%.6f rate=%.1f\n", op,
+           size, n, secs, secs > 0 ? n / secs : 0.0);
+    fflush(stdout);
+}
+
+/* allocate and free blocks, each in its own no_flush transaction */
+static void rds_bench(void)
+{
+    struct timeval start;
+    rvm_offset_t dev_len;
+    rvm_tid_t *tid = rvm_malloc_tid();
+    char **blocks, *heap, *static_addr;
+    long i, j;
+    int err;
+
+    /* find a free address range for the heap */
+    heap = mmap(NULL, HEAP_LEN + STATIC_LEN, PROT_NONE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (heap == MAP_FAILED) {
+        perror("mmap");
+        exit(EXIT_FAILURE);
+    }
+    munmap(heap, HEAP_LEN + STATIC_LEN);
+
+    dev_len = RVM_MK_OFFSET(0, RVM_SEGMENT_HDR_SIZE + HEAP_LEN + STATIC_LEN);
+    make_file(heap_file, RVM_OFFSET_TO_LENGTH(dev_len));
+    rds_zap_heap(heap_file, dev_len, heap, STATIC_LEN, HEAP_LEN, 100, 64,
+                 &err);
+    check_rds(err, "rds_zap_heap");
+    rds_load_heap(heap_file, dev_len, &static_addr, &err);
+    check_rds(err, "rds_load_heap");
+
+    blocks = malloc(count * sizeof(char *));
+    if (blocks == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+
+    for (i = 0; i < NELEM(block_sizes); i++) {
+        gettimeofday(&start, NULL);
+        for (j = 0; j < count; j++) {
+            check(rvm_begin_transaction(tid, restore), "rvm_begin_transaction");
+            blocks[j] = rds_malloc(block_sizes[i], tid, &err);
+            check_rds(err, "rds_malloc");
+            check(rvm_end_transaction(tid, no_flush), "rvm_end_transaction");
+        }
+        rds_report("malloc", block_sizes[i], count, elapsed(&start));
+
+        gettimeofday(&start, NULL);
+        for (j = 0; j < count; j++) {
+            check(rvm_begin_transaction(tid, restore), "rvm_begin_transaction");
+            rds_free(blocks[j], tid, &err);
+            check_rds(err, "rds_free");
+            check(rvm_end_transaction(tid, no_flush), "rvm_end_transaction");
+        }
+        rds_report("free", block_sizes[i], count, elapsed(&start));
+
+        check(rvm_flush(), "rvm_flush");
+        check(rvm_truncate(), "rvm_truncate");
+    }
+
+    /* unmap the heap's regions before rvm_terminate */
+    rds_unload_heap(&err);
+    check_rds(err, "rds_unload_heap");
+
+    free(blocks);
+    rvm_free_tid(tid);
+}
+
+int main(int argc, char **argv)
+{
+    rvm_region_t *region;
+    rvm_offset_t log_len;
+    char *dir;
+    long flags = 0;
+    int c;
+
+    while ((c = getopt(argc, argv, "c:f:")) != -1) {
+        switch (c) {
+        case 'c':
+            count = atol(optarg);
+            break;
+        case 'f':
+            flags = strtol(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-c count] [-f flags] [dir]\n",
+                    argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    /* RVM only recognises the log by its full path name on later calls of
+       rvm_set_options */
+    dir = realpath(optind < argc ? argv[optind] : ".", NULL);
+    if (dir == NULL) {
+        perror(optind < argc ? argv[optind] : ".");
+        exit(EXIT_FAILURE);
+    }
+    if (count <= 0)
+        count = 1;
+
+    snprintf(log_file, sizeof(log_file), "%s/rvm_bench_log", dir);
+    snprintf(data_file, sizeof(data_file), "%s/rvm_bench_data", dir);
+    snprintf(map_file, sizeof(map_file), "%s/rvm_bench_map", dir);
+    snprintf(heap_file, sizeof(heap_file), "%s/rvm_bench_heap", dir);
+    free(dir);
+    cleanup();
+    atexit(cleanup);
+
+    options           = rvm_malloc_options();
+    options->log_dev  = log_file;
+    options->truncate = 0;
+    options->flags |= RVM_ALL_OPTIMIZATIONS | flags;
+
+    check(rvm_initialize(RVM_VERSION, NULL), "rvm_initialize");
+    log_len = RVM_MK_OFFSET(0, LOG_LEN);
+    check(rvm_create_log(options, &log_len, 0644), "rvm_create_log");
+    check(rvm_set_options(options), "rvm_set_options");
+
+    printf("# rvm_bench count=%ld flags=%#lx log=%d\n", count,
+           (long)options->flags, LOG_LEN);
+
+    make_file(data_file, DATA_LEN);
+    region           = rvm_malloc_region();
+    region->data_dev = data_file;
+    region->length   = DATA_LEN;
+    check(rvm_map(region, NULL), "rvm_map");
+    data = region->vmaddr;
+
+    trans_bench();
+    truncate_bench();
+
+    check(rvm_unmap(region), "rvm_unmap");
+    rvm_free_region(region);
+
+    map_bench();
+    rds_bench();
+
+    rvm_free_options(options);
+    check(rvm_terminate(), "rvm_terminate");
+
+    return EXIT_SUCCESS;
+}
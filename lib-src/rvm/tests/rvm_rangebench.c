@@ -0,0 +1,180 @@
+/* BLURB gpl
+
+                           Coda File System
+                              Release 8
+
+          Copyright (c) 2026 Carnegie Mellon University
+                  Additional copyrights listed below
+
+This  code  is  distributed "AS IS" without warranty of any kind under
+the terms of the GNU General Public Licence Version 2, as shown in the
+file  LICENSE.  The  technical and financial  contributors to Coda are
+listed in the file CREDITS.
+
+                        Additional copyrights
+                           none currently
+
+#*/
+
+/*
+ * Range handling micro benchmark
+ *
+ * Measures how many ranges per second rvm_set_range can add to a single
+ * transaction for a few typical access patterns, and how fast the ranges
+ * are merged into the data segment by truncation.
+ *
+ *   rvm_rangebench <logfile> <datafile> [nranges]
+ *
+ * Both files are created (or overwritten).
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <rvm/rvm.h>
+
+#define RANGE_LEN 32 /* bytes per set_range */
+#define HOT_RANGES 16 /* distinct ranges in the repeat test */
+#define HOT_REPEAT 8 /* consecutive updates of the same range */
+#define LOG_LEN (32 * 1024 * 1024)
+
+static char *data; /* mapped region */
+static long nranges = 10000;
+
+static double elapsed(struct timeval *start)
+{
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+    return (now.tv_sec - start->tv_sec) +
+           (now.tv_usec - start->tv_usec) / 1000000.0;
+}
+
+static void report(const char *test, long n, double secs)
+{
+    printf("%-10s %8ld ranges %8.3f sec %12.0f ranges/sec\n", test, n, secs,
+           secs > 0 ? n / secs : 0.0);
+}
+
+static void check(rvm_return_t ret, const char *what)
+{
+    if (ret != RVM_SUCCESS) {
+        fprintf(stderr, "%s failed: %s\n", what, rvm_return(ret));
+        exit(EXIT_FAILURE);
+    }
+}
+
+/* add ranges at the given offsets in a single transaction */
+static void run(const char *test, long *offsets, long n, rvm_bool_t truncate)
+{
+    struct timeval start;
+    rvm_tid_t *tid = rvm_malloc_tid();
+    long i;
+
+    check(rvm_begin_transaction(tid, restore), "rvm_begin_transaction");
+
+    gettimeofday(&start, NULL);
+    for (i = 0; i < n; i++) {
+        check(rvm_set_range(tid, data + offsets[i], RANGE_LEN),
+              "rvm_set_range");
+        data[offsets[i]]++;
+    }
+    report(test, n, elapsed(&start));
+
+    check(rvm_end_transaction(tid, no_flush), "rvm_end_transaction");
+    rvm_free_tid(tid);
+
+    check(rvm_flush(), "rvm_flush");
+    if (truncate) {
+        gettimeofday(&start, NULL);
+        check(rvm_truncate(), "rvm_truncate");
+        report("truncate", n, elapsed(&start));
+    } else
+        check(rvm_truncate(), "rvm_truncate");
+}
+
+int main(int argc, char **argv)
+{
+    rvm_options_t *options;
+    rvm_region_t *region;
+    rvm_offset_t log_len;
+    long *offsets, i, j, tmp, data_len;
+    char *buf;
+    int fd;
+
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s logfile datafile [nranges]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    if (argc > 3)
+        nranges = atol(argv[3]);
+
+    /* one page of slack so the region can be rounded to a page multiple */
+    data_len = nranges * 2 * RANGE_LEN + getpagesize();
+    data_len = (data_len / getpagesize() + 1) * getpagesize();
+
+    fd  = open(argv[2], O_RDWR | O_CREAT | O_TRUNC, 0644);
+    buf = calloc(1, data_len);
+    if (fd < 0 || buf == NULL || write(fd, buf, data_len) != data_len) {
+        perror(argv[2]);
+        exit(EXIT_FAILURE);
+    }
+    close(fd);
+    free(buf);
+
+    options           = rvm_malloc_options();
+    options->log_dev  = argv[1];
+    options->truncate = 0;
+    options->flags |= RVM_ALL_OPTIMIZATIONS;
+
+    unlink(argv[1]);
+    check(rvm_initialize(RVM_VERSION, NULL), "rvm_initialize");
+    log_len = RVM_MK_OFFSET(0, LOG_LEN);
+    check(rvm_create_log(options, &log_len, 0644), "rvm_create_log");
+    check(rvm_set_options(options), "rvm_set_options");
+
+    region           = rvm_malloc_region();
+    region->data_dev = argv[2];
+    region->length   = data_len;
+    check(rvm_map(region, NULL), "rvm_map");
+    data = region->vmaddr;
+
+    offsets = malloc(nranges * sizeof(long));
+    if (offsets == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+
+    /* non-adjacent ranges in random order, every range is a tree node */
+    for (i = 0; i < nranges; i++)
+        offsets[i] = i * 2 * RANGE_LEN;
+    srandom(1);
+    for (i = nranges - 1; i > 0; i--) {
+        j          = random() % (i + 1);
+        tmp        = offsets[i];
+        offsets[i] = offsets[j];
+        offsets[j] = tmp;
+    }
+    run("random", offsets, nranges, rvm_true);
+
+    /* ascending adjacent ranges, merged into a single range */
+    for (i = 0; i < nranges; i++)
+        offsets[i] = i * RANGE_LEN;
+    run("adjacent", offsets, nranges, rvm_true);
+
+    /* a few structures that are each updated several times in a row */
+    for (i = 0; i < nranges; i++)
+        offsets[i] = ((i / HOT_REPEAT) % HOT_RANGES) * 2 * RANGE_LEN;
+    run("repeat", offsets, nranges, rvm_false);
+
+    check(rvm_unmap(region), "rvm_unmap");
+    rvm_free_region(region);
+    rvm_free_options(options);
+    free(offsets);
+    check(rvm_terminate(), "rvm_terminate");
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,231 @@
+#include "gtest/gtest.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <lwp/lwp.h>
+
+#ifdef __cplusplus
+}
+#endif
+
+#include <vector>
+#include <testing/memory.h>
+#include <lka.h>
+
+namespace
+{
+typedef std::vector<unsigned char> bytes;
+
+static const size_t base_len = 2 * DELTA_MINSIZE;
+
+static bytes random_bytes(size_t len, unsigned int seed)
+{
+    bytes b(len);
+
+    srand(seed);
+    for (size_t i = 0; i < len; i++)
+        b[i] = rand();
+    return b;
+}
+
+static int temp_file(const bytes &b)
+{
+    FILE *f = tmpfile();
+    int fd;
+
+    if (!f)
+        return -1;
+    fd = dup(fileno(f));
+    fclose(f);
+    if (!b.empty() && write(fd, &b[0], b.size()) != (ssize_t)b.size()) {
+        close(fd);
+        return -1;
+    }
+    lseek(fd, 0, SEEK_SET);
+    return fd;
+}
+
+static bytes read_file(int fd)
+{
+    bytes b;
+    unsigned char buf[4096];
+    ssize_t r;
+
+    lseek(fd, 0, SEEK_SET);
+    while ((r = read(fd, buf, sizeof(buf))) > 0)
+        b.insert(b.end(), buf, buf + r);
+    return b;
+}
+
+/* Encode newer against base, apply the delta to base and compare. Returns
+   the length of the delta, or 0 when something failed. */
+static size_t round_trip(const bytes &base, const bytes &newer)
+{
+    struct delta_sig *sig;
+    char *delta = NULL;
+    size_t len  = 0;
+    uint64_t length;
+    int basefd, newfd, deltafd, outfd;
+
+    basefd = temp_file(base);
+    newfd  = temp_file(newer);
+    EXPECT_GE(basefd, 0);
+    EXPECT_GE(newfd, 0);
+
+    sig = delta_signature(basefd);
+    EXPECT_TRUE(sig);
+    if (sig) {
+        EXPECT_EQ(delta_encode(sig, newfd, &delta, &len, 2 * newer.size()),
+                  0);
+        delta_free(sig);
+    }
+    if (delta) {
+        deltafd = temp_file(bytes(delta, delta + len));
+        outfd   = temp_file(bytes());
+        EXPECT_EQ(delta_apply(basefd, deltafd, outfd, &length), 0);
+        EXPECT_EQ(length, newer.size());
+        EXPECT_TRUE(read_file(outfd) == newer);
+        close(deltafd);
+        close(outfd);
+        free(delta);
+    }
+    close(basefd);
+    close(newfd);
+    return ::testing::Test::HasFailure() ? 0 : len;
+}
+
+/* the rolling checksum yields, so all of these need the LWP package */
+static void lwp_init()
+{
+    PROCESS main_pid;
+
+    ASSERT_EQ(LWP_Init(LWP_VERSION, LWP_NORMAL_PRIORITY, &main_pid),
+              LWP_SUCCESS);
+}
+
+// delta_encode and delta_apply.
+RVM_TEST(delta, identical)
+{
+    bytes base = random_bytes(base_len, 1);
+
+    lwp_init();
+    EXPECT_LT(round_trip(base, base), base_len / 100);
+    LWP_TerminateProcessSupport();
+}
+
+RVM_TEST(delta, appended)
+{
+    bytes base = random_bytes(base_len, 2), newer = base;
+    bytes tail = random_bytes(10000, 3);
+
+    newer.insert(newer.end(), tail.begin(), tail.end());
+    lwp_init();
+    EXPECT_LT(round_trip(base, newer), base_len / 100 + tail.size());
+    LWP_TerminateProcessSupport();
+}
+
+RVM_TEST(delta, inserted)
+{
+    bytes base = random_bytes(base_len, 4), newer = base;
+    bytes middle = random_bytes(777, 5);
+
+    newer.insert(newer.begin() + base_len / 3, middle.begin(), middle.end());
+    lwp_init();
+    EXPECT_LT(round_trip(base, newer), base_len / 10);
+    LWP_TerminateProcessSupport();
+}
+
+RVM_TEST(delta, truncated)
+{
+    bytes base = random_bytes(base_len, 6);
+    bytes newer(base.begin(), base.begin() + base_len / 2 + 1234);
+
+    lwp_init();
+    EXPECT_LT(round_trip(base, newer), base_len / 10);
+    LWP_TerminateProcessSupport();
+}
+
+RVM_TEST(delta, prefix_dropped)
+{
+    bytes base = random_bytes(base_len, 7);
+    bytes newer(base.begin() + 4321, base.end());
+
+    lwp_init();
+    EXPECT_LT(round_trip(base, newer), base_len / 10);
+    LWP_TerminateProcessSupport();
+}
+
+RVM_TEST(delta, bit_flipped)
+{
+    bytes base = random_bytes(base_len, 8), newer = base;
+
+    newer[base_len / 2] ^= 0x10;
+    lwp_init();
+    EXPECT_LT(round_trip(base, newer), base_len / 10);
+    LWP_TerminateProcessSupport();
+}
+
+RVM_TEST(delta, unrelated)
+{
+    bytes base = random_bytes(base_len, 9);
+    bytes newer = random_bytes(base_len, 10);
+
+    lwp_init();
+    EXPECT_GE(round_trip(base, newer), base_len);
+    LWP_TerminateProcessSupport();
+}
+
+/* every block has the same checksums */
+RVM_TEST(delta, all_zero)
+{
+    bytes base(base_len), newer(base_len + 5000);
+
+    lwp_init();
+    EXPECT_LT(round_trip(base, newer), base_len / 10);
+    LWP_TerminateProcessSupport();
+}
+
+/* the delta is only good for the file it was made against */
+RVM_TEST(delta, modified_base)
+{
+    bytes base = random_bytes(base_len, 11), newer = base;
+    struct delta_sig *sig;
+    char *delta;
+    size_t len;
+    uint64_t length;
+    int basefd, newfd, deltafd, outfd;
+
+    newer[100] ^= 1;
+    lwp_init();
+    basefd = temp_file(base);
+    newfd  = temp_file(newer);
+    sig    = delta_signature(basefd);
+    ASSERT_TRUE(sig);
+    ASSERT_EQ(delta_encode(sig, newfd, &delta, &len, base_len), 0);
+    delta_free(sig);
+    close(basefd);
+
+    base[base_len / 2] ^= 1;
+    basefd  = temp_file(base);
+    deltafd = temp_file(bytes(delta, delta + len));
+    outfd   = temp_file(bytes());
+    EXPECT_EQ(delta_apply(basefd, deltafd, outfd, &length), -1);
+
+    free(delta);
+    close(basefd);
+    close(newfd);
+    close(deltafd);
+    close(outfd);
+    LWP_TerminateProcessSupport();
+}
+
+} // namespace
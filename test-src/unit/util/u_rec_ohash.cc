@@ -0,0 +1,333 @@
+#include "gtest/gtest.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <lwp/lwp.h>
+#include <rvm/rvm.h>
+#include <rvm/rvm_segment.h>
+#include <rvm/rds.h>
+
+#ifdef __cplusplus
+}
+#endif
+
+#include <testing/memory.h>
+#include <util/rec_ohash.h>
+
+namespace
+{
+struct entry {
+    rec_olink link; /* first, so a link is also a pointer to its entry */
+    int key;
+};
+
+static int key_hash(const void *key)
+{
+    return *(const int *)key;
+}
+
+static int entry_hash(rec_olink *l)
+{
+    return key_hash(&((struct entry *)l)->key);
+}
+
+/* the tables and their entries live in plain memory */
+static rec_ohashtab *new_table(int size, RLHFN lhfn)
+{
+    RvmType = VM;
+    return new rec_ohashtab(size, key_hash, lhfn);
+}
+
+static int find(rec_ohashtab *ht, struct entry *e)
+{
+    rec_ohashtab_iterator next(*ht, &e->key);
+    rec_olink *l;
+
+    while ((l = next()))
+        if (l == &e->link)
+            return 1;
+    return 0;
+}
+
+static void remove_all(rec_ohashtab *ht, struct entry *entries, int n)
+{
+    for (int i = 0; i < n; i++)
+        EXPECT_EQ(ht->remove(&entries[i].key, &entries[i].link),
+                  &entries[i].link);
+    EXPECT_EQ(ht->count(), 0);
+}
+
+// rec_ohashtab.
+TEST(rec_ohashtab, grow)
+{
+    const int n           = 5000;
+    rec_ohashtab *ht      = new_table(4, entry_hash);
+    struct entry *entries = new struct entry[n];
+    int i, visited = 0;
+
+    for (i = 0; i < n; i++) {
+        entries[i].key = rand();
+        if (i % 2)
+            ht->insert(&entries[i].key, &entries[i].link);
+        else
+            ht->append(&entries[i].key, &entries[i].link);
+    }
+    EXPECT_EQ(ht->count(), n);
+    EXPECT_GE(ht->buckets(), n / REC_OHASH_LOAD);
+
+    /* Every entry is still in the bucket of its key. */
+    for (i = 0; i < n; i++) {
+        EXPECT_TRUE(find(ht, &entries[i]));
+        EXPECT_TRUE(ht->IsMember(&entries[i].key, &entries[i].link));
+    }
+
+    {
+        rec_ohashtab_iterator next(*ht);
+        while (next())
+            visited++;
+    }
+    EXPECT_EQ(visited, n);
+
+    remove_all(ht, entries, n);
+    delete ht;
+    delete[] entries;
+}
+
+TEST(rec_ohashtab, no_split_while_iterating)
+{
+    const int n           = 1000;
+    rec_ohashtab *ht      = new_table(4, entry_hash);
+    struct entry *entries = new struct entry[n];
+    int i;
+
+    {
+        rec_ohashtab_iterator next(*ht);
+        for (i = 0; i < n - 1; i++) {
+            entries[i].key = i;
+            ht->append(&entries[i].key, &entries[i].link);
+        }
+        EXPECT_EQ(ht->buckets(), 4);
+    }
+
+    /* The next insertion catches up. */
+    entries[i].key = i;
+    ht->append(&entries[i].key, &entries[i].link);
+    EXPECT_EQ(ht->buckets(), 5);
+    for (i = 0; i < n; i++)
+        EXPECT_TRUE(find(ht, &entries[i]));
+
+    remove_all(ht, entries, n);
+    delete ht;
+    delete[] entries;
+}
+
+TEST(rec_ohashtab, fixed_size)
+{
+    const int n           = 1000;
+    rec_ohashtab *ht      = new_table(16, NULL);
+    struct entry *entries = new struct entry[n];
+    int i;
+
+    for (i = 0; i < n; i++) {
+        entries[i].key = rand();
+        ht->append(&entries[i].key, &entries[i].link);
+    }
+    EXPECT_EQ(ht->buckets(), 16);
+    for (i = 0; i < n; i++)
+        EXPECT_TRUE(find(ht, &entries[i]));
+
+    remove_all(ht, entries, n);
+    delete ht;
+    delete[] entries;
+}
+
+/* Tables that live in RVM must log every byte they change, or a restart
+ * brings back whatever was on the data device. Build a table in one process
+ * and let it die without truncating the log, then check that the recovered
+ * table can still grow. */
+static char heap_dev[PATH_MAX];
+static char heap_log[PATH_MAX];
+static const long heap_len   = 1024 * 1024;
+static const long static_len = 64 * 1024;
+static const int rvm_entries = 100;
+static char *const heap      = (char *)0x50000000; /* same as Venus */
+
+static rvm_offset_t heap_dev_len()
+{
+    return RVM_MK_OFFSET(0, RVM_SEGMENT_HDR_SIZE + heap_len + static_len);
+}
+
+static rvm_options_t *log_options()
+{
+    rvm_options_t *options = rvm_malloc_options();
+    options->log_dev       = heap_log;
+    options->truncate      = 0;
+    options->flags |= RVM_ALL_OPTIMIZATIONS;
+    return options;
+}
+
+/* a segment can not be loaded again in the process that zapped it */
+static void zap_rvm_heap()
+{
+    rvm_options_t *options = log_options();
+    rvm_offset_t log_len   = RVM_MK_OFFSET(0, 4 * 1024 * 1024);
+    static char zeros[4096];
+    long len;
+    int fd, err;
+
+    fd = open(heap_dev, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        _exit(1);
+    for (len = RVM_OFFSET_TO_LENGTH(heap_dev_len()); len > 0;
+         len -= sizeof(zeros))
+        if (write(fd, zeros, sizeof(zeros)) != sizeof(zeros))
+            _exit(1);
+    close(fd);
+
+    if (rvm_initialize(RVM_VERSION, NULL) != RVM_SUCCESS ||
+        rvm_create_log(options, &log_len, 0644) != RVM_SUCCESS ||
+        rvm_set_options(options) != RVM_SUCCESS)
+        _exit(1);
+
+    rds_zap_heap(heap_dev, heap_dev_len(), heap, static_len, heap_len, 100,
+                 64, &err);
+    _exit(err == SUCCESS ? 0 : 1);
+}
+
+static void build_rvm_table()
+{
+    const size_t segs_size = 4 * sizeof(rec_olist *);
+    rvm_perthread_t ptd;
+    rvm_return_t ret;
+    rec_ohashtab **root;
+    char *static_addr, *dirty;
+    int err;
+
+    if (rvm_initialize(RVM_VERSION, log_options()) != RVM_SUCCESS)
+        _exit(1);
+    rds_load_heap(heap_dev, heap_dev_len(), &static_addr, &err);
+    if (err != SUCCESS)
+        _exit(1);
+
+    RvmType = UFS;
+    rvmlib_init_threaddata(&ptd);
+
+    /* Leave garbage in the block the segment array of the table gets. The
+     * second block keeps it from being merged back into the free space, and
+     * rds_malloc logs the first two words of a block itself, only the words
+     * after that show whether the table logged what it cleared. */
+    rvmlib_begin_transaction(restore);
+    dirty = (char *)rvmlib_rec_malloc(segs_size);
+    rvmlib_set_range(dirty, segs_size);
+    memset(dirty, 0xff, segs_size);
+    rvmlib_rec_malloc(segs_size);
+    rvmlib_end_transaction(flush, &ret);
+    if (ret != RVM_SUCCESS)
+        _exit(1);
+
+    /* freed blocks only become available once the transaction commits */
+    rvmlib_begin_transaction(restore);
+    rvmlib_rec_free(dirty);
+    rvmlib_end_transaction(flush, &ret);
+    if (ret != RVM_SUCCESS)
+        _exit(1);
+
+    rvmlib_begin_transaction(restore);
+    root = (rec_ohashtab **)static_addr;
+    RVMLIB_REC_OBJECT(*root);
+    *root = new rec_ohashtab(4, key_hash, entry_hash);
+    rvmlib_end_transaction(flush, &ret);
+
+    /* crash, only the log knows about the table */
+    _exit(ret == RVM_SUCCESS ? 0 : 1);
+}
+
+static void run_child(void (*fn)())
+{
+    pid_t child = fork();
+    int status;
+
+    ASSERT_GE(child, 0);
+    if (child == 0)
+        fn();
+    ASSERT_EQ(waitpid(child, &status, 0), child);
+    ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+RVM_TEST(rec_ohashtab, recover)
+{
+    rvm_options_t *options;
+    rvm_perthread_t ptd;
+    rvm_return_t ret;
+    rec_ohashtab *ht;
+    PROCESS main_pid;
+    char *static_addr;
+    int err, i, visited = 0;
+
+    /* RVM tells devices apart by name, so the names must be absolute */
+    ASSERT_TRUE(getcwd(heap_dev, sizeof(heap_dev) - 32));
+    strcpy(heap_log, heap_dev);
+    strcat(heap_dev, "/rec_ohash_test.data");
+    strcat(heap_log, "/rec_ohash_test.log");
+    remove(heap_log);
+    remove(heap_dev);
+    ASSERT_EQ(LWP_Init(LWP_VERSION, LWP_MAX_PRIORITY - 1, &main_pid),
+              LWP_SUCCESS);
+
+    run_child(zap_rvm_heap);
+    run_child(build_rvm_table);
+    if (::testing::Test::HasFatalFailure())
+        return;
+
+    options = log_options();
+    ASSERT_EQ(rvm_initialize(RVM_VERSION, options), RVM_SUCCESS);
+    rds_load_heap(heap_dev, heap_dev_len(), &static_addr, &err);
+    ASSERT_EQ(err, SUCCESS);
+
+    RvmType = UFS;
+    rvmlib_init_threaddata(&ptd);
+
+    ht = *(rec_ohashtab **)static_addr;
+    ASSERT_TRUE(ht);
+    ht->SetHFn(key_hash, entry_hash);
+    EXPECT_EQ(ht->count(), 0);
+
+    /* growing walks the segment array written by the other process */
+    rvmlib_begin_transaction(restore);
+    for (i = 0; i < rvm_entries; i++) {
+        struct entry *e = (struct entry *)rvmlib_rec_malloc(sizeof(*e));
+        RVMLIB_REC_OBJECT(*e);
+        memset(e, 0, sizeof(*e));
+        e->key = i;
+        ht->append(&e->key, &e->link);
+    }
+    rvmlib_end_transaction(flush, &ret);
+    EXPECT_EQ(ret, RVM_SUCCESS);
+    EXPECT_EQ(ht->count(), rvm_entries);
+    EXPECT_GT(ht->buckets(), 8);
+    {
+        rec_ohashtab_iterator next(*ht);
+        rec_olink *l;
+
+        while ((l = next())) {
+            EXPECT_TRUE(find(ht, (struct entry *)l));
+            visited++;
+        }
+    }
+    EXPECT_EQ(visited, rvm_entries);
+
+    rds_unload_heap(&err);
+    EXPECT_EQ(err, SUCCESS);
+    EXPECT_EQ(rvm_terminate(), RVM_SUCCESS);
+    rvm_free_options(options);
+    remove(heap_log);
+    remove(heap_dev);
+    LWP_TerminateProcessSupport();
+}
+
+} // namespace
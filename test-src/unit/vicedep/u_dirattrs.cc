@@ -0,0 +1,101 @@
+#include "gtest/gtest.h"
+
+extern "C" {
+#include <dirattrs.h>
+}
+
+namespace
+{
+const VolumeId repvol = 0x7f000001; /* replicated volume the client uses */
+const VolumeId rwvol  = 0x01000002; /* replica the server translated it to */
+
+static const char *names[] = { "a", "subdir", "a rather longer file name" };
+static const int nnames    = sizeof(names) / sizeof(names[0]);
+
+/* pack the records the way the server does after XlateVid */
+static int pack_dir(char *buf, int len)
+{
+    BUFFER size = {}, buffer = {};
+    int i;
+
+    buffer.who    = RP2_SERVER;
+    buffer.buffer = buf;
+    buffer.eob    = buf + len;
+
+    for (i = 0; i < nnames; i++) {
+        ViceFid fid       = { rwvol, (RPC2_Unsigned)(2 * i + 3), 100u + i };
+        ViceStatus status = {};
+
+        status.Length      = 1000 * i;
+        status.DataVersion = i + 1;
+        EXPECT_EQ(pack_dirattrs(&size, names[i], repvol, &fid, &status), 0);
+        EXPECT_EQ(pack_dirattrs(&buffer, names[i], repvol, &fid, &status), 0);
+    }
+    EXPECT_EQ(buffer.buffer - buf, (intptr_t)size.buffer);
+    return buffer.buffer - buf;
+}
+
+// ViceGetDirAttrs records.
+TEST(dirattrs, replicated_volume)
+{
+    char buf[4096];
+    int len       = pack_dir(buf, sizeof(buf));
+    BUFFER buffer = {};
+    int i;
+
+    buffer.who    = RP2_CLIENT;
+    buffer.buffer = buf;
+    buffer.eob    = buf + len;
+
+    for (i = 0; i < nnames; i++) {
+        RPC2_CountedBS name;
+        ViceFid fid;
+        ViceStatus status;
+
+        ASSERT_EQ(unpack_dirattrs(&buffer, repvol, &name, &fid, &status), 0);
+        EXPECT_STREQ((char *)name.SeqBody, names[i]);
+        EXPECT_EQ(fid.Volume, repvol);
+        EXPECT_EQ(fid.Vnode, (RPC2_Unsigned)(2 * i + 3));
+        EXPECT_EQ(fid.Unique, 100u + i);
+        EXPECT_EQ(status.Length, (RPC2_Unsigned)(1000 * i));
+        EXPECT_EQ(status.DataVersion, (RPC2_Unsigned)(i + 1));
+    }
+    EXPECT_EQ(buffer.buffer, buffer.eob);
+}
+
+TEST(dirattrs, wrong_volume)
+{
+    char buf[4096];
+    int len       = pack_dir(buf, sizeof(buf));
+    BUFFER buffer = {};
+    RPC2_CountedBS name;
+    ViceFid fid;
+    ViceStatus status;
+
+    buffer.who    = RP2_CLIENT;
+    buffer.buffer = buf;
+    buffer.eob    = buf + len;
+
+    EXPECT_NE(unpack_dirattrs(&buffer, rwvol, &name, &fid, &status), 0);
+}
+
+TEST(dirattrs, truncated)
+{
+    char buf[4096];
+    int len       = pack_dir(buf, sizeof(buf));
+    BUFFER buffer = {};
+    RPC2_CountedBS name;
+    ViceFid fid;
+    ViceStatus status;
+    int i;
+
+    buffer.who    = RP2_CLIENT;
+    buffer.buffer = buf;
+    buffer.eob    = buf + len - 1;
+
+    for (i = 0; i < nnames - 1; i++)
+        EXPECT_EQ(unpack_dirattrs(&buffer, repvol, &name, &fid, &status), 0);
+    EXPECT_NE(unpack_dirattrs(&buffer, repvol, &name, &fid, &status), 0);
+}
+
+} // namespace